@@ -4,8 +4,9 @@
 * PROGRAMMERS: Valentyn Novosydliuk and Alexia Tu
 * DESCRIPTION: This project involves developing an inventory management system for a courier company using hash
     * tables and tree data structures. Parcel data, including destination, weight, and valuation, is loaded and
-    * organized into a hash table with 127 buckets. Each bucket contains the root of a binary search tree (BST),
-    * where each node represents a parcel, organized by weight. The program supports user interactions through a
+    * organized into a hash table with one hash node per country, found through an open-addressing index on the
+    * country name. Each hash node contains the root of an AVL balanced binary search tree (BST), where each node
+    * represents a parcel, organized by weight. The program supports user interactions through a
     * menu that allows searching, displaying, and analyzing parcel data by country, weight, and valuation. Proper
     * memory management and error handling are emphasized, with dynamic allocation used for string data.
 */
@@ -14,73 +15,1205 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <limits.h>
+#include <math.h>
+#include <stdarg.h>
+#include <errno.h>
+#include <atomic>
+#include <new>
+#include <chrono>
+#include <thread>
+#ifdef _WIN32
+#include <io.h>
+#include <sys/stat.h>
+#else
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+#ifdef __linux__
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#endif
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define COLUMN_KERNELS_X86 //SSE4.1 and AVX2 versions of the column kernels are compiled in and picked by what the CPU supports
+#endif
 #pragma warning(disable:4996)
 
+//TABLE_SIZE, the row counts and the parcel limits are defaults that -D overrides. --min-rows and the --min/max-weight and price options
+// change the row count and limits again at run time
+#ifndef TABLE_SIZE
 #define TABLE_SIZE 127
+#endif
+#ifndef MAX_FLIGHTS
 #define MAX_FLIGHTS 5000 //for load data
+#endif
+#ifndef MIN_FLIGHTS
 #define MIN_FLIGHTS 2000 //^
+#endif
 #define ERROR 1//return code for load data function
 #define SUCCESS 0//^
 #define VALID_INPUT 1 //used to determine if parse was valid
 #define HIGHER 1 //used to check user input for searching by weight
 #define LOWER 2 //^
+#define BETWEEN 3 //^
+#define COUNT_BETWEEN 4 //^
+#define TOTAL_BETWEEN 5 //^
+#define CHEAPEST_FIRST 1 //used to check user input for the top-K price query
+#define EXPENSIVE_FIRST 2 //^
 #define SEARCH_HIGH 1
 #define SEARCH_LOW 0
+#ifndef MAX_WEIGHT
 #define MAX_WEIGHT 50000
+#endif
+#ifndef MIN_WEIGHT
 #define MIN_WEIGHT 100
+#endif
+#ifndef MIN_PRICE
 #define MIN_PRICE 10
+#endif
+#ifndef MAX_PRICE
 #define MAX_PRICE 2000
+#endif
+#if TABLE_SIZE < 1 || MIN_FLIGHTS > MAX_FLIGHTS || MIN_WEIGHT > MAX_WEIGHT || MIN_PRICE > MAX_PRICE
+#error "TABLE_SIZE must be positive and each minimum at most its maximum"
+#endif
+#define MAX_DESTINATION 64 //longest country name the loaders will accept
+#define NO_ROW_CAP 0 //--max-rows 0 loads every row in the file
+#define FIRST_SLAB_SIZE 1024 //arenas start small so countries with few parcels stay cheap
+#define MAX_SLAB_SIZE (1024 * 1024) //and double up to this size
+#define ARENA_ALIGNMENT 8
+#define FREE_LIST_CLASSES 8 //arenaFree() keeps blocks of up to 8 * ARENA_ALIGNMENT bytes for reuse, one list per size
+#define NO_COUNTRY -1 //country ID for a name that isn't in the dictionary
+#define FIRST_INDEX_SLOTS 16 //the country index starts this small and doubles as countries are added
+#define MAX_LOAD_PERCENT 70 //the country index grows before more than 70% of its slots are in use
+#define INDEX_BENCH_LOOKUPS 1000000 //country lookups timed by --bench-index and --bench-tables
+#define TABLE_RUNTIME 0 //BucketTable size for a table that is given its bucket count when it is opened
+#define RUNTIME_LIMITS nullptr //^ limits for a table that is given its limits when it is opened
+#define MASKED_TABLE_SIZE 128 //the power of two --bench-tables compares TABLE_SIZE's modulo against
+#define REGIONAL_MAX_WEIGHT 20000 //heaviest parcel the narrower limits --bench-tables checks the runtime table with accept
+#define MAX_TREE_HEIGHT 64 //an AVL tree this tall would need more parcels than memory can hold, so it sizes the insert path stack
+#define CURSOR_IN_ORDER 0 //a TreeCursor that walks from the lowest key up
+#define CURSOR_REVERSE 1 //^ from the highest key down
+#define CURSOR_PRE_ORDER 2 //^ each node before its subtrees, for walks that don't care about order
+#define ENGINE_TREE 0 //--engine tree: the queries walk each country's AVL tree
+#define ENGINE_COLUMNS 1 //--engine columns: the queries scan the weight sorted column store
+#define RANGE_BENCH_QUERIES 20000 //weight range queries timed by --bench-range
+#define OUTPUT_BUFFER_SIZE (1 << 16) //parcel rows are formatted into a buffer this big and written out when it fills
+#define MAX_ROW_LENGTH (MAX_DESTINATION + 64) //longest parcel row the formatter can write
+#define OUTPUT_BENCH_PARCELS 2000000 //--bench-output formats about this many rows per format
+#define MAX_READERS 64 //threads that can read the table at once while --follow is running, each one has its own slot
+#define MAIN_READER 0 //reader slot of the thread running the menu or the batch
+#define FOLLOW_READ_SIZE (1 << 16) //--follow reads new lines this many bytes at a time and publishes a view after each read
+#define FOLLOW_POLL_MS 2 //how long --follow waits before looking again when nothing new has been written
+#define FOLLOW_BENCH_ROWS 200000 //rows --bench-follow appends while it times queries
+#define FOLLOW_BENCH_BURST 500 //rows it appends at a time, with a millisecond between bursts
+#define FOLLOW_BENCH_QUERIES 50000 //queries it times before it starts appending
+#define READER_BENCH_THREADS 32 //--bench-readers doubles the query threads from 1 up to this
+#define READER_BENCH_MS 250 //how long it runs each number of threads
+#define WRITER_BENCH_BURST 100 //parcels its writer adds per published view, one view a millisecond
+#define RANGE_SAMPLE 16 //parcels its weight range queries copy out
+#define UPDATE_VALUATION 1 //used to check user input for changing a parcel
+#define UPDATE_WEIGHT 2 //^
+#define CHURN_BENCH_HOURS 24 //simulated hours --bench-churn runs
+#define CHURN_BENCH_OPERATIONS 100000 //new parcels, deliveries and updates in each simulated hour
+#define DEGENERATE_TREE_NODES 1000000 //nodes in the one sided trees --bench-traversal checks the walks on
+#define TRAVERSAL_BENCH_VISITS 20000000 //--bench-traversal repeats each walk over the table until about this many nodes have been visited
+#define MAX_BATCH_LINE 256 //longest query line --batch reads, longer lines are reported as errors
+#define KERNEL_BENCH_ROWS 200000000 //--bench-kernels runs each kernel over the whole column store until about this many rows have gone through it
+#define KERNEL_SCALAR 0 //ColumnKernels levels, each needs what the one before it does
+#define KERNEL_SSE41 1
+#define KERNEL_AVX2 2
+#define TOTALS_BLOCK_ROWS (1 << 20) //rows --verify-totals generates and sums at a time
+#define REPORT_BENCH_ROUNDS 20 //times --bench-report builds the report of every destination each way
+#define SERVER_LIST 1 //ServerRequest kinds: every parcel of the country
+#define SERVER_ABOVE 2 //^ parcels heavier than first
+#define SERVER_BELOW 3 //^ parcels lighter than first
+#define SERVER_RANGE 4 //^ parcels from first to second grams
+#define SERVER_COUNT 5 //^ how many parcels are from first to second grams
+#define SERVER_TOTAL 6 //^ count, load and valuation of the parcels from first to second grams, INT_MIN and INT_MAX for the whole country
+#define SERVER_PRICES 7 //^ cheapest and most expensive parcel
+#define SERVER_EXTREMES 8 //^ lightest and heaviest parcel
+#define SERVER_OK 0 //ServerReply status: the query ran
+#define SERVER_NO_PARCELS 1 //^ the country has no parcels
+#define SERVER_BAD_REQUEST 2 //^ unknown kind or a name longer than MAX_DESTINATION, the server closes the connection after a bad name
+#define SERVER_EVENTS 64 //connections --serve handles per epoll_wait() call
+#define SERVER_POLL_MS 100 //longest it waits in epoll_wait() before checking whether it was told to stop
+#define SERVER_READ_SIZE (1 << 16) //a connection's buffers start this big and double when a request or reply doesn't fit
+#define SERVER_MAX_PENDING (1 << 20) //a connection stops being read while it has more reply bytes than this waiting to be sent
+#define SERVER_BENCH_CLIENTS 8 //connections --bench-server opens, unless --clients says otherwise
+#define SERVER_BENCH_PIPELINE 32 //^ requests each keeps in flight, --pipeline
+#define SERVER_BENCH_SECONDS 2 //how long it sends requests for
+#define SNAPSHOT_MAGIC "PARCELS" //first 8 bytes of a snapshot file, with the terminating 0
+#define SNAPSHOT_VERSION 4 //bump whenever the snapshot layout changes
+#define ENGINE_BENCH_PARCELS 4000000 //--bench-engines repeats the queries until about this many parcels have been visited
+#define SUITE_ROWS 1000000 //rows in the manifest --bench-suite generates, unless --suite-rows says otherwise
+#define SUITE_COUNTRIES 200 //^ destinations, --suite-countries
+#define SUITE_SKEW 1.0 //^ Zipf exponent of the destinations, --suite-skew, 0 for uniform
+#define SUITE_RUNS 5 //times it loads, queries and cleans up the manifest
+#define SUITE_QUERIES 200 //calls of each menu query per run
+#define SUITE_PHASES 7 //load, the five menu queries and cleanup
+// printf() format and arguments that print an amount in cents as dollars and cents, printf("$" CENTS "\n", DOLLARS(cents))
+#define CENTS "%s%lld.%02lld"
+#define DOLLARS(cents) ((cents) < 0) ? "-" : "", llabs((long long)(cents)) / 100, llabs((long long)(cents)) % 100
+#ifdef _WIN32
+#define NULL_DEVICE "NUL"
+#else
+#define NULL_DEVICE "/dev/null"
+#endif
+// every heap call goes through countedMalloc(), countedCalloc() or countedRealloc(). a -DPARCEL_STATS build counts them, and operator new,
+// for --bench-suite. without it they are the plain functions and the suite doesn't report allocations
+#ifdef PARCEL_STATS
+#define COUNT_ALLOCATION(size) countAllocation(size)
+#else
+#define COUNT_ALLOCATION(size)
+#endif
+// building with -DPARCEL_STATS times the hot paths and the query entry points and counts the tree nodes they visit. without it the
+// macros below are empty and none of the instrumentation is compiled
+#ifdef PARCEL_STATS
+#define HISTOGRAM_SUB_BITS 4 //a histogram splits each power of two into 16 buckets, so a value is recorded to within 1/16 of itself
+#define HISTOGRAM_BUCKETS (64 << HISTOGRAM_SUB_BITS)
+#define MAX_DEPTH_COUNTRIES 4096 //countries whose deepest insert is tracked, higher IDs share the last slot
+#define PROBE_COMPUTE_HASH 0
+#define PROBE_HASH_NAME 1
+#define PROBE_CREATE_PARCEL 2
+#define PROBE_INSERT 3
+#define PROBE_BY_COUNTRY 4
+#define PROBE_BY_WEIGHT 5
+#define PROBE_WEIGHT_RANGE 6
+#define PROBE_TOTALS 7
+#define PROBE_RANGE_TOTALS 8
+#define PROBE_PRICE_EXTREMES 9
+#define PROBE_WEIGHT_EXTREMES 10
+#define PROBE_TOP_PRICES 11
+#define PROBE_PRICE_RANGE 12
+#define PROBE_BATCH_QUERY 13
+#define PROBE_QUERY_TOTALS 14
+#define PROBE_QUERY_WEIGHT_EXTREMES 15
+#define PROBE_QUERY_PRICE_EXTREMES 16
+#define PROBE_QUERY_WEIGHT_RANGE 17
+#define PROBE_SERVE_REQUEST 18
+#define PROBE_COUNT 19
+#define PROBE(probe) ProbeScope probeScope(probe)
+#define COUNT_VISITS(count) (nodesVisited += (count))
+#define RECORD_DEPTH(countryId, depth) recordDepth(countryId, depth)
+#else
+#define PROBE(probe)
+#define COUNT_VISITS(count)
+#define RECORD_DEPTH(countryId, depth)
+#endif
 
-/* Each parcel will have a link to another node in the tree and 3 variables inside */
+/* Each parcel will have a link to another node in the tree and 3 variables inside, the destination is an ID in the country dictionary */
 typedef struct Parcel {
-    char* destination;
+    int countryId;
     int weight;
-    float valuation;
+    int valuation; //in cents
 } Parcel;
 
-/* Tree node */
+/* Count, sums and price extremes of a set of parcels, every tree node keeps one for itself and everything below it */
+typedef struct ParcelTotals {
+    int count;
+    long long weight;
+    long long valuation; //in cents, so sums are exact in any order
+    int minValuation; //INT_MAX while count is 0
+    int maxValuation; //INT_MIN while count is 0
+} ParcelTotals;
+
+/* Tree node, kept AVL balanced */
 typedef struct BSTNode {
     Parcel* parcel;
     struct BSTNode* left;
     struct BSTNode* right;
+    int height; //1 for a leaf
+    int weight; //copy of parcel->weight, so walking the tree never has to load the parcel
+    ParcelTotals subtree; //the node and both its subtrees
 } BSTNode;
 
-/* Hash node that will be used to store 127 roots to point to 127 BSTs */
+/* Position inside a weight tree or a valuation index, used by every walk over a whole tree or a range of it so none of them recurse. the
+   stack holds the nodes still to be visited, which for an AVL tree is never more than its height and fits in local. a tree of any other
+   shape moves the stack to the heap as it grows, so a cursor has to be closed with closeTreeCursor() */
+template <typename Node> struct TreeCursor {
+    Node** stack; //local until the walk needs more than MAX_TREE_HEIGHT
+    int depth;
+    int capacity;
+    int order; //CURSOR_IN_ORDER, CURSOR_REVERSE or CURSOR_PRE_ORDER
+    double maxKey; //an in-order cursor ends at the first node with a higher weight or valuation than this
+    Node* local[MAX_TREE_HEIGHT];
+};
+typedef TreeCursor<BSTNode> WeightCursor;
+
+/* One contiguous block of an arena, the allocations follow the header */
+typedef struct Slab {
+    struct Slab* next;
+    size_t used;
+    size_t capacity;
+} Slab;
+
+/* Bump allocator that every parcel and node of one country comes from */
+typedef struct Arena {
+    Slab* slabs; //newest slab first, it is the only one still being filled
+    size_t bytesReserved;
+    size_t bytesUsed;
+    void* freeBlocks[FREE_LIST_CLASSES]; //blocks given back with arenaFree() by size, each one holds a pointer to the next
+} Arena;
+
+/* Interned country names, each distinct destination is stored once and parcels refer to it by ID. the names are found through an
+   open-addressing index keyed on the full name, which doubles whenever it gets too full */
+typedef struct CountryDictionary {
+    const char** names; //indexed by country ID
+    int* lengths;
+    unsigned long long* hashes; //full hash of each name, so probes rarely compare strings and growing doesn't rehash
+    int* slots; //country ID held by each slot of the index, NO_COUNTRY if the slot is empty
+    int slotCount; //always a power of two
+    int count;
+    int capacity;
+    Arena text; //the name strings
+} CountryDictionary;
+
+/* A parcel and its place in weight order, sorted by valuation to build a valuation index */
+typedef struct PricedParcel {
+    Parcel* parcel;
+    int order;
+} PricedParcel;
+
+/* Node of a country's valuation index, a second AVL tree over the same parcels ordered by valuation */
+typedef struct PriceNode {
+    Parcel* parcel;
+    struct PriceNode* left;
+    struct PriceNode* right;
+    int height; //1 for a leaf
+    int valuation; //copy of parcel->valuation
+} PriceNode;
+typedef TreeCursor<PriceNode> PriceCursor;
+
+/* Hash node that holds one country's parcels: the root of its BST, the priceRoot of its valuation index and the arena their nodes come from */
 typedef struct HashNode {
     BSTNode* root;
+    PriceNode* priceRoot; //the same parcels as root ordered by valuation, NULL until buildPriceIndex() is first called
+    Arena arena;
 } HashNode;
 
+/* Hash table of parcels, one hash node per country ID in the country dictionary */
+typedef struct HashTable {
+    HashNode* nodes;
+    int capacity;
+} HashTable;
+
+/* The weights and valuations a table accepts parcels within. courierLimits are the compiled in ones, parcelLimits the ones the loaders
+   check after the limit options */
+typedef struct ParcelLimits {
+    int minWeight;
+    int maxWeight;
+    int minValuation; //in cents
+    int maxValuation; //^
+} ParcelLimits;
+constexpr ParcelLimits courierLimits = { MIN_WEIGHT, MAX_WEIGHT, MIN_PRICE * 100, MAX_PRICE * 100 };
+
+/* One key's parcels in a BucketTable, chained off its bucket */
+template <typename Key> struct BucketEntry {
+    Key key;
+    HashNode node; //the key's tree and the arena its parcels and nodes come from
+    BucketEntry* next;
+};
+
+/* Hash table and parcel store in one, with the bucket count, key type and limits fixed when it is compiled so a deployment can pick its own
+   without changing the code. Buckets that are a power of two are masked, any other count is reduced with %. TABLE_RUNTIME buckets or
+   RUNTIME_LIMITS are instead given to openBucketTable() and kept in the table. Key is a country name, which the table doesn't copy, or a country ID */
+template <typename Key, int Buckets, const ParcelLimits* Limits> struct BucketTable {
+    static_assert(Buckets >= 0, "a bucket table needs a bucket count, or TABLE_RUNTIME");
+    typedef Key KeyType;
+    BucketEntry<Key>** buckets;
+    int bucketCount; //Buckets, or what the table was opened with
+    unsigned int mask; //bucketCount - 1 if that is a power of two, 0 to use %
+    ParcelLimits limits; //only used when Limits is RUNTIME_LIMITS
+    int keys;
+    int parcels;
+    int rejected; //parcels outside the limits
+    Arena entries; //the BucketEntry chains
+};
+
+/* Read-only parcel storage in structure-of-arrays form. the parcels are grouped by country ID and sorted by weight within each country,
+   so a country's parcels are one contiguous range of every column and range scans and totals just stream through memory */
+typedef struct ColumnStore {
+    int* weights;
+    int* valuations; //in cents
+    int* countryIds;
+    int* offsets; //country ID's parcels are rows offsets[id] up to offsets[id + 1], countryCount + 1 entries
+    int* priceOrder; //the same rows of each country again, sorted by valuation
+    int countryCount;
+    int parcelCount;
+    int isMapped; //1 if the columns point into a snapshot image, which owns them
+} ColumnStore;
+
+/* One version of the loops that scan the column store, see selectColumnKernels(). every version gives exactly the same answers */
+typedef struct ColumnKernels {
+    const char* name;
+    int level; //KERNEL_ constant of the instructions it needs
+    void (*sum)(const int* weights, const int* valuations, int count, ParcelTotals* totals); //adds count rows to totals
+    void (*extremes)(const int* valuations, int count, int* cheapest, int* priciest); //first lowest and last highest valuation
+    int (*filter)(const int* valuations, int count, int minValuation, int maxValuation, unsigned long long* bitmap); //bit per row in range
+} ColumnKernels;
+
+/* A row and its valuation, sorted by valuation to build the price order of a country */
+typedef struct PricedRow {
+    int valuation;
+    int row;
+} PricedRow;
+
+/* Start of a snapshot file. the sections follow in this order, each padded to 8 bytes: the country names (each with its 0), offsets,
+   weights, valuations, country IDs and price order. numbers are in the machine's own byte order */
+typedef struct SnapshotHeader {
+    char magic[8];
+    unsigned int version;
+    unsigned int headerSize;
+    unsigned long long checksum; //of everything after the header
+    long long sourceSize; //size and modification time of the text file the snapshot was made from, the time in nanoseconds
+    long long sourceModified;
+    int maxRows; //the --max-rows it was loaded with
+    ParcelLimits limits; //the limits its rows were checked against
+    int countryCount;
+    int parcelCount;
+    int namesSize; //bytes of country names, before padding
+} SnapshotHeader;
+
+/* Whole input file, either memory-mapped or read into one buffer */
+typedef struct MappedFile {
+    const char* data;
+    size_t size;
+    int isMapped; //1 if data came from mmap, 0 if it was read into a malloc'd buffer
+} MappedFile;
+
+/* One row of the manifest as found by the scanner, destination points straight into the file */
+typedef struct ParsedRecord {
+    const char* destination;
+    int destinationLength;
+    int countryId; //set by the parallel loader once the destination is interned
+    int weight;
+    int valuation; //in cents
+} ParsedRecord;
+
+/* Throughput numbers reported after a load */
+typedef struct LoadStats {
+    int rowsLoaded;
+    int rowsSkipped; //malformed lines or weight/valuation out of range
+    size_t bytesRead;
+    double seconds;
+} LoadStats;
+
+/* Command line options */
+typedef struct Options {
+    const char* filename;
+    int maxRows; //row cap for the loaders, NO_ROW_CAP for unlimited
+    int useScanfLoader; //1 to use the original fscanf loader for comparison
+    int threads; //loader threads, 1 for the serial loader
+    int verifyLoad; //1 to check the parallel loader against the serial one and exit
+    int memoryReport; //1 to print bytes per parcel after loading
+    int diagnostics; //1 to print the shape of every country's tree and of the old 127 bucket table after loading
+    int benchIndex; //1 to benchmark the country index against the old 127 bucket table and exit
+    int benchBalanceRows; //parcels per input order for --bench-balance, 0 if it wasn't asked for
+    int verifyTotalsRows; //synthetic parcels for --verify-totals to add up, 0 if it wasn't asked for
+    int engine; //ENGINE_TREE or ENGINE_COLUMNS, the storage the menu queries run against
+    int benchEngines; //1 to time the queries on both engines and exit
+    int benchKernels; //1 to time every column kernel the CPU supports against the scalar ones and exit
+    int benchRange; //1 to time weight range counts against a full tree walk and exit
+    int priceIndex; //1 to build every country's valuation index right after loading
+    const char* snapshotPath; //--snapshot file to restart from, NULL if it wasn't asked for
+    const char* batchPath; //--batch query file, "-" for stdin, NULL to run the menu
+    const char* recordsPath; //--records file the parcels go to as binary ParcelRecords instead of being printed, NULL to print them
+    int benchOutput; //1 to time formatting parcel rows with printf, the output buffer and binary records and exit
+    const char* followPath; //--follow file or named pipe new parcel lines are read from while the queries run, NULL if not following
+    int benchFollow; //1 to time ingest lag and query latency while rows are appended to a scratch file and exit
+    int benchReaders; //1 to time the thread-safe queries on 1 to READER_BENCH_THREADS threads while a writer adds parcels and exit
+    int benchChurn; //1 to time new parcels, deliveries and updates over simulated hours of traffic and exit
+    int benchTraversal; //1 to check the tree walks on one sided trees, time them against the recursive ones and exit
+    int benchTables; //1 to time the bucket table specializations against the country index and exit
+    int tableSize; //buckets in the --bench-tables table sized at run time, --table-size
+    int reportAll; //1 to print the totals, weights and prices of every destination after loading
+    int benchReport; //1 to time the report against the per-country functions called for every destination and exit
+    const char* serverPath; //--serve socket the queries are answered on instead of running the menu, NULL if not serving
+    const char* benchServerPath; //--bench-server socket of a running server to send requests to and time, NULL if not asked for
+    int serverClients; //connections and requests in flight on each for --bench-server
+    int serverPipeline; //^
+    int benchSuite; //1 to generate a synthetic manifest, time loading, the five menu queries and cleanup on it and exit
+    int suiteRows; //rows, destinations, Zipf skew and weight order of the --bench-suite manifest
+    int suiteCountries; //^
+    double suiteSkew; //^
+    int suiteSorted; //^ 1 for weights in ascending order, 0 for random
+    ParcelLimits limits; //courierLimits changed by --min-weight, --max-weight, --min-price and --max-price
+    int minRows; //fewest valid rows a manifest can have, --min-rows
+} Options;
+
+/* Rows one loader thread found for one country, kept in file order */
+typedef struct ParcelRun {
+    ParsedRecord* records; //destinations still point into the mapped file
+    int* rows; //row number of each record within its chunk, used to apply the row cap after parsing
+    int count;
+    int capacity;
+} ParcelRun;
+
+/* The slice of the file one loader thread parses, and what it found there */
+typedef struct LoadChunk {
+    const char* start;
+    const char* end;
+    int maxRows;
+    int rowsLoaded;
+    int rowsSkipped;
+    int rowsKept; //how many of rowsLoaded are still under the row cap once earlier chunks are counted
+    size_t bytesParsed;
+    CountryDictionary countries; //the chunk's own dictionary, so the threads don't share one while parsing
+    int* firstRows; //row each of the chunk's countries first appeared on
+    int* localIds; //global country IDs mapped back to the chunk's, NO_COUNTRY if the chunk didn't see the country
+    ParcelRun* runs; //indexed by the chunk's country IDs
+    int runCapacity;
+} LoadChunk;
+
+/* Parcel rows waiting to be written. text rows go to stdout, --records rows to the records file */
+typedef struct OutputBuffer {
+    char* data;
+    size_t used;
+    size_t capacity;
+    FILE* file; //NULL if this buffer isn't in use
+} OutputBuffer;
+
+/* One parcel in a --records file, 12 bytes in the machine's own byte order */
+typedef struct ParcelRecord {
+    int key; //the country ID, or in --batch mode the number of the query that returned the parcel
+    int weight;
+    int valuation; //in cents
+} ParcelRecord;
+
+/* One destination's row of the report of every destination */
+typedef struct CountryReport {
+    int countryId;
+    int minWeight; //lightest parcel
+    int maxWeight; //heaviest parcel
+    ParcelTotals totals; //count, load, valuation and the price range
+} CountryReport;
+
+/* One request to --serve, followed by nameLength bytes of the destination's name without a terminating 0. like ParcelRecords everything is in
+   the machine's own byte order, the server only takes clients on the same machine */
+typedef struct ServerRequest {
+    unsigned int id; //copied into the reply, so a client can have many requests in flight on one connection
+    unsigned short kind; //SERVER_LIST to SERVER_EXTREMES
+    unsigned short nameLength;
+    int first; //the weight for SERVER_ABOVE and SERVER_BELOW, the low end of the range for the others that take one
+    int second; //the high end of the range
+} ServerRequest;
+
+/* The reply to a ServerRequest, followed by records ParcelRecords keyed by the country ID. replies come back in the order the requests
+   were sent */
+typedef struct ServerReply {
+    unsigned int id;
+    int status; //SERVER_OK, SERVER_NO_PARCELS or SERVER_BAD_REQUEST
+    int count; //parcels in the range, for SERVER_COUNT and SERVER_TOTAL
+    int records;
+    long long weight; //load of the range, for SERVER_TOTAL
+    long long valuation; //^ valuation in cents
+} ServerReply;
+
+/* A client connected to --serve. requests are read into in and answered in order into out, which is sent as the socket takes it */
+typedef struct ServerConnection {
+    int fd;
+    unsigned int events; //what epoll is watching the connection for
+    int closing; //1 once the client has hung up or sent a bad name, the connection closes when its replies are sent
+    char* in;
+    size_t inUsed;
+    size_t inCapacity;
+    char* out;
+    size_t outUsed;
+    size_t outSent;
+    size_t outCapacity;
+    struct ServerConnection* next; //every open connection is on one list so they can be closed on the way out
+    struct ServerConnection* previous;
+} ServerConnection;
+
+/* One connection of the --bench-server load generator and what it measured */
+typedef struct LoadClient {
+    const char* path;
+    int pipeline; //requests kept in flight
+    double until; //nowSeconds() after which no more requests are sent
+    unsigned long long seed;
+    double* latencies;
+    int latencyCount;
+    int latencyCapacity;
+    long long records;
+    int errors; //replies that weren't SERVER_OK or came back out of order
+    int failed; //1 if the connection couldn't be made or broke
+    std::thread thread;
+} LoadClient;
+
+/* Position in an arena when a view was last published. nodes allocated after it aren't in any view yet, so the follower can still change
+   them in place instead of copying them */
+typedef struct ArenaMark {
+    Slab* slab; //newest slab at the time, NULL if the arena was empty
+    size_t used;
+} ArenaMark;
+
+/* Memory that belonged to a view the follower replaced, freed once no reader can still be looking at it */
+typedef struct RetiredBlock {
+    void* memory;
+    unsigned long long epoch; //readers that started in this epoch or later can't have seen it
+    int countryId; //NO_COUNTRY if the memory was malloc'd, or the country whose arena it goes back to
+    size_t size; //^ the size it was allocated with
+    struct RetiredBlock* next;
+} RetiredBlock;
+
+/* The table and dictionary readers see while --follow adds parcels. the follower never changes anything a published view points to, it
+   copies what it needs to change and swaps in a new view, so readers don't wait for it and always see a whole number of batches */
+typedef struct SharedTable {
+    std::atomic<HashTable*> view; //NULL when not following, the queries then read the loaded table directly
+    std::atomic<CountryDictionary*> dictionary; //NULL when not following, the queries then read countryDictionary
+    std::atomic<unsigned long long> epoch; //goes up by one every time a view is published
+    std::atomic<unsigned long long> readers[MAX_READERS]; //epoch each reader's current query started in, 0 between queries
+    std::atomic<int> claimed[MAX_READERS]; //1 while a query thread has the slot, see registerReader()
+} SharedTable;
+
+/* One view published by the follower */
+typedef struct FollowBatch {
+    long long endOffset; //the view has every line before this offset in the followed file
+    double readTime; //when the lines were read
+    double publishTime; //when they became visible to the queries
+    int parcels;
+} FollowBatch;
+
+/* The follower thread and everything only it changes */
+typedef struct FollowState {
+    const char* path;
+    int fd;
+    HashTable* hashTable; //the follower's own table, the readers only ever see the copies it publishes
+    ArenaMark* marks; //indexed by country ID
+    int markCount;
+    const void** reused; //nodes taken off an arena's free list since the last publication, which are older than the mark but in no view
+    int reusedCount;
+    int reusedSlots; //a power of two, 0 before the first one
+    int publishedCountries; //countries in the last published dictionary
+    long long offset; //bytes of the file read so far
+    std::atomic<long long> publishedOffset; //endOffset of the newest view, read by --bench-follow while the follower runs
+    std::atomic<int> stop;
+    std::thread thread;
+    RetiredBlock* retired;
+    int parcelsAdded;
+    int rowsSkipped;
+    FollowBatch* batches;
+    int batchCount;
+    int batchCapacity;
+} FollowState;
+
+/* Rows --bench-follow appends to the followed file and when each burst of them was written */
+typedef struct FollowGenerator {
+    FILE* file;
+    const char** names; //existing destinations to pick from
+    int nameCount;
+    int bursts;
+    long long* endOffsets;
+    double* writeTimes;
+    int newCountries; //destinations that weren't loaded, so the dictionary gets published too
+    std::atomic<long long> finalOffset; //size of the file once every burst is written, -1 until then
+} FollowGenerator;
+
+/* One thread of --bench-readers, either a query thread or the writer */
+typedef struct StressWorker {
+    HashTable* hashTable;
+    FollowState* writer; //NULL for a query thread
+    const char** names; //destinations to pick from
+    int nameCount;
+    std::atomic<int>* stop;
+    unsigned long long seed;
+    long long operations; //queries answered, or parcels added by the writer
+    int failures; //answers that can't be right, such as a lightest parcel heavier than the heaviest
+} StressWorker;
+
+#ifdef PARCEL_STATS
+/* HDR-style histogram, exact below 16 and then HISTOGRAM_SUB_BITS buckets per power of two. any thread can record into it */
+typedef struct Histogram {
+    std::atomic<long long> counts[HISTOGRAM_BUCKETS];
+    std::atomic<long long> total; //values recorded
+    std::atomic<long long> sum;
+    std::atomic<long long> max;
+} Histogram;
+
+/* What one instrumented function has done since the program started */
+typedef struct Probe {
+    Histogram nanoseconds; //time per call
+    Histogram visits; //tree nodes visited per call
+} Probe;
+
+/* Times the scope PROBE() declares it in and counts the nodes visited meanwhile, recording both when the scope ends */
+struct ProbeScope {
+    int probe;
+    long long start;
+    long long visits;
+    ProbeScope(int probe);
+    ~ProbeScope();
+};
+#endif
+
+/* Global dictionary of every destination loaded */
+CountryDictionary countryDictionary;
+
+/* Global output buffers, every parcel row printed by a query goes through one of them */
+OutputBuffer output;
+OutputBuffer records;
+
+/* Global choice of column kernels, set by selectColumnKernels() before anything reads the column store */
+const ColumnKernels* columnKernels = NULL;
+
+/* Global limits isValidParcel() checks and fewest rows the loaders accept, set from the options before anything is loaded */
+ParcelLimits parcelLimits = courierLimits;
+int minimumRows = MIN_FLIGHTS;
+
+/* Global stream for the load and status messages, stderr with --batch so stdout only has the query results */
+FILE* statusOutput = stdout;
+
+/* Global view of the table for the queries while --follow is running */
+SharedTable shared;
+
+/* Global count of heap calls and the bytes they asked for, see countAllocation(). they stay 0 without -DPARCEL_STATS */
+std::atomic<long long> heapAllocations(0);
+std::atomic<long long> heapBytes(0);
+
+#ifdef PARCEL_STATS
+/* Global instrumentation, see PROBE() */
+const char* probeNames[PROBE_COUNT] = { "computeHash", "hashCountryName", "createParcel", "insertBST", "searchByCountry", "searchByWeight",
+    "searchByWeightRange", "calculateTotalLoadAndValuation", "calculateWeightRangeTotals", "displayCheapestAndMostExpensive",
+    "displayLightestAndHeaviest", "displayTopPrices", "searchByPrice", "runBatchQuery", "queryTotals", "queryLightestAndHeaviest",
+    "queryCheapestAndMostExpensive", "queryWeightRange", "serveRequest" };
+Probe probes[PROBE_COUNT];
+std::atomic<int> deepestInsert[MAX_DEPTH_COUNTRIES]; //deepest level insertBST() has put a node at in each country, the root is 1
+thread_local long long nodesVisited = 0; //tree nodes this thread has visited, only ever compared before and after a call
+std::thread statsThread;
+std::atomic<int> statsStop(0);
+#endif
+
 /* Function prototypes */
-void traverseAndAddBST(BSTNode* node, int& totalWeight, float& totalValuation);
-HashNode* initializeHashTable(void);
+void traverseAndAddBST(BSTNode* node, long long& totalWeight, long long& totalValuation);
+HashTable* initializeHashTable(void);
+HashNode* countryNode(HashTable* hashTable, int countryId);
+HashNode* findCountryNode(const char* country, HashTable* hashTable);
 unsigned long computeHash(const char* str);
-Parcel* createParcel(const char* destination, int weight, float valuation);
-BSTNode* insertBST(BSTNode* root, Parcel* parcel);
-int loadData(const char* filename, HashNode* hashTable);
+unsigned long long hashCountryName(const char* name, int length);
+int homeSlot(unsigned long long hash, int slotCount);
+int isValidParcel(int weight, int valuation);
+Parcel* createParcel(Arena* arena, int countryId, int weight, int valuation);
+int parseCents(const char* text, const char* end, int* cents);
+int readCents(int* cents);
+void initializeDictionary(CountryDictionary* dictionary);
+int internCountry(CountryDictionary* dictionary, const char* name, int length);
+int lookupCountry(const CountryDictionary* dictionary, const char* name, int length);
+int findCountry(const char* name);
+const char* countryName(int countryId);
+void growCountryIndex(CountryDictionary* dictionary);
+void printIndexStats(const CountryDictionary* dictionary);
+void benchmarkCountryIndex(HashTable* hashTable);
+void copyIntoBuckets(BSTNode* root, HashNode* buckets);
+void printDiagnostics(HashTable* hashTable);
+void printTreeShape(BSTNode* root);
+long long sumDepths(BSTNode* root);
+int optimalHeight(int count);
+void releaseDictionary(CountryDictionary* dictionary);
+BSTNode* insertBST(Arena* arena, BSTNode* root, Parcel* parcel, FollowState* follow);
+int nodeHeight(BSTNode* node);
+void updateNode(BSTNode* node);
+void clearTotals(ParcelTotals* totals);
+void addParcelToTotals(ParcelTotals* totals, const Parcel* parcel);
+void addTotals(ParcelTotals* totals, const ParcelTotals* more);
+void sumWeightRange(BSTNode* root, int minWeight, int maxWeight, ParcelTotals* totals);
+int checkSubtreeTotals(BSTNode* root);
+BSTNode* rotateLeft(BSTNode* node);
+BSTNode* rotateRight(BSTNode* node);
+BSTNode* rebalanceBST(BSTNode* node);
+void addParcel(HashNode* node, Parcel* parcel);
+void buildPriceIndex(HashNode* node);
+void buildAllPriceIndexes(HashTable* hashTable);
+void collectParcels(BSTNode* root, PricedParcel* parcels, int& next);
+int comparePricedParcels(const void* first, const void* second);
+PriceNode* buildPriceTree(Arena* arena, PricedParcel* parcels, int count);
+PriceNode* insertPrice(Arena* arena, PriceNode* root, Parcel* parcel, FollowState* follow);
+int priceHeight(PriceNode* node);
+void updatePriceHeight(PriceNode* node);
+PriceNode* rotatePriceLeft(PriceNode* node);
+PriceNode* rotatePriceRight(PriceNode* node);
+PriceNode* rebalancePrice(PriceNode* node);
+int checkPriceIndex(HashNode* node);
+int checkPriceOrder(PriceNode* root, int* previous, int* count);
+void benchmarkBalance(int rows);
+unsigned long long nextRandom(unsigned long long* state);
+void* arenaAlloc(Arena* arena, size_t size);
+void arenaFree(Arena* arena, void* memory, size_t size);
+void arenaRelease(Arena* arena);
+void printMemoryReport(HashTable* hashTable);
+void addMallocFootprint(BSTNode* root, size_t& bytes, int& parcels);
+size_t mallocChunkSize(size_t request);
+int loadData(const char* filename, HashTable* hashTable, int maxRows, LoadStats* stats);
+int loadDataMapped(const char* filename, HashTable* hashTable, int maxRows, LoadStats* stats);
+int loadDataParallel(const char* filename, HashTable* hashTable, int maxRows, int threads, LoadStats* stats);
+void parseChunk(LoadChunk* chunk);
+void mergeChunks(LoadChunk* chunks, int chunkCount, HashTable* hashTable, int firstCountry, int step);
+void appendToRun(ParcelRun* run, const ParsedRecord* record, int row);
+int verifyParallelLoad(const Options* options, HashTable* hashTable);
+int compareBST(BSTNode* first, BSTNode* second);
+int mapFile(const char* filename, MappedFile* file);
+void unmapFile(MappedFile* file);
+const char* parseRecord(const char* cursor, const char* end, ParsedRecord* record, int* valid);
+void printLoadStats(const char* loader, const LoadStats* stats);
+double nowSeconds(void);
+int parseOptions(int argc, char* argv[], Options* options);
 void printParcels(BSTNode* root);
-void searchByCountry(const char* country, HashNode* hashTable);
-void searchByWeightHelper(BSTNode* root, int weight, int higher);
-void searchByWeight(const char* country, int weight, int higher, HashNode* hashTable);
-void calculateTotalLoadAndValuation(const char* country, HashNode* hashTable);
-void displayCheapestAndMostExpensive(const char* country, HashNode* hashTable);
-void displayLightestAndHeaviest(const char* country, HashNode* hashTable);
-void findLowestPrice(BSTNode* root, Parcel** cheapestParcel);
-void findHighestPrice(BSTNode* root, Parcel** cheapestParcel);
-void cleanup(HashNode* hashTable);
-void freeBST(BSTNode* root);
-
-int main(void) {
-    HashNode* hashTable = initializeHashTable();
-
-    if (loadData("courier.txt", hashTable) == ERROR) {
-        printf("Not enough flights provided in the file\n");
+void searchByCountry(const char* country, HashTable* hashTable);
+template <typename Node> void openTreeCursor(TreeCursor<Node>* cursor, Node* root, int order);
+template <typename Node> void seekTreeCursor(TreeCursor<Node>* cursor, Node* root, double minKey, double maxKey);
+template <typename Node> Node* nextTreeCursor(TreeCursor<Node>* cursor);
+template <typename Node> void pushTreeCursor(TreeCursor<Node>* cursor, Node* node);
+template <typename Node> void growTreeCursor(TreeCursor<Node>* cursor);
+template <typename Node> void closeTreeCursor(TreeCursor<Node>* cursor);
+double cursorKey(const BSTNode* node);
+double cursorKey(const PriceNode* node);
+constexpr int parcelInLimits(const ParcelLimits* limits, int weight, int valuation);
+unsigned int bucketHash(const char* name);
+unsigned int bucketHash(int countryId);
+int sameKey(const char* a, const char* b);
+int sameKey(int a, int b);
+template <typename Key> Key countryKey(int countryId);
+template <typename Key, int Buckets, const ParcelLimits* Limits> void openBucketTable(BucketTable<Key, Buckets, Limits>* table, int bucketCount,
+    const ParcelLimits* limits);
+template <typename Key, int Buckets, const ParcelLimits* Limits> void closeBucketTable(BucketTable<Key, Buckets, Limits>* table);
+template <typename Key, int Buckets, const ParcelLimits* Limits> int bucketIndex(const BucketTable<Key, Buckets, Limits>* table, unsigned int hash);
+template <typename Key, int Buckets, const ParcelLimits* Limits> const ParcelLimits* bucketLimits(const BucketTable<Key, Buckets, Limits>* table);
+template <typename Key, int Buckets, const ParcelLimits* Limits> BucketEntry<Key>* findBucketEntry(const BucketTable<Key, Buckets, Limits>* table, Key key);
+template <typename Key, int Buckets, const ParcelLimits* Limits> int addToBucketTable(BucketTable<Key, Buckets, Limits>* table, Key key, int countryId,
+    int weight, int valuation);
+template <typename Key, int Buckets, const ParcelLimits* Limits> int bucketTableTotals(const BucketTable<Key, Buckets, Limits>* table, Key key,
+    ParcelTotals* totals);
+template <typename Table> int benchmarkBucketTable(Table* table, const char* name, HashTable* hashTable);
+int benchmarkTables(HashTable* hashTable, int runtimeBuckets);
+void openWeightCursor(WeightCursor* cursor, BSTNode* root, int minWeight, int maxWeight);
+BSTNode* nextWeightCursor(WeightCursor* cursor);
+int countWeightRange(BSTNode* root, int minWeight, int maxWeight);
+void printWeightRange(BSTNode* root, int minWeight, int maxWeight);
+void searchByWeight(const char* country, int weight, int higher, HashTable* hashTable);
+void searchByWeightRange(const char* country, int minWeight, int maxWeight, int countOnly, HashTable* hashTable);
+void calculateWeightRangeTotals(const char* country, int minWeight, int maxWeight, HashTable* hashTable);
+void printRangeTotals(int minWeight, int maxWeight, const ParcelTotals* totals);
+int countWeightRangeScan(BSTNode* root, int minWeight, int maxWeight);
+void benchmarkWeightRange(HashTable* hashTable);
+void calculateTotalLoadAndValuation(const char* country, HashTable* hashTable);
+void displayCheapestAndMostExpensive(const char* country, HashTable* hashTable);
+void displayLightestAndHeaviest(const char* country, HashTable* hashTable);
+void findPriceRange(BSTNode* root, Parcel** cheapestParcel, Parcel** expensiveParcel);
+int printCheapest(PriceNode* root, int remaining);
+int printMostExpensive(PriceNode* root, int remaining);
+void printPriceRange(PriceNode* root, int minValuation, int maxValuation);
+void displayTopPrices(const char* country, int count, int cheapestFirst, HashTable* hashTable);
+void searchByPrice(const char* country, int minValuation, int maxValuation, HashTable* hashTable);
+void cleanup(HashTable* hashTable);
+ColumnStore* buildColumnStore(HashTable* hashTable);
+void fillColumns(BSTNode* root, ColumnStore* store, int& row);
+int countBST(BSTNode* root);
+void releaseColumnStore(ColumnStore* store);
+int findCountryColumns(const char* country, const ColumnStore* store, int* begin, int* end);
+void printColumnRows(const ColumnStore* store, int begin, int end);
+int lowerBoundColumns(const ColumnStore* store, int begin, int end, int weight);
+int upperBoundColumns(const ColumnStore* store, int begin, int end, int weight);
+void sumColumns(const ColumnStore* store, int begin, int end, ParcelTotals* totals);
+void buildPriceOrder(ColumnStore* store);
+int comparePricedRows(const void* first, const void* second);
+int lowerBoundPriceOrder(const ColumnStore* store, int begin, int end, int valuation);
+void displayTopPricesColumns(const char* country, int count, int cheapestFirst, const ColumnStore* store);
+void searchByPriceColumns(const char* country, int minValuation, int maxValuation, const ColumnStore* store);
+void selectColumnKernels(void);
+int cpuKernelLevel(void);
+void sumKernelScalar(const int* weights, const int* valuations, int count, ParcelTotals* totals);
+void extremesKernelScalar(const int* valuations, int count, int* cheapest, int* priciest);
+int filterKernelScalar(const int* valuations, int count, int minValuation, int maxValuation, unsigned long long* bitmap);
+#ifdef COLUMN_KERNELS_X86
+void sumKernelSse41(const int* weights, const int* valuations, int count, ParcelTotals* totals);
+void extremesKernelSse41(const int* valuations, int count, int* cheapest, int* priciest);
+int filterKernelSse41(const int* valuations, int count, int minValuation, int maxValuation, unsigned long long* bitmap);
+void sumKernelAvx2(const int* weights, const int* valuations, int count, ParcelTotals* totals);
+void extremesKernelAvx2(const int* valuations, int count, int* cheapest, int* priciest);
+int filterKernelAvx2(const int* valuations, int count, int minValuation, int maxValuation, unsigned long long* bitmap);
+#endif
+int benchmarkKernels(const ColumnStore* store);
+int verifyTotals(int rows);
+size_t paddedSize(size_t size);
+unsigned long long checksumBytes(const char* data, size_t size);
+int sourceFileInfo(const char* filename, long long* size, long long* modified);
+int writeSnapshot(const Options* options, const ColumnStore* store);
+ColumnStore* openSnapshot(const Options* options, MappedFile* image);
+void searchByCountryColumns(const char* country, const ColumnStore* store);
+void searchByWeightColumns(const char* country, int weight, int higher, const ColumnStore* store);
+void searchByWeightRangeColumns(const char* country, int minWeight, int maxWeight, int countOnly, const ColumnStore* store);
+void calculateTotalLoadAndValuationColumns(const char* country, const ColumnStore* store);
+void calculateWeightRangeTotalsColumns(const char* country, int minWeight, int maxWeight, const ColumnStore* store);
+void displayCheapestAndMostExpensiveColumns(const char* country, const ColumnStore* store);
+void displayLightestAndHeaviestColumns(const char* country, const ColumnStore* store);
+void benchmarkEngines(HashTable* hashTable, const ColumnStore* store);
+void runMenu(HashTable* hashTable, ColumnStore* columns);
+int runBatch(const char* path, HashTable* hashTable, ColumnStore* columns);
+int runBatchQuery(char* line, int query, HashTable* hashTable, ColumnStore* columns, OutputBuffer* out);
+int batchArguments(const char* verb);
+int parseBatchNumbers(const char* numbers, int* first, int* second);
+int batchWeightRange(OutputBuffer* out, int query, HashTable* hashTable, ColumnStore* columns, int countryId, int minWeight, int maxWeight);
+int batchExtremes(OutputBuffer* out, int query, HashTable* hashTable, ColumnStore* columns, int countryId, int byPrice);
+void batchTotals(OutputBuffer* out, int query, HashTable* hashTable, ColumnStore* columns, int countryId, int minWeight, int maxWeight);
+int hasParcels(HashTable* hashTable, ColumnStore* columns, int countryId);
+int countRange(HashTable* hashTable, ColumnStore* columns, int countryId, int minWeight, int maxWeight);
+void sumRange(HashTable* hashTable, ColumnStore* columns, int countryId, int minWeight, int maxWeight, ParcelTotals* totals);
+void findExtremes(HashTable* hashTable, ColumnStore* columns, int countryId, int byPrice, Parcel* low, Parcel* high);
+int reportAll(HashTable* hashTable, ColumnStore* columns, int threads, CountryReport** reports);
+void reportCountries(HashTable* hashTable, ColumnStore* columns, CountryReport* reports, int countries, int first, int step);
+int compareReports(const void* first, const void* second);
+void printReport(HashTable* hashTable, ColumnStore* columns);
+void batchReport(OutputBuffer* out, int query, HashTable* hashTable, ColumnStore* columns);
+int benchmarkReport(HashTable* hashTable, ColumnStore* columns);
+int runServer(const char* path, HashTable* hashTable, ColumnStore* columns);
+void stopServer(int signal);
+int serveConnection(ServerConnection* connection, unsigned int events, int epoll, HashTable* hashTable, ColumnStore* columns, long long* requests);
+int answerRequests(ServerConnection* connection, HashTable* hashTable, ColumnStore* columns);
+void serveRequest(ServerConnection* connection, const ServerRequest* request, const char* name, HashTable* hashTable, ColumnStore* columns);
+int serveWeightRange(ServerConnection* connection, HashTable* hashTable, ColumnStore* columns, int countryId, int minWeight, int maxWeight);
+char* reserveReply(ServerConnection* connection, size_t size);
+void appendReplyRecord(ServerConnection* connection, int countryId, int weight, int valuation);
+int sendReplies(ServerConnection* connection);
+void closeConnection(ServerConnection* connection, ServerConnection** connections);
+int benchmarkServer(const Options* options);
+void runLoadClient(LoadClient* client);
+size_t writeLoadRequest(char* out, unsigned int id, unsigned long long* seed);
+int connectServer(const char* path);
+void openOutput(OutputBuffer* buffer, FILE* file);
+void closeOutput(OutputBuffer* buffer);
+void flushOutput(OutputBuffer* buffer);
+void flushAllOutput(void);
+char* reserveOutput(OutputBuffer* buffer, size_t size);
+char* formatInt(char* out, long long value);
+char* formatValuation(char* out, long long valuation);
+void writeParcel(int countryId, int weight, int valuation);
+void writeBatchParcel(OutputBuffer* out, int query, int weight, int valuation);
+void writeRecord(int key, int weight, int valuation);
+void writeFormatted(OutputBuffer* buffer, const char* format, ...);
+void benchmarkOutput(HashTable* hashTable);
+HashTable* beginRead(HashTable* hashTable, int reader);
+void endRead(int reader);
+const CountryDictionary* readDictionary(void);
+int isUnpublished(const Arena* arena, const ArenaMark* published, const void* memory);
+int followerOwns(FollowState* follow, int countryId, const void* memory);
+void* followerAlloc(FollowState* follow, int countryId, size_t size);
+void rememberReused(FollowState* follow, const void* memory);
+void retireNode(FollowState* follow, int countryId, void* memory, size_t size);
+int startFollowing(FollowState* follow, const char* path, const char* loadedFile, HashTable* hashTable);
+void stopFollowing(FollowState* follow);
+void startPublishing(FollowState* follow, HashTable* hashTable);
+void stopPublishing(FollowState* follow);
+void releaseFollow(FollowState* follow);
+void followFile(FollowState* follow);
+void followParcel(FollowState* follow, const ParsedRecord* record);
+void growMarks(FollowState* follow, int count);
+void publishView(FollowState* follow);
+HashTable* copyTable(const HashTable* hashTable);
+CountryDictionary* cloneDictionary(const CountryDictionary* dictionary);
+void retireMemory(FollowState* follow, void* memory, unsigned long long epoch);
+void reclaimRetired(FollowState* follow, int everything);
+int compareDoubles(const void* first, const void* second);
+int compareInts(const void* first, const void* second);
+double percentile(const double* sorted, int count, double fraction);
+void printPercentiles(FILE* file, const char* label, double* seconds, int count);
+double* appendSample(double* samples, int* count, int* capacity, double value);
+int benchmarkFollow(const Options* options, HashTable* hashTable);
+void appendRows(FollowGenerator* generator);
+double timeFollowQuery(HashTable* hashTable, unsigned long long* seed, int* inconsistent, long long* visible);
+int registerReader(void);
+void releaseReader(int reader);
+int queryTotals(HashTable* hashTable, int reader, const char* country, int minWeight, int maxWeight, ParcelTotals* totals);
+int queryLightestAndHeaviest(HashTable* hashTable, int reader, const char* country, Parcel* lightest, Parcel* heaviest);
+int queryCheapestAndMostExpensive(HashTable* hashTable, int reader, const char* country, Parcel* cheapest, Parcel* mostExpensive);
+int queryWeightRange(HashTable* hashTable, int reader, const char* country, int minWeight, int maxWeight, Parcel* parcels, int capacity);
+void weightExtremes(BSTNode* root, Parcel** lightest, Parcel** heaviest);
+void priceExtremes(HashNode* node, Parcel** cheapest, Parcel** mostExpensive);
+int benchmarkReaders(HashTable* hashTable);
+int removeParcel(HashNode* node, int weight, int valuation);
+int changeParcel(HashNode* node, int weight, int valuation, int newWeight, int newValuation);
+void deliverParcel(const char* country, int weight, int valuation, HashTable* hashTable);
+void updateParcel(const char* country, int weight, int valuation, int newWeight, int newValuation, HashTable* hashTable);
+BSTNode* removeBST(Arena* arena, BSTNode* node, int weight, int valuation, Parcel** removed);
+BSTNode* revalueBST(BSTNode* node, int weight, int valuation, int newValuation, Parcel** changed);
+BSTNode* unlinkBST(Arena* arena, BSTNode* node);
+BSTNode* removeLightest(BSTNode* node, BSTNode** lightest);
+PriceNode* removePrice(Arena* arena, PriceNode* node, Parcel* parcel, int valuation, int* found);
+PriceNode* unlinkPrice(Arena* arena, PriceNode* node);
+PriceNode* removeCheapest(PriceNode* node, PriceNode** cheapest);
+BSTNode* selectBST(BSTNode* root, int rank);
+int benchmarkChurn(HashTable* hashTable);
+int benchmarkTraversal(HashTable* hashTable);
+int checkDegenerateTree(int leftLeaning);
+void linkDegenerateTree(BSTNode* nodes, PriceNode* prices, Parcel* parcels, int count, int leftLeaning);
+void traverseAndAddRecursive(BSTNode* node, long long& totalWeight, long long& totalValuation);
+void findPriceRangeRecursive(BSTNode* root, Parcel** cheapestParcel, Parcel** expensiveParcel);
+int countBSTRecursive(BSTNode* root);
+void* countedMalloc(size_t size);
+void* countedCalloc(size_t count, size_t size);
+void* countedRealloc(void* memory, size_t size);
+void countAllocation(size_t size);
+int writeSuiteManifest(const char* path, const Options* options);
+int benchmarkSuite(const Options* options);
+void runSuiteQuery(int query, const char* country, int weight, HashTable* hashTable);
+void printSuitePhase(const char* phase, double* seconds, int count, long long allocations, long long bytes);
+#ifdef PARCEL_STATS
+long long probeClock(void);
+void recordValue(Histogram* histogram, long long value);
+long long histogramPercentile(const Histogram* histogram, double fraction);
+void recordDepth(int countryId, int depth);
+void dumpStats(FILE* file);
+void blockDumpSignal(void);
+void startStatsThread(void);
+void stopStatsThread(void);
+void waitForDumpSignal(void);
+#endif
+void runStressReader(StressWorker* worker);
+void runStressWriter(StressWorker* worker);
+
+int main(int argc, char* argv[]) {
+#ifdef PARCEL_STATS
+    blockDumpSignal();
+#endif
+    Options options;
+    if (parseOptions(argc, argv, &options) == ERROR) {
+        return ERROR;
+    }
+    selectColumnKernels();
+    parcelLimits = options.limits;
+    minimumRows = options.minRows;
+    if (options.batchPath != NULL) {
+        statusOutput = stderr;
+    }
+
+    if (options.benchBalanceRows > 0) {
+        benchmarkBalance(options.benchBalanceRows);
+        return SUCCESS;
+    }
+    if (options.verifyTotalsRows > 0) {
+        return verifyTotals(options.verifyTotalsRows);
+    }
+    openOutput(&output, stdout);
+    if (options.recordsPath != NULL) {
+        FILE* recordsFile = fopen(options.recordsPath, "wb");
+        if (recordsFile == NULL) {
+            perror("Unable to open records file");
+            return ERROR;
+        }
+        openOutput(&records, recordsFile);
+    }
+    if (options.benchSuite) {
+        int result = benchmarkSuite(&options);
+        closeOutput(&records);
+        closeOutput(&output);
+        return result;
+    }
+
+    HashTable* hashTable = initializeHashTable();
+    initializeDictionary(&countryDictionary);
+    // a snapshot only has the column store, so anything that needs the trees loads the text file
+    int needsTrees = options.memoryReport || options.diagnostics || options.benchIndex || options.verifyLoad || options.benchRange || options.benchEngines ||
+        options.benchOutput || options.benchFollow || options.benchReaders || options.benchChurn || options.benchTraversal ||
+        options.benchServerPath != NULL || options.benchReport || options.benchKernels || options.benchTables;
+    ColumnStore* columns = NULL;
+    MappedFile image;
+    if (options.snapshotPath != NULL && !needsTrees) {
+        double start = nowSeconds();
+        columns = openSnapshot(&options, &image);
+        if (columns != NULL) {
+            fprintf(statusOutput, "Opened snapshot %s with %d parcels in %.3f ms, queries use the column engine\n", options.snapshotPath,
+                columns->parcelCount, (nowSeconds() - start) * 1000.0);
+            if (options.reportAll) {
+                printReport(hashTable, columns);
+            }
+#ifdef PARCEL_STATS
+            startStatsThread();
+#endif
+            int result = SUCCESS;
+            if (options.serverPath != NULL)
+                result = runServer(options.serverPath, hashTable, columns);
+            else if (options.batchPath != NULL)
+                result = runBatch(options.batchPath, hashTable, columns);
+            else
+                runMenu(hashTable, columns);
+#ifdef PARCEL_STATS
+            stopStatsThread();
+            dumpStats(stderr);
+#endif
+            releaseColumnStore(columns);
+            unmapFile(&image);
+            cleanup(hashTable);
+            free(hashTable);
+            releaseDictionary(&countryDictionary);
+            closeOutput(&records);
+            closeOutput(&output);
+            return result;
+        }
+    }
+    LoadStats stats;
+    int loadResult = 0;
+    const char* loaderName = "mmap";
+    if (options.useScanfLoader) {
+        loaderName = "fscanf";
+        loadResult = loadData(options.filename, hashTable, options.maxRows, &stats);
+    }
+    else if (options.threads > 1) {
+        loaderName = "parallel mmap";
+        loadResult = loadDataParallel(options.filename, hashTable, options.maxRows, options.threads, &stats);
+    }
+    else {
+        loadResult = loadDataMapped(options.filename, hashTable, options.maxRows, &stats);
+    }
+    printLoadStats(loaderName, &stats);
+    if (options.memoryReport) {
+        printMemoryReport(hashTable);
+    }
+    if (options.diagnostics) {
+        printDiagnostics(hashTable);
+    }
+    if (options.benchIndex) {
+        benchmarkCountryIndex(hashTable);
+        cleanup(hashTable);
+        free(hashTable);
+        releaseDictionary(&countryDictionary);
+        return SUCCESS;
+    }
+    if (options.verifyLoad) {
+        int result = verifyParallelLoad(&options, hashTable);
+        cleanup(hashTable);
+        free(hashTable);
+        releaseDictionary(&countryDictionary);
+        return result;
+    }
+    if (loadResult == ERROR) {
+        fprintf(statusOutput, "Not enough flights provided in the file\n");
+        cleanup(hashTable);
+        free(hashTable);
+        releaseDictionary(&countryDictionary);
+        return ERROR;
+    }
+    if (options.priceIndex || options.benchEngines) {
+        double start = nowSeconds();
+        buildAllPriceIndexes(hashTable);
+        fprintf(statusOutput, "Built valuation indexes in %.3f ms\n", (nowSeconds() - start) * 1000.0);
+    }
+    if (options.engine == ENGINE_COLUMNS || options.benchEngines || options.benchKernels) {
+        double start = nowSeconds();
+        columns = buildColumnStore(hashTable);
+        fprintf(statusOutput, "Built column store for %d parcels in %.3f ms\n", columns->parcelCount, (nowSeconds() - start) * 1000.0);
+    }
+    if (options.snapshotPath != NULL && !needsTrees) {
+        double start = nowSeconds();
+        if (writeSnapshot(&options, columns) == SUCCESS) {
+            fprintf(statusOutput, "Wrote snapshot %s in %.3f ms\n", options.snapshotPath, (nowSeconds() - start) * 1000.0);
+        }
+        else {
+            fprintf(statusOutput, "Unable to write snapshot %s\n", options.snapshotPath);
+        }
+    }
+    if (options.reportAll) {
+        printReport(hashTable, columns);
+    }
+    if (options.benchReport) {
+        int result = benchmarkReport(hashTable, columns);
+        releaseColumnStore(columns);
+        cleanup(hashTable);
+        free(hashTable);
+        releaseDictionary(&countryDictionary);
+        return result;
+    }
+    if (options.benchOutput) {
+        benchmarkOutput(hashTable);
+        releaseColumnStore(columns);
+        cleanup(hashTable);
+        free(hashTable);
+        releaseDictionary(&countryDictionary);
+        return SUCCESS;
+    }
+    if (options.benchRange) {
+        benchmarkWeightRange(hashTable);
+        releaseColumnStore(columns);
+        cleanup(hashTable);
+        free(hashTable);
+        releaseDictionary(&countryDictionary);
+        return SUCCESS;
+    }
+    if (options.benchEngines) {
+        benchmarkEngines(hashTable, columns);
+        releaseColumnStore(columns);
+        cleanup(hashTable);
+        free(hashTable);
+        releaseDictionary(&countryDictionary);
+        return SUCCESS;
+    }
+    if (options.benchFollow || options.benchReaders || options.benchChurn || options.benchTraversal || options.benchServerPath != NULL ||
+        options.benchKernels || options.benchTables) {
+        int result = options.benchFollow ? benchmarkFollow(&options, hashTable) : options.benchReaders ? benchmarkReaders(hashTable) :
+            options.benchChurn ? benchmarkChurn(hashTable) : options.benchTraversal ? benchmarkTraversal(hashTable) :
+            options.benchKernels ? benchmarkKernels(columns) : options.benchTables ? benchmarkTables(hashTable, options.tableSize) :
+            benchmarkServer(&options);
+        releaseColumnStore(columns);
+        cleanup(hashTable);
+        free(hashTable);
+        releaseDictionary(&countryDictionary);
+        return result;
+    }
+    FollowState follow;
+    if (options.followPath != NULL && startFollowing(&follow, options.followPath, options.filename, hashTable) == ERROR) {
+        cleanup(hashTable);
+        free(hashTable);
+        releaseDictionary(&countryDictionary);
         return ERROR;
     }
 
+#ifdef PARCEL_STATS
+    startStatsThread();
+#endif
+    int result = SUCCESS;
+    if (options.serverPath != NULL)
+        result = runServer(options.serverPath, hashTable, columns);
+    else if (options.batchPath != NULL)
+        result = runBatch(options.batchPath, hashTable, columns);
+    else
+        runMenu(hashTable, columns);
+#ifdef PARCEL_STATS
+    stopStatsThread();
+#endif
+    if (options.followPath != NULL) {
+        stopFollowing(&follow);
+        releaseFollow(&follow);
+    }
+#ifdef PARCEL_STATS
+    dumpStats(stderr);
+#endif
+    releaseColumnStore(columns);
+    cleanup(hashTable);
+    free(hashTable);
+    releaseDictionary(&countryDictionary);
+    closeOutput(&records);
+    closeOutput(&output);
+    return result;
+}
+
+/* Interactive menu */
+//FUNCTION: runMenu()
+//PARAMETERS: HashTable* hashTable, ColumnStore* columns - the loaded table and the column store, NULL unless the column engine is in use
+//DESCRIPTION: shows the menu and runs the queries the user picks until they choose to exit. queries go to the column store when there is one
+// and to the trees otherwise, where each query reads the newest view --follow has published. the caller frees everything afterwards
+//RETURNS: void
+void runMenu(HashTable* hashTable, ColumnStore* columns) {
     int choice = 0;
     char country[21] = { 0 };
     int weight = 0;
+    int secondWeight = 0;
+    int count = 0; //K of the top-K price query
     int option = 0;
+    int price = 0; //in cents
+    int secondPrice = 0;
 
     while (true) {
         printf("\nMenu:\n");
@@ -90,6 +1223,13 @@ int main(void) {
         printf("4. Display cheapest and most expensive parcel's details\n");
         printf("5. Display lightest and heaviest parcels for the country\n");
         printf("6. Exit\n");
+        printf("7. Enter country and K to display the K cheapest or most expensive parcels\n");
+        printf("8. Enter country and two valuations to display the parcels valued between them\n");
+        printf("9. Enter country, weight and valuation of a parcel that was delivered or cancelled to remove it\n");
+        printf("10. Enter country, weight and valuation of a parcel to change its valuation or weight\n");
+#ifdef PARCEL_STATS
+        printf("11. Dump instrumentation\n");
+#endif
         printf("Enter your choice: ");
         if (scanf("%d", &choice) != VALID_INPUT) {
             printf("Invalid input, please enter a number.\n");
@@ -105,7 +1245,10 @@ int main(void) {
                 while (getchar() != '\n'); // Clear invalid input
                 continue;
             }
-            searchByCountry(country, hashTable);
+            if (columns != NULL)
+                searchByCountryColumns(country, columns);
+            else
+                searchByCountry(country, beginRead(hashTable, MAIN_READER));
             break;
         case 2:
             printf("Enter country name: ");
@@ -120,16 +1263,39 @@ int main(void) {
                 while (getchar() != '\n'); // Clear invalid input
                 continue;
             }
-            printf("1. Higher than weight\n2. Lower than weight\n");
+            printf("1. Higher than weight\n2. Lower than weight\n3. Between weight and a second weight\n4. Count between weight and a second weight\n"
+                "5. Total load between weight and a second weight\n");
             if (scanf("%d", &option) != VALID_INPUT) {
                 printf("Invalid input.\n");
                 while (getchar() != '\n'); // Clear invalid input
                 continue;
             }
-            if (option == HIGHER)
-                searchByWeight(country, weight, SEARCH_HIGH, hashTable);
+            if (option == BETWEEN || option == COUNT_BETWEEN || option == TOTAL_BETWEEN) {
+                printf("Enter second weight: ");
+                if (scanf("%d", &secondWeight) != VALID_INPUT) {
+                    printf("Invalid input.\n");
+                    while (getchar() != '\n'); // Clear invalid input
+                    continue;
+                }
+                int minWeight = (weight < secondWeight) ? weight : secondWeight;
+                int maxWeight = (weight < secondWeight) ? secondWeight : weight;
+                if (option == TOTAL_BETWEEN && columns != NULL)
+                    calculateWeightRangeTotalsColumns(country, minWeight, maxWeight, columns);
+                else if (option == TOTAL_BETWEEN)
+                    calculateWeightRangeTotals(country, minWeight, maxWeight, beginRead(hashTable, MAIN_READER));
+                else if (columns != NULL)
+                    searchByWeightRangeColumns(country, minWeight, maxWeight, option == COUNT_BETWEEN, columns);
+                else
+                    searchByWeightRange(country, minWeight, maxWeight, option == COUNT_BETWEEN, beginRead(hashTable, MAIN_READER));
+            }
+            else if (option == HIGHER && columns != NULL)
+                searchByWeightColumns(country, weight, SEARCH_HIGH, columns);
+            else if (option == LOWER && columns != NULL)
+                searchByWeightColumns(country, weight, SEARCH_LOW, columns);
+            else if (option == HIGHER)
+                searchByWeight(country, weight, SEARCH_HIGH, beginRead(hashTable, MAIN_READER));
             else if (option == LOWER)
-                searchByWeight(country, weight, SEARCH_LOW, hashTable);
+                searchByWeight(country, weight, SEARCH_LOW, beginRead(hashTable, MAIN_READER));
             else //if they don't enter valid higher or lower weight option, then just restart menu
             {
                 printf("Invalid input.\n");
@@ -144,7 +1310,10 @@ int main(void) {
                 while (getchar() != '\n'); // Clear invalid input
                 continue;
             }
-            calculateTotalLoadAndValuation(country, hashTable);
+            if (columns != NULL)
+                calculateTotalLoadAndValuationColumns(country, columns);
+            else
+                calculateTotalLoadAndValuation(country, beginRead(hashTable, MAIN_READER));
             break;
         case 4:
             printf("Enter country name: ");
@@ -153,7 +1322,10 @@ int main(void) {
                 while (getchar() != '\n'); // Clear invalid input
                 continue;
             }
-            displayCheapestAndMostExpensive(country, hashTable);
+            if (columns != NULL)
+                displayCheapestAndMostExpensiveColumns(country, columns);
+            else
+                displayCheapestAndMostExpensive(country, beginRead(hashTable, MAIN_READER));
             break;
         case 5:
             printf("Enter country name: ");
@@ -162,371 +1334,7769 @@ int main(void) {
                 while (getchar() != '\n'); // Clear invalid input
                 continue;
             }
-            displayLightestAndHeaviest(country, hashTable);
+            if (columns != NULL)
+                displayLightestAndHeaviestColumns(country, columns);
+            else
+                displayLightestAndHeaviest(country, beginRead(hashTable, MAIN_READER));
             break;
         case 6:
-            cleanup(hashTable);
-            free(hashTable);
-            return SUCCESS;
+            return;
+        case 7:
+            printf("Enter country name: ");
+            if (scanf("%20s", country) != VALID_INPUT) {
+                printf("Invalid input.\n");
+                while (getchar() != '\n'); // Clear invalid input
+                continue;
+            }
+            printf("Enter K: ");
+            if (scanf("%d", &count) != VALID_INPUT || count < 1) {
+                printf("Invalid input.\n");
+                while (getchar() != '\n'); // Clear invalid input
+                continue;
+            }
+            printf("1. Cheapest first\n2. Most expensive first\n");
+            if (scanf("%d", &option) != VALID_INPUT || (option != CHEAPEST_FIRST && option != EXPENSIVE_FIRST)) {
+                printf("Invalid input.\n");
+                while (getchar() != '\n'); // Clear invalid input
+                continue;
+            }
+            if (columns != NULL)
+                displayTopPricesColumns(country, count, option == CHEAPEST_FIRST, columns);
+            else
+                displayTopPrices(country, count, option == CHEAPEST_FIRST, beginRead(hashTable, MAIN_READER));
+            break;
+        case 8:
+            printf("Enter country name: ");
+            if (scanf("%20s", country) != VALID_INPUT) {
+                printf("Invalid input.\n");
+                while (getchar() != '\n'); // Clear invalid input
+                continue;
+            }
+            printf("Enter two valuations: ");
+            if (readCents(&price) != VALID_INPUT || readCents(&secondPrice) != VALID_INPUT) {
+                printf("Invalid input.\n");
+                while (getchar() != '\n'); // Clear invalid input
+                continue;
+            }
+            if (price > secondPrice) {
+                int swap = price;
+                price = secondPrice;
+                secondPrice = swap;
+            }
+            if (columns != NULL)
+                searchByPriceColumns(country, price, secondPrice, columns);
+            else
+                searchByPrice(country, price, secondPrice, beginRead(hashTable, MAIN_READER));
+            break;
+        case 9:
+        case 10:
+            if (columns != NULL || shared.view.load() != NULL) {
+                printf("Parcels can't be changed with --engine columns, --snapshot or --follow.\n");
+                continue;
+            }
+            printf("Enter country name: ");
+            if (scanf("%20s", country) != VALID_INPUT) {
+                printf("Invalid input.\n");
+                while (getchar() != '\n'); // Clear invalid input
+                continue;
+            }
+            printf("Enter weight and valuation: ");
+            if (scanf("%d", &weight) != VALID_INPUT || readCents(&price) != VALID_INPUT) {
+                printf("Invalid input.\n");
+                while (getchar() != '\n'); // Clear invalid input
+                continue;
+            }
+            if (choice == 9) {
+                deliverParcel(country, weight, price, hashTable);
+                break;
+            }
+            printf("1. New valuation\n2. New weight\n");
+            if (scanf("%d", &option) != VALID_INPUT || (option != UPDATE_VALUATION && option != UPDATE_WEIGHT)) {
+                printf("Invalid input.\n");
+                while (getchar() != '\n'); // Clear invalid input
+                continue;
+            }
+            printf((option == UPDATE_VALUATION) ? "Enter new valuation: " : "Enter new weight: ");
+            if ((option == UPDATE_VALUATION && readCents(&secondPrice) != VALID_INPUT) ||
+                (option == UPDATE_WEIGHT && scanf("%d", &secondWeight) != VALID_INPUT)) {
+                printf("Invalid input.\n");
+                while (getchar() != '\n'); // Clear invalid input
+                continue;
+            }
+            if (option == UPDATE_VALUATION)
+                updateParcel(country, weight, price, weight, secondPrice, hashTable);
+            else
+                updateParcel(country, weight, price, secondWeight, price, hashTable);
+            break;
+#ifdef PARCEL_STATS
+        case 11:
+            dumpStats(stdout);
+            break;
+#endif
         default:
             printf("Invalid choice, try again.\n");
         }
+        endRead(MAIN_READER);
     }
 }
 
-/* Initialize the hash table */
-//FUNCTION: initializeHashTable()
-//PARAMETERS: void
-//DESCRIPTION: uses dynamically allocated space to create a hash table, ensures that the root does not have dangling pointer by initializing
-// to null. the hash table is dynamically allocated in space but in consecutive blocks so it can still be accessed like an array. The
-// size is 127 as the requirements say.
-//RETURNS: hashTable - pointer to the beginning of the hashtable
-HashNode* initializeHashTable(void) {
-    HashNode* hashTable = (HashNode*)malloc(TABLE_SIZE * sizeof(HashNode));
-    if (hashTable == NULL) {
-        perror("Unable to allocate memory for hash table");
-        exit(1);
-    }
-    for (int i = 0; i < TABLE_SIZE; ++i) {
-        hashTable[i].root = NULL;
+//FUNCTION: readCents()
+//PARAMETERS: int* cents - where to put the amount
+//DESCRIPTION: reads the next word typed at the menu as an amount of dollars with parseCents(), so a typed price never goes through a float
+//RETURNS: int - VALID_INPUT if the word was an amount, like scanf() with one conversion
+int readCents(int* cents) {
+    char text[32];
+    if (scanf("%31s", text) != VALID_INPUT) {
+        return 0;
     }
-    return hashTable;
+    return parseCents(text, text + strlen(text), cents) ? VALID_INPUT : 0;
 }
 
-/* Hash function using DJB2 algorithm */
-//FUNCTION: computeHash()
-//PARAMETERS: const char* str - the name of the country
-//DESCRIPTION: using the "djb2 function", this function creates unique hash values to be stored into the binary search tree at 
-// a specific bucket index of the hash table.
-//RETURNS: unsigned long - a generated index to be used in the hash table for the country that was passed to this function
-unsigned long computeHash(const char* str) {
-    unsigned long hash = 5381;
-    int c = 0;
-    while ((c = *str++)) {
-        hash = ((hash << 5) + hash) + c;
+/* Buffered output */
+//FUNCTION: openOutput()
+//PARAMETERS: OutputBuffer* buffer, FILE* file - the buffer to set up and the file it writes to
+//DESCRIPTION: allocates the buffer's OUTPUT_BUFFER_SIZE bytes
+//RETURNS: void
+void openOutput(OutputBuffer* buffer, FILE* file) {
+    buffer->data = (char*)countedMalloc(OUTPUT_BUFFER_SIZE);
+    if (buffer->data == NULL) {
+        perror("Unable to allocate memory for output buffer");
+        exit(1);
     }
-    return hash % TABLE_SIZE;
+    buffer->used = 0;
+    buffer->capacity = OUTPUT_BUFFER_SIZE;
+    buffer->file = file;
 }
 
-/* Create a new parcel */
-//FUNCTION: createParcel()
-//PARAMETERS: const char* destination, int weight, float valuation - values that will be given to the fields of the parcel struct
-//DESCRIPTION: dynamically allocates space for the new parcel and also allocates memory for destination dynamically. 
-//RETURNS: newParcel - pointer to the new parcel or NULL if the weight and valuation is out of the range
-Parcel* createParcel(const char* destination, int weight, float valuation) {
-    if (weight > MAX_WEIGHT || weight < MIN_WEIGHT || valuation > MAX_PRICE || valuation < MIN_PRICE) {
-        return NULL;
-    }
-    Parcel* newParcel = (Parcel*)malloc(sizeof(Parcel));
-    if (newParcel == NULL) {
-        perror("Unable to allocate memory for parcel");
-        exit(1);
+//FUNCTION: closeOutput()
+//PARAMETERS: OutputBuffer* buffer - a buffer, one that was never opened is ignored
+//DESCRIPTION: flushes what is left and frees the buffer. the file is closed too unless it is stdout
+//RETURNS: void
+void closeOutput(OutputBuffer* buffer) {
+    if (buffer->file == NULL) {
+        return;
     }
-    newParcel->destination = (char*)malloc(strlen(destination) + 1);
-    if (newParcel->destination == NULL) {
-        perror("Unable to allocate memory for parcel destination");
-        exit(1);
+    flushOutput(buffer);
+    if (buffer->file != stdout) {
+        fclose(buffer->file);
     }
-    strcpy(newParcel->destination, destination);
-    newParcel->weight = weight; //if gross weight is typically between 100gms and 50 000gms do we need to validate that it's within this range
-    newParcel->valuation = valuation; //as above, range is $10 to $2000 ?????????? do we have to error check or is it just for our info
-    return newParcel;
+    free(buffer->data);
+    buffer->data = NULL;
+    buffer->file = NULL;
 }
 
-/* Insert parcel into BST */
-//FUNCTION: insertBST()
-//PARAMETERS: BSTNode* root - the root of the BST the parcel is about to be inserted into, Parcel* parcel - the new parcel node to be inserted
-//DESCRIPTION: dynamically allocates space for the parcel as a BST node, which holds a ptr to the parcel itself, as well as left and right.
-// each node in the BST represents a parcel. each node is placed using the parcel's weight. the original root is placed at random, it is 
-// assumed (hoped) that the text file is randomized enough so that the lowest or highest weighted node is not the root. the function uses
-// recusion to traverse through the tree until the condition of (root == NULL) is met, at which point the bst node will be created to insert it.
-//RETURNS: root - first the root of the node that was created, then continuing to return through the recusion until the main recieves the return value
-// of the original root of the whole bst
-BSTNode* insertBST(BSTNode* root, Parcel* parcel) {
-    if (root == NULL) {
-        BSTNode* newNode = (BSTNode*)malloc(sizeof(BSTNode));
-        if (newNode == NULL) {
-            perror("Unable to allocate memory for BST node");
-            exit(1);
-        }
-        newNode->parcel = parcel;
-        newNode->left = newNode->right = NULL;
-        return newNode;
+//FUNCTION: flushOutput()
+//PARAMETERS: OutputBuffer* buffer - the buffer to empty
+//DESCRIPTION: hands everything in the buffer to its file in one fwrite
+//RETURNS: void
+void flushOutput(OutputBuffer* buffer) {
+    if (buffer->file != NULL && buffer->used > 0) {
+        fwrite(buffer->data, 1, buffer->used, buffer->file);
+        buffer->used = 0;
     }
-    if (parcel->weight < root->parcel->weight)
-        root->left = insertBST(root->left, parcel);
-    else
-        root->right = insertBST(root->right, parcel);
-    return root;
 }
 
-/* Load data from file into hash table */
-//FUNCTION: loadData()
-//PARAMETERS: const char* filename, HashNode* hashTable - the file name from main to be opened, and the hash table to insert the countries into
-//DESCRIPTION: using FILE i/o to read from the courier.txt file. after reading the name of the country as well as it's details, the info is sent
-// to the createParcel function to create a new parcel node. the name of the country is then given a hash value from the computeHash function, which 
-// value is then used to index the hashTable. the parcel is then inserted at this index of the hashTable with the insertBST() function. the total flights 
-// then incremented to ensure that the number of flights does not exceed 5000, as per requirements state. ensures proper error checking for file io
-//RETURNS: int - success or error whether there was enough flight data read
-int loadData(const char* filename, HashNode* hashTable) {
-    FILE* pFile = fopen(filename, "r");
-    if (pFile == NULL) {
-        perror("Unable to open file\n\n");
-        exit(1);
-    }
-    int totalFlights = 0; //to ensure that the list of names is at least 2000 but does not exceed 5000
-    char destination[21];
-    int weight = 0;
-    float valuation; 
-    while ((fscanf(pFile, "%20[^,],%d,%f\n", destination, &weight, &valuation) != EOF) && totalFlights < MAX_FLIGHTS) { 
-        Parcel* parcel = createParcel(destination, weight, valuation);
-        if (parcel == NULL) { //means there was an issue with weight or valuation
-            continue;
-        }
-        unsigned long index = computeHash(destination);
-        hashTable[index].root = insertBST(hashTable[index].root, parcel);
-        totalFlights++;
-    }
-    if (ferror(pFile)) {
-        clearerr(pFile);
+//FUNCTION: flushAllOutput()
+//PARAMETERS: none
+//DESCRIPTION: flushes both global buffers. every query that writes parcel rows calls this before returning, so its rows come out before
+// anything printed with printf() afterwards
+//RETURNS: void
+void flushAllOutput(void) {
+    flushOutput(&output);
+    flushOutput(&records);
+}
+
+//FUNCTION: reserveOutput()
+//PARAMETERS: OutputBuffer* buffer, size_t size - the buffer and the most bytes about to be written
+//DESCRIPTION: flushes the buffer first if there isn't room for size more bytes
+//RETURNS: char* - where to write, the caller adds what it actually wrote to buffer->used
+char* reserveOutput(OutputBuffer* buffer, size_t size) {
+    if (buffer->used + size > buffer->capacity) {
+        flushOutput(buffer);
     }
-    if (fclose(pFile) == EOF) {
-        printf("Error closing file\n\n");
-        clearerr(pFile);
+    return buffer->data + buffer->used;
+}
+
+//FUNCTION: formatInt()
+//PARAMETERS: char* out, long long value - where to write and the number
+//DESCRIPTION: writes the number in decimal, the same digits printf("%lld") gives, without parsing a format string
+//RETURNS: char* - one past the last character written
+char* formatInt(char* out, long long value) {
+    char digits[24];
+    int count = 0;
+    unsigned long long magnitude = (value < 0) ? 0ULL - (unsigned long long)value : (unsigned long long)value;
+    if (value < 0) {
+        *out++ = '-';
     }
-    if (totalFlights < MIN_FLIGHTS)
-    {
-        return ERROR;
+    do {
+        digits[count++] = (char)('0' + magnitude % 10);
+        magnitude /= 10;
+    } while (magnitude != 0);
+    while (count > 0) {
+        *out++ = digits[--count];
     }
-    return SUCCESS;
+    return out;
 }
 
-/* Prints parcels info */
-//FUNCTION: printParcels()
-//PARAMETERS: BSTNode* root - root of a specific index of the hashtable
-//DESCRIPTION: prints the bst with in-order traversal. the argument sent to the parameter is actually the root of a specific index of the hash table
-// representing a specific country - so this function prints all the parcels of a country. this function is utilized by searchByCountry()
-//RETURNS: void
-void printParcels(BSTNode* root) {
-    if (root != NULL) {
-        printParcels(root->left);
-        printf("Destination: %s, Weight: %d, Valuation: %.2f\n",
-            root->parcel->destination, root->parcel->weight, root->parcel->valuation);
-        printParcels(root->right);
+//FUNCTION: formatValuation()
+//PARAMETERS: char* out, long long valuation - where to write and the valuation or total in cents
+//DESCRIPTION: writes the amount in dollars with two decimals, the same as printf(CENTS, DOLLARS(valuation))
+//RETURNS: char* - one past the last character written
+char* formatValuation(char* out, long long valuation) {
+    long long cents = (valuation < 0) ? -valuation : valuation;
+    if (valuation < 0) {
+        *out++ = '-';
     }
+    out = formatInt(out, cents / 100);
+    *out++ = '.';
+    *out++ = (char)('0' + (cents % 100) / 10);
+    *out++ = (char)('0' + cents % 10);
+    return out;
 }
 
-/* Search parcels by country */
-//FUNCTION: searchByCountry()
-//PARAMETERS: const char* country, HashNode* hashTable - the country to search and the entire hashtable holding all countries
-//DESCRIPTION: this function re-hashes the country name to find the index of the hash table that contains the root of the country's bst.
-// then prints the bst of that root by calling the printParcels function
+//FUNCTION: writeParcel()
+//PARAMETERS: int countryId, int weight, int valuation - the parcel
+//DESCRIPTION: writes one parcel row the way the menu prints it, "Destination: <name>, Weight: <weight>, Valuation: <valuation>", into the
+// stdout buffer, or a ParcelRecord keyed by the country ID into the records buffer with --records
 //RETURNS: void
-void searchByCountry(const char* country, HashNode* hashTable) {
-    unsigned long index = computeHash(country);
-    BSTNode* root = hashTable[index].root;
-    if (root == NULL) {
-        printf("No country found for entered country: %s\n", country);
+void writeParcel(int countryId, int weight, int valuation) {
+    if (records.file != NULL) {
+        writeRecord(countryId, weight, valuation);
         return;
     }
-    printParcels(root);
+    int length = readDictionary()->lengths[countryId];
+    char* out = reserveOutput(&output, MAX_ROW_LENGTH);
+    char* start = out;
+    memcpy(out, "Destination: ", 13);
+    memcpy(out + 13, countryName(countryId), length);
+    out += 13 + length;
+    memcpy(out, ", Weight: ", 10);
+    out = formatInt(out + 10, weight);
+    memcpy(out, ", Valuation: ", 13);
+    out = formatValuation(out + 13, valuation);
+    *out++ = '\n';
+    output.used += out - start;
 }
 
-/* Display parcels with weight higher or lower than specified */
-//FUNCTION: searchByWeightHelper()
-//PARAMETERS: BSTNode* root, int weight, int higher - the country tree to search, the weight of the country being search, and an int variable indicating
-// whether to search for higher or lower weighted parcels of the inputted weight
-//DESCRIPTION: of the root is null, it means that portion of the tree has been fully searched/is at the leaf of the bst. when deciding whether to 
-// print the higher or lower weighted parcels, the integer variable "higher" is used as a boolean value. if the inputted variable is 1 (or true, meaning to
-// search for parcels higher than) and the current parcel being searched is greater than the inputted weight, then the details of that current parcel is printed.
-// if the boolean "higher" variable is 0 (or false, meaning search for lower), the condition is not false (cancels to true) and the current parcel weight is
-// lower than the weight being compared to, the it's details are printed. the function uses in-order traversal, visiting the left subtree, the current, then right.
+//FUNCTION: writeBatchParcel()
+//PARAMETERS: OutputBuffer* out, int query, int weight, int valuation - the buffer for text results, the query's number and the parcel
+//DESCRIPTION: writes a batch P line, or a ParcelRecord keyed by the query number with --records
 //RETURNS: void
-void searchByWeightHelper(BSTNode* root, int weight, int higher) {
-    if (root == NULL) {
+void writeBatchParcel(OutputBuffer* out, int query, int weight, int valuation) {
+    if (records.file != NULL) {
+        writeRecord(query, weight, valuation);
         return;
     }
-    searchByWeightHelper(root->left, weight, higher);
-    if ((higher && root->parcel->weight > weight) ||
-        (!higher && root->parcel->weight < weight)) {
-        printf("Destination: %s, Weight: %d, Valuation: %.2f\n",
-            root->parcel->destination, root->parcel->weight, root->parcel->valuation);
-    }
-    searchByWeightHelper(root->right, weight, higher);
+    char* next = reserveOutput(out, MAX_ROW_LENGTH);
+    char* start = next;
+    *next++ = 'P';
+    *next++ = '\t';
+    next = formatInt(next, query);
+    *next++ = '\t';
+    next = formatInt(next, weight);
+    *next++ = '\t';
+    next = formatValuation(next, valuation);
+    *next++ = '\n';
+    out->used += next - start;
 }
 
-/* Main function to search parcels by weight */
-//FUNCTION: searchByWeight()
-//PARAMETERS: const char* country, int weight, int higher, HashNode* hashTable
-//DESCRIPTION: finds the hash value of the country to find the index of the hash table to send to the searchByWeightHelper() function. it also
-// sends the weight of the country being searched, as well as as an int variable called higher. higher is the menu option of 1 or 2, taken from 
-// user input in main.
+//FUNCTION: writeRecord()
+//PARAMETERS: int key, int weight, int valuation - the record's fields
+//DESCRIPTION: appends a ParcelRecord to the records buffer
 //RETURNS: void
-void searchByWeight(const char* country, int weight, int higher, HashNode* hashTable) {
-    unsigned long index = computeHash(country);
-    BSTNode* root = hashTable[index].root;
-    searchByWeightHelper(root, weight, higher);
+void writeRecord(int key, int weight, int valuation) {
+    ParcelRecord record;
+    record.key = key;
+    record.weight = weight;
+    record.valuation = valuation;
+    memcpy(reserveOutput(&records, sizeof(record)), &record, sizeof(record));
+    records.used += sizeof(record);
 }
 
-/* Calculate total parcel load and valuation for a country */
-//FUNCTION: calculateTotalLoadAndValuation()
-//PARAMETERS: const char* country, HashNode* hashTable - country being calculated and hashtable to get the country info from
-//DESCRIPTION: takes the country being searched for and finds the hash value to access the index of the hashtable which contains the bst for the country.
-// it then traverses through the bst to find the total weight and valuation, and finally prints the total two values.
+//FUNCTION: writeFormatted()
+//PARAMETERS: OutputBuffer* buffer, const char* format, ... - the buffer and a printf() format with its arguments
+//DESCRIPTION: printf() into the buffer, for the occasional line that isn't a parcel row so it stays in order with the rows around it
 //RETURNS: void
-void calculateTotalLoadAndValuation(const char* country, HashNode* hashTable) {
-    unsigned long index = computeHash(country);
-    BSTNode* root = hashTable[index].root;
-    int totalWeight = 0;
-    float totalValuation = 0.0;
-
-    // traverse the BST and accumulate weights and valuations
-    traverseAndAddBST(root, totalWeight, totalValuation);
-
-    printf("Total Load: %d grams, Total Valuation: $%.2f\n", totalWeight, totalValuation);
-}
-
-/* Display the cheapest and most expensive parcels */
-//FUNCTION: displayCheapestAndMostExpensive()
-//PARAMETERS: const char* country, HashNode* hashTable - country being calculated and hashtable to get the country info from
-//DESCRIPTION: takes the country being searched for and finds the hash value to access the index of the hashtable which contains the bst for the country.
-// first the pointer variables for cheapest and most expensive point to the current root's parcelc, the parcel that these pointers point to is expected to change
-// when sent to the findLowestPrice() and findHighestPrice() functions. the root of the hash table is sent to these two functions with the pointers to the
-// cheaptest / most expensive, as the functions traverse it will point to the parcel that is true of the condition (of either cheapest or most expensive). it 
-// then prints the information of the parcels that these pointers point to.
-//RETURNS: void
-void displayCheapestAndMostExpensive(const char* country, HashNode* hashTable) {
-    unsigned long index = computeHash(country);
-    BSTNode* root = hashTable[index].root;
-    if (root == NULL) {
-        printf("No parcels found for country %s\n", country);
-        return;
+void writeFormatted(OutputBuffer* buffer, const char* format, ...) {
+    va_list arguments;
+    va_start(arguments, format);
+    char* out = reserveOutput(buffer, MAX_BATCH_LINE + MAX_ROW_LENGTH);
+    int length = vsnprintf(out, buffer->capacity - buffer->used, format, arguments);
+    va_end(arguments);
+    if (length > 0) {
+        buffer->used += ((size_t)length < buffer->capacity - buffer->used) ? (size_t)length : buffer->capacity - buffer->used - 1;
     }
-    Parcel* cheapest = root->parcel;
-    Parcel* mostExpensive = root->parcel;
-
-    findLowestPrice(root, &cheapest);
-    findHighestPrice(root, &mostExpensive);
-
-    printf("Cheapest Parcel - Destination: %s, Weight: %d, Valuation: %.2f\n",
-        cheapest->destination, cheapest->weight, cheapest->valuation);
-    printf("Most Expensive Parcel - Destination: %s, Weight: %d, Valuation: %.2f\n",
-        mostExpensive->destination, mostExpensive->weight, mostExpensive->valuation);
 }
 
-//FUNCTION: findLowestPrice()
-//PARAMETERS: BSTNode* root, Parcel** cheapestParcel - the bst tree to search and a pointer that will point to the cheapest parcel
-//DESCRIPTION: the function uses pre-order traversal. it evaluates the lowest price condition by checking if the current parcel's
-// valuation is less than what the cheapestParcel pointer's valuation is. if the current parcel's valuation is cheaper, then the 
-// pointer then points to the current parcel. then it traverses the left, then the right sub tree. searching the entire tree to assign
-// the cheapestParcel the lowest value.
-//RETURNS: void - the pointer does not need to be returned since it's being passed by reference.
-void findLowestPrice(BSTNode* root, Parcel** cheapestParcel) {
-    if (root == NULL) {
+//FUNCTION: benchmarkOutput()
+//PARAMETERS: HashTable* hashTable - the loaded table
+//DESCRIPTION: writes every parcel, repeated until about OUTPUT_BENCH_PARCELS rows, to the null device three ways: printf() per row like the
+// menu used to, formatted text through the output buffer, and binary records. it first checks the fast formatter gives exactly the bytes
+// printf() does for every parcel
+//RETURNS: void
+void benchmarkOutput(HashTable* hashTable) {
+#ifdef _WIN32
+    const char* nullDevice = "NUL";
+#else
+    const char* nullDevice = "/dev/null";
+#endif
+    int countries = countryDictionary.count;
+    int parcels = 0;
+    for (int id = 0; id < countries; ++id) {
+        BSTNode* root = countryNode(hashTable, id)->root;
+        parcels += (root == NULL) ? 0 : root->subtree.count;
+    }
+    if (parcels == 0) {
         return;
     }
-    //check if the current node's price is lower than the price from the previous root
-    if (root->parcel->valuation < (*cheapestParcel)->valuation) {
-        *cheapestParcel = root->parcel;
+    int rounds = (OUTPUT_BENCH_PARCELS + parcels - 1) / parcels;
+    OutputBuffer saved = output;
+    OutputBuffer savedRecords = records;
+    int mismatches = 0;
+    char expected[MAX_ROW_LENGTH];
+    for (int id = 0; id < countries; ++id) {
+        WeightCursor cursor;
+        openWeightCursor(&cursor, countryNode(hashTable, id)->root, INT_MIN, INT_MAX);
+        for (BSTNode* node = nextWeightCursor(&cursor); node != NULL; node = nextWeightCursor(&cursor)) {
+            int length = snprintf(expected, sizeof(expected), "Destination: %s, Weight: %d, Valuation: " CENTS "\n",
+                countryName(id), node->parcel->weight, DOLLARS(node->parcel->valuation));
+            output.used = 0;
+            records.file = NULL;
+            writeParcel(id, node->parcel->weight, node->parcel->valuation);
+            if ((int)output.used != length || memcmp(output.data, expected, length) != 0) {
+                mismatches++;
+            }
+        }
+        closeTreeCursor(&cursor);
     }
+    output.used = 0;
 
-    findLowestPrice(root->left, cheapestParcel); //traverse through the whole bst
-    findLowestPrice(root->right, cheapestParcel);
+    const char* formats[] = { "printf", "buffered text", "binary records" };
+    for (int format = 0; format < 3; ++format) {
+        FILE* sink = fopen(nullDevice, "wb");
+        if (sink == NULL) {
+            perror("Unable to open the null device");
+            break;
+        }
+        output.file = (format == 1) ? sink : NULL;
+        records.file = (format == 2) ? sink : NULL;
+        if (format == 2) {
+            records.data = (char*)countedMalloc(OUTPUT_BUFFER_SIZE);
+            if (records.data == NULL) {
+                perror("Unable to allocate memory for output buffer");
+                exit(1);
+            }
+            records.capacity = OUTPUT_BUFFER_SIZE;
+            records.used = 0;
+        }
+        double start = nowSeconds();
+        for (int round = 0; round < rounds; ++round) {
+            for (int id = 0; id < countries; ++id) {
+                WeightCursor cursor;
+                openWeightCursor(&cursor, countryNode(hashTable, id)->root, INT_MIN, INT_MAX);
+                for (BSTNode* node = nextWeightCursor(&cursor); node != NULL; node = nextWeightCursor(&cursor)) {
+                    if (format == 0) {
+                        fprintf(sink, "Destination: %s, Weight: %d, Valuation: " CENTS "\n",
+                            countryName(node->parcel->countryId), node->parcel->weight, DOLLARS(node->parcel->valuation));
+                    }
+                    else {
+                        writeParcel(node->parcel->countryId, node->parcel->weight, node->parcel->valuation);
+                    }
+                }
+                closeTreeCursor(&cursor);
+            }
+        }
+        flushAllOutput();
+        fflush(sink);
+        double seconds = nowSeconds() - start;
+        fclose(sink);
+        if (format == 2) {
+            free(records.data);
+        }
+        double rows = (double)rounds * parcels;
+        printf("%-15s %9.3f ms  %7.2f M rows/s\n", formats[format], seconds * 1000.0, rows / seconds / 1e6);
+    }
+    output = saved;
+    records = savedRecords;
+    printf("%d rows formatted, %d differ from printf\n", parcels, mismatches);
 }
 
-//FUNCTION: findHighestPrice()
-//PARAMETERS: BSTNode* root, Parcel** expensiveParcel - the bst tree to search and a pointer that will point to the most expensive parcel
-//DESCRIPTION: the function uses pre-order traversal. it evaluates the highest price condition by checking if the current parcel's
-// valuation is greater than what the expensiveParcel pointer's valuation is. if the current parcel's valuation is more expensive, then the 
-// pointer then points to the current parcel. then it traverses the left, then the right sub tree. searching the entire tree to assign
-// the expensiveParcel the greatest value.
-//RETURNS: void - the pointer does not need to be returned since it's being passed by reference.
-void findHighestPrice(BSTNode* root, Parcel** expensiveParcel) {
+/* Batch queries */
+//FUNCTION: runBatch()
+//PARAMETERS: const char* path, HashTable* hashTable, ColumnStore* columns - the query file ("-" for stdin), the loaded table and the column
+// store, NULL unless the column engine is in use
+//DESCRIPTION: runs every query in the file back to back without the menu. a query is one line, comma separated like courier.txt, so country
+// names can have spaces in them:
+//   list,<country>                      every parcel of the country
+//   above,<country>,<weight>            parcels heavier than weight
+//   below,<country>,<weight>            parcels lighter than weight
+//   range,<country>,<min>,<max>         parcels from min to max grams
+//   count,<country>,<min>,<max>         how many parcels are from min to max grams
+//   total,<country>[,<min>,<max>]       count, load and valuation of the country, or of the parcels from min to max grams
+//   prices,<country>                    cheapest and most expensive parcel
+//   extremes,<country>                  lightest and heaviest parcel
+//   report                              totals, weights and prices of every destination
+// blank lines and lines starting with # are skipped. results go to stdout one per line, tab separated, tagged with the kind of line and the
+// query's number (its place among the queries, from 1):
+//   P <query> <weight> <valuation>      a parcel
+//   C <query> <count>                   a count
+//   T <query> <count> <load> <valuation>  totals
+//   E <query> <message>                 the query couldn't be run
+//   R <query> <destination> <count> <load> <valuation> <lightest> <heaviest> <cheapest> <most expensive>  a report row
+//   Q <query> <rows>                    end of a query and how many P lines it gave
+// with --records the P lines are left out and each parcel is written to the records file with the query number as its key. the number of
+// queries, result rows, queries per second and the spread of query latencies are reported on stderr at the end, like the load messages
+// before them, so they don't mix with the results. every query reads the newest view while --follow is running
+//RETURNS: int - SUCCESS, or ERROR if the file couldn't be opened or any query failed
+int runBatch(const char* path, HashTable* hashTable, ColumnStore* columns) {
+    FILE* pFile = (strcmp(path, "-") == 0) ? stdin : fopen(path, "r");
+    if (pFile == NULL) {
+        perror("Unable to open batch file");
+        return ERROR;
+    }
+    char line[MAX_BATCH_LINE];
+    int queries = 0;
+    int failed = 0;
+    long long rows = 0;
+    double* latencies = NULL;
+    int latencyCount = 0;
+    int latencyCapacity = 0;
+    double start = nowSeconds();
+    while (fgets(line, sizeof(line), pFile) != NULL) {
+        size_t length = strlen(line);
+        if (length == sizeof(line) - 1 && line[length - 1] != '\n') {
+            int skipped;
+            while ((skipped = fgetc(pFile)) != EOF && skipped != '\n');
+            queries++;
+            failed++;
+            writeFormatted(&output, "E\t%d\tline too long\n", queries);
+            continue;
+        }
+        while (length > 0 && (line[length - 1] == '\n' || line[length - 1] == '\r')) {
+            line[--length] = '\0';
+        }
+        if (length == 0 || line[0] == '#') {
+            continue;
+        }
+        queries++;
+        double queryStart = nowSeconds();
+        int result = runBatchQuery(line, queries, beginRead(hashTable, MAIN_READER), columns, &output);
+        endRead(MAIN_READER);
+        latencies = appendSample(latencies, &latencyCount, &latencyCapacity, nowSeconds() - queryStart);
+        if (result < 0) {
+            failed++;
+        }
+        else {
+            rows += result;
+        }
+    }
+    flushAllOutput();
+    fflush(stdout);
+    double seconds = nowSeconds() - start;
+    if (pFile != stdin) {
+        fclose(pFile);
+    }
+    fprintf(stderr, "Ran %d queries (%d failed), %lld result rows in %.3f ms: %.0f queries/s, %.0f rows/s\n", queries, failed, rows,
+        seconds * 1000.0, (seconds > 0.0) ? queries / seconds : 0.0, (seconds > 0.0) ? rows / seconds : 0.0);
+    printPercentiles(stderr, "Query latency", latencies, latencyCount);
+    free(latencies);
+    return (failed > 0) ? ERROR : SUCCESS;
+}
+
+//FUNCTION: runBatchQuery()
+//PARAMETERS: char* line, int query, HashTable* hashTable, ColumnStore* columns, OutputBuffer* out - one query line without its newline (it gets
+// split in place), the query's number, the table, the column store (NULL for the tree engine) and where the results go
+//DESCRIPTION: splits the line into the verb, the country and up to two numbers, resolves the country once, and runs the query on whichever
+// engine is loaded. it writes the query's result lines and then its Q line, or a single E line if the query is bad
+//RETURNS: int - the number of parcel lines written, or -1 if the query failed
+int runBatchQuery(char* line, int query, HashTable* hashTable, ColumnStore* columns, OutputBuffer* out) {
+    PROBE(PROBE_BATCH_QUERY);
+    if (strcmp(line, "report") == 0) {
+        batchReport(out, query, hashTable, columns);
+        writeFormatted(out, "Q\t%d\t0\n", query);
+        return 0;
+    }
+    char* verb = line;
+    char* country = strchr(line, ',');
+    if (country == NULL) {
+        writeFormatted(out, "E\t%d\tmissing country\n", query);
+        return -1;
+    }
+    *country++ = '\0';
+    char* numbers = strchr(country, ',');
+    if (numbers != NULL) {
+        *numbers++ = '\0';
+    }
+    int arguments = batchArguments(verb);
+    if (arguments == 0) {
+        writeFormatted(out, "E\t%d\tunknown query %s\n", query, verb);
+        return -1;
+    }
+    int first = 0;
+    int second = 0;
+    int numberCount = (numbers == NULL) ? 0 : parseBatchNumbers(numbers, &first, &second);
+    if (numberCount < 0) {
+        writeFormatted(out, "E\t%d\tbad number in %s\n", query, verb);
+        return -1;
+    }
+    if (numberCount > 2 || (arguments & (1 << numberCount)) == 0) {
+        writeFormatted(out, "E\t%d\twrong number of arguments for %s\n", query, verb);
+        return -1;
+    }
+    int countryId = findCountry(country);
+    if (!hasParcels(hashTable, columns, countryId)) {
+        writeFormatted(out, "E\t%d\tno parcels for %s\n", query, country);
+        return -1;
+    }
+
+    int rows = 0;
+    if (strcmp(verb, "list") == 0) {
+        rows = batchWeightRange(out, query, hashTable, columns, countryId, INT_MIN, INT_MAX);
+    }
+    else if (strcmp(verb, "above") == 0) {
+        rows = (first == INT_MAX) ? 0 : batchWeightRange(out, query, hashTable, columns, countryId, first + 1, INT_MAX);
+    }
+    else if (strcmp(verb, "below") == 0) {
+        rows = (first == INT_MIN) ? 0 : batchWeightRange(out, query, hashTable, columns, countryId, INT_MIN, first - 1);
+    }
+    else if (strcmp(verb, "range") == 0) {
+        rows = batchWeightRange(out, query, hashTable, columns, countryId, first, second);
+    }
+    else if (strcmp(verb, "count") == 0) {
+        writeFormatted(out, "C\t%d\t%d\n", query, countRange(hashTable, columns, countryId, first, second));
+    }
+    else if (strcmp(verb, "total") == 0) {
+        batchTotals(out, query, hashTable, columns, countryId, (numberCount == 0) ? INT_MIN : first, (numberCount == 0) ? INT_MAX : second);
+    }
+    else if (strcmp(verb, "prices") == 0) {
+        rows = batchExtremes(out, query, hashTable, columns, countryId, 1);
+    }
+    else {
+        rows = batchExtremes(out, query, hashTable, columns, countryId, 0);
+    }
+    writeFormatted(out, "Q\t%d\t%d\n", query, rows);
+    return rows;
+}
+
+//FUNCTION: batchArguments()
+//PARAMETERS: const char* verb - the first word of a batch query
+//DESCRIPTION: looks up how many numbers the query takes after its country
+//RETURNS: int - bit n set if the query takes n numbers, 0 if the verb isn't a query
+int batchArguments(const char* verb) {
+    if (strcmp(verb, "list") == 0 || strcmp(verb, "prices") == 0 || strcmp(verb, "extremes") == 0) {
+        return 1 << 0;
+    }
+    if (strcmp(verb, "above") == 0 || strcmp(verb, "below") == 0) {
+        return 1 << 1;
+    }
+    if (strcmp(verb, "range") == 0 || strcmp(verb, "count") == 0) {
+        return 1 << 2;
+    }
+    if (strcmp(verb, "total") == 0) {
+        return (1 << 0) | (1 << 2);
+    }
+    return 0;
+}
+
+//FUNCTION: parseBatchNumbers()
+//PARAMETERS: const char* numbers, int* first, int* second - the text after the country and where to put the numbers
+//DESCRIPTION: reads the comma separated numbers and keeps the first two. every one has to be a whole int with nothing else around it
+//RETURNS: int - how many numbers there are, or -1 if any of them isn't a number
+int parseBatchNumbers(const char* numbers, int* first, int* second) {
+    int count = 0;
+    while (true) {
+        char* end = NULL;
+        errno = 0;
+        long number = strtol(numbers, &end, 10);
+        if (end == numbers || errno == ERANGE || number < INT_MIN || number > INT_MAX || (*end != ',' && *end != '\0')) {
+            return -1;
+        }
+        if (count == 0) {
+            *first = (int)number;
+        }
+        else if (count == 1) {
+            *second = (int)number;
+        }
+        count++;
+        if (*end == '\0') {
+            return count;
+        }
+        numbers = end + 1;
+    }
+}
+
+//FUNCTION: batchWeightRange()
+//PARAMETERS: OutputBuffer* out, int query, HashTable* hashTable, ColumnStore* columns, int countryId, int minWeight, int maxWeight - where the
+// results go, the query's number, the two engines (columns is NULL for the tree engine), the country and the inclusive range of weights
+//DESCRIPTION: writes a P line for every parcel of the country in the range, in weight order, with a cursor on the tree engine or the
+// binary searched rows on the column engine
+//RETURNS: int - the number of P lines written
+int batchWeightRange(OutputBuffer* out, int query, HashTable* hashTable, ColumnStore* columns, int countryId, int minWeight, int maxWeight) {
+    int rows = 0;
+    if (columns != NULL) {
+        int end = columns->offsets[countryId + 1];
+        int row = lowerBoundColumns(columns, columns->offsets[countryId], end, minWeight);
+        end = upperBoundColumns(columns, row, end, maxWeight);
+        for (; row < end; ++row, ++rows) {
+            writeBatchParcel(out, query, columns->weights[row], columns->valuations[row]);
+        }
+        return rows;
+    }
+    WeightCursor cursor;
+    openWeightCursor(&cursor, countryNode(hashTable, countryId)->root, minWeight, maxWeight);
+    for (BSTNode* node = nextWeightCursor(&cursor); node != NULL; node = nextWeightCursor(&cursor), ++rows) {
+        writeBatchParcel(out, query, node->parcel->weight, node->parcel->valuation);
+    }
+    closeTreeCursor(&cursor);
+    return rows;
+}
+
+//FUNCTION: batchExtremes()
+//PARAMETERS: OutputBuffer* out, int query, HashTable* hashTable, ColumnStore* columns, int countryId, int byPrice - same as batchWeightRange(), and
+// 1 for the cheapest and most expensive parcel or 0 for the lightest and heaviest
+//DESCRIPTION: writes two P lines from findExtremes(), the low end first
+//RETURNS: int - the number of P lines written, always 2
+int batchExtremes(OutputBuffer* out, int query, HashTable* hashTable, ColumnStore* columns, int countryId, int byPrice) {
+    Parcel low;
+    Parcel high;
+    findExtremes(hashTable, columns, countryId, byPrice, &low, &high);
+    writeBatchParcel(out, query, low.weight, low.valuation);
+    writeBatchParcel(out, query, high.weight, high.valuation);
+    return 2;
+}
+
+//FUNCTION: batchTotals()
+//PARAMETERS: OutputBuffer* out, int query, HashTable* hashTable, ColumnStore* columns, int countryId, int minWeight, int maxWeight - same as
+// batchWeightRange()
+//DESCRIPTION: writes the T line for the parcels in the range
+//RETURNS: void
+void batchTotals(OutputBuffer* out, int query, HashTable* hashTable, ColumnStore* columns, int countryId, int minWeight, int maxWeight) {
+    ParcelTotals totals;
+    sumRange(hashTable, columns, countryId, minWeight, maxWeight, &totals);
+    writeFormatted(out, "T\t%d\t%d\t%lld\t" CENTS "\n", query, totals.count, totals.weight, DOLLARS(totals.valuation));
+}
+
+//FUNCTION: hasParcels()
+//PARAMETERS: HashTable* hashTable, ColumnStore* columns, int countryId - the table, the column store (NULL for the tree engine) and a country
+// ID from findCountry() or lookupCountry(), which may be NO_COUNTRY
+//DESCRIPTION: checks a country can be queried. on the column engine a country without rows still can, its ranges are just empty
+//RETURNS: int - 1 if it can, 0 if not
+int hasParcels(HashTable* hashTable, ColumnStore* columns, int countryId) {
+    if (countryId == NO_COUNTRY) {
+        return 0;
+    }
+    return columns != NULL || (countryId < hashTable->capacity && hashTable->nodes[countryId].root != NULL);
+}
+
+//FUNCTION: countRange()
+//PARAMETERS: HashTable* hashTable, ColumnStore* columns, int countryId, int minWeight, int maxWeight - same as batchWeightRange() without the
+// output
+//DESCRIPTION: counts the country's parcels in the range, from the subtree counts on the tree engine or the two binary searches on the
+// column engine
+//RETURNS: int - the number of parcels
+int countRange(HashTable* hashTable, ColumnStore* columns, int countryId, int minWeight, int maxWeight) {
+    if (columns != NULL) {
+        int begin = lowerBoundColumns(columns, columns->offsets[countryId], columns->offsets[countryId + 1], minWeight);
+        return upperBoundColumns(columns, begin, columns->offsets[countryId + 1], maxWeight) - begin;
+    }
+    return countWeightRange(countryNode(hashTable, countryId)->root, minWeight, maxWeight);
+}
+
+//FUNCTION: sumRange()
+//PARAMETERS: HashTable* hashTable, ColumnStore* columns, int countryId, int minWeight, int maxWeight, ParcelTotals* totals - same as
+// countRange(), and the totals to fill in
+//DESCRIPTION: adds up the parcels in the range, from the subtree totals on the tree engine or by adding up the rows on the column engine
+//RETURNS: void
+void sumRange(HashTable* hashTable, ColumnStore* columns, int countryId, int minWeight, int maxWeight, ParcelTotals* totals) {
+    clearTotals(totals);
+    if (columns != NULL) {
+        int end = columns->offsets[countryId + 1];
+        int begin = lowerBoundColumns(columns, columns->offsets[countryId], end, minWeight);
+        sumColumns(columns, begin, upperBoundColumns(columns, begin, end, maxWeight), totals);
+    }
+    else {
+        sumWeightRange(countryNode(hashTable, countryId)->root, minWeight, maxWeight, totals);
+    }
+}
+
+//FUNCTION: findExtremes()
+//PARAMETERS: HashTable* hashTable, ColumnStore* columns, int countryId, int byPrice, Parcel* low, Parcel* high - same as batchExtremes(), and
+// where to copy the two parcels
+//DESCRIPTION: finds the cheapest and most expensive or the lightest and heaviest parcel of a country that has some. prices come from
+// priceExtremes(), which only reads the trees, or the price order, weights from the ends of the weight tree or of the country's rows
+//RETURNS: void
+void findExtremes(HashTable* hashTable, ColumnStore* columns, int countryId, int byPrice, Parcel* low, Parcel* high) {
+    if (columns != NULL) {
+        int begin = columns->offsets[countryId];
+        int end = columns->offsets[countryId + 1] - 1;
+        if (byPrice) {
+            begin = columns->priceOrder[begin];
+            end = columns->priceOrder[end];
+        }
+        low->countryId = countryId;
+        low->weight = columns->weights[begin];
+        low->valuation = columns->valuations[begin];
+        high->countryId = countryId;
+        high->weight = columns->weights[end];
+        high->valuation = columns->valuations[end];
+        return;
+    }
+    HashNode* node = countryNode(hashTable, countryId);
+    if (byPrice) {
+        Parcel* cheapest = NULL;
+        Parcel* mostExpensive = NULL;
+        priceExtremes(node, &cheapest, &mostExpensive);
+        *low = *cheapest;
+        *high = *mostExpensive;
+    }
+    else {
+        BSTNode* lightest = node->root;
+        BSTNode* heaviest = node->root;
+        while (lightest->left != NULL) {
+            lightest = lightest->left;
+        }
+        while (heaviest->right != NULL) {
+            heaviest = heaviest->right;
+        }
+        *low = *lightest->parcel;
+        *high = *heaviest->parcel;
+    }
+}
+
+/* Report of every destination */
+//FUNCTION: reportAll()
+//PARAMETERS: HashTable* hashTable, ColumnStore* columns, int threads, CountryReport** reports - the table, the column store (NULL for the tree
+// engine), how many threads to split the destinations over and where to put the report
+//DESCRIPTION: works out the count, load, valuation, weight range and price range of every destination in one sweep, with the destinations
+// dealt out to the threads like the loader's merge does, then drops the ones without parcels and sorts the rest by name. on the tree engine
+// a destination's row is its root's subtree totals and the two ends of its tree, on the column engine it is a scan of its rows
+//RETURNS: int - the number of rows in the report, which the caller frees
+int reportAll(HashTable* hashTable, ColumnStore* columns, int threads, CountryReport** reports) {
+    int countries = (columns != NULL) ? columns->countryCount : readDictionary()->count;
+    CountryReport* rows = (CountryReport*)countedMalloc(((countries > 0) ? countries : 1) * sizeof(CountryReport));
+    if (rows == NULL) {
+        perror("Unable to allocate memory for report");
+        exit(1);
+    }
+    if (threads > countries) {
+        threads = (countries > 0) ? countries : 1;
+    }
+    if (threads <= 1) {
+        reportCountries(hashTable, columns, rows, countries, 0, 1);
+    }
+    else {
+        std::thread* workers = new std::thread[threads];
+        for (int i = 0; i < threads; ++i) {
+            workers[i] = std::thread(reportCountries, hashTable, columns, rows, countries, i, threads);
+        }
+        for (int i = 0; i < threads; ++i) {
+            workers[i].join();
+        }
+        delete[] workers;
+    }
+    int count = 0;
+    for (int id = 0; id < countries; ++id) {
+        if (rows[id].totals.count > 0) {
+            rows[count++] = rows[id];
+        }
+    }
+    qsort(rows, count, sizeof(CountryReport), compareReports);
+    *reports = rows;
+    return count;
+}
+
+//FUNCTION: reportCountries()
+//PARAMETERS: HashTable* hashTable, ColumnStore* columns, CountryReport* reports, int countries, int first, int step - the engines, the report
+// with a row for every country ID, how many there are, and the first ID this thread does and the gap to the next
+//DESCRIPTION: fills in the rows of countries first, first + step and so on. a destination without parcels gets a count of 0
+//RETURNS: void
+void reportCountries(HashTable* hashTable, ColumnStore* columns, CountryReport* reports, int countries, int first, int step) {
+    for (int id = first; id < countries; id += step) {
+        CountryReport* row = &reports[id];
+        row->countryId = id;
+        row->minWeight = 0;
+        row->maxWeight = 0;
+        clearTotals(&row->totals);
+        if (columns != NULL) {
+            int begin = columns->offsets[id];
+            int end = columns->offsets[id + 1];
+            if (begin < end) {
+                sumColumns(columns, begin, end, &row->totals);
+                row->minWeight = columns->weights[begin];
+                row->maxWeight = columns->weights[end - 1];
+            }
+            continue;
+        }
+        if (!hasParcels(hashTable, columns, id)) {
+            continue;
+        }
+        BSTNode* lightest = countryNode(hashTable, id)->root;
+        BSTNode* heaviest = lightest;
+        row->totals = lightest->subtree;
+        while (lightest->left != NULL) {
+            lightest = lightest->left;
+        }
+        while (heaviest->right != NULL) {
+            heaviest = heaviest->right;
+        }
+        row->minWeight = lightest->weight;
+        row->maxWeight = heaviest->weight;
+    }
+}
+
+//FUNCTION: compareReports()
+//PARAMETERS: const void* first, const void* second - two CountryReports
+//DESCRIPTION: qsort() comparison by destination name
+//RETURNS: int - negative, zero or positive like strcmp()
+int compareReports(const void* first, const void* second) {
+    return strcmp(countryName(((const CountryReport*)first)->countryId), countryName(((const CountryReport*)second)->countryId));
+}
+
+//FUNCTION: printReport()
+//PARAMETERS: HashTable* hashTable, ColumnStore* columns - the table and the column store, NULL unless the column engine is in use
+//DESCRIPTION: prints the report of every destination as a table sorted by name, with the whole table's totals at the bottom. used by
+// --report-all, the report is built on all the machine's cores
+//RETURNS: void
+void printReport(HashTable* hashTable, ColumnStore* columns) {
+    int threads = (int)std::thread::hardware_concurrency();
+    CountryReport* reports = NULL;
+    double start = nowSeconds();
+    int count = reportAll(beginRead(hashTable, MAIN_READER), columns, threads, &reports);
+    double seconds = nowSeconds() - start;
+    ParcelTotals all;
+    clearTotals(&all);
+    char amounts[3][32];
+    printf("%-24s %9s %14s %16s %8s %8s %9s %9s\n", "Destination", "Parcels", "Load (g)", "Valuation", "Lightest", "Heaviest", "Cheapest",
+        "Priciest");
+    for (int i = 0; i < count; ++i) {
+        const CountryReport* row = &reports[i];
+        *formatValuation(amounts[0], row->totals.valuation) = '\0';
+        *formatValuation(amounts[1], row->totals.minValuation) = '\0';
+        *formatValuation(amounts[2], row->totals.maxValuation) = '\0';
+        printf("%-24s %9d %14lld %16s %8d %8d %9s %9s\n", countryName(row->countryId), row->totals.count, row->totals.weight, amounts[0],
+            row->minWeight, row->maxWeight, amounts[1], amounts[2]);
+        addTotals(&all, &row->totals);
+    }
+    endRead(MAIN_READER);
+    *formatValuation(amounts[0], all.valuation) = '\0';
+    printf("%-24s %9d %14lld %16s\n", "All destinations", all.count, all.weight, amounts[0]);
+    printf("Reported %d destinations on %d threads in %.3f ms\n", count, (threads > 1) ? threads : 1, seconds * 1000.0);
+    free(reports);
+}
+
+//FUNCTION: batchReport()
+//PARAMETERS: OutputBuffer* out, int query, HashTable* hashTable, ColumnStore* columns - same as batchTotals() without a country
+//DESCRIPTION: writes an R line for every destination with parcels, sorted by name. batch queries run one at a time, so the report is built
+// on the calling thread
+//RETURNS: void
+void batchReport(OutputBuffer* out, int query, HashTable* hashTable, ColumnStore* columns) {
+    CountryReport* reports = NULL;
+    int count = reportAll(hashTable, columns, 1, &reports);
+    for (int i = 0; i < count; ++i) {
+        const CountryReport* row = &reports[i];
+        writeFormatted(out, "R\t%d\t%s\t%d\t%lld\t" CENTS "\t%d\t%d\t" CENTS "\t" CENTS "\n", query, countryName(row->countryId),
+            row->totals.count, row->totals.weight, DOLLARS(row->totals.valuation), row->minWeight, row->maxWeight,
+            DOLLARS(row->totals.minValuation), DOLLARS(row->totals.maxValuation));
+    }
+    free(reports);
+}
+
+//FUNCTION: benchmarkReport()
+//PARAMETERS: HashTable* hashTable, ColumnStore* columns - the table and the column store, NULL unless the column engine is in use
+//DESCRIPTION: builds the report of every destination REPORT_BENCH_ROUNDS times three ways: by calling the menu's total, lightest and heaviest,
+// and cheapest and most expensive functions for every destination with stdout sent to the null device, with reportAll() on one thread,
+// and with reportAll() on every core. checks both reports agree with each other and with sumRange() and findExtremes() for every
+// destination
+//RETURNS: int - SUCCESS, or ERROR if a check failed
+int benchmarkReport(HashTable* hashTable, ColumnStore* columns) {
+    int countries = countryDictionary.count;
+    int threads = (int)std::thread::hardware_concurrency();
+    double seconds[3];
+    flushOutput(&output);
+    fflush(stdout);
+    int savedStdout = dup(fileno(stdout));
+    FILE* nullDevice = fopen(NULL_DEVICE, "w");
+    if (savedStdout < 0 || nullDevice == NULL) {
+        perror("Unable to open the null device");
+        exit(1);
+    }
+    dup2(fileno(nullDevice), fileno(stdout));
+    double start = nowSeconds();
+    for (int round = 0; round < REPORT_BENCH_ROUNDS; ++round) {
+        for (int id = 0; id < countries; ++id) {
+            const char* country = countryName(id);
+            if (columns != NULL) {
+                calculateTotalLoadAndValuationColumns(country, columns);
+                displayLightestAndHeaviestColumns(country, columns);
+                displayCheapestAndMostExpensiveColumns(country, columns);
+            }
+            else {
+                calculateTotalLoadAndValuation(country, hashTable);
+                displayLightestAndHeaviest(country, hashTable);
+                displayCheapestAndMostExpensive(country, hashTable);
+            }
+        }
+        fflush(stdout);
+    }
+    seconds[0] = nowSeconds() - start;
+    dup2(savedStdout, fileno(stdout));
+    close(savedStdout);
+    fclose(nullDevice);
+
+    CountryReport* serial = NULL;
+    CountryReport* parallel = NULL;
+    int serialCount = 0;
+    int parallelCount = 0;
+    for (int way = 1; way <= 2; ++way) {
+        start = nowSeconds();
+        for (int round = 0; round < REPORT_BENCH_ROUNDS; ++round) {
+            CountryReport** reports = (way == 1) ? &serial : &parallel;
+            free(*reports);
+            int count = reportAll(hashTable, columns, (way == 1) ? 1 : threads, reports);
+            *((way == 1) ? &serialCount : &parallelCount) = count;
+        }
+        seconds[way] = nowSeconds() - start;
+    }
+    int mismatches = (serialCount != parallelCount) ? 1 : 0;
+    for (int i = 0; i < serialCount && i < parallelCount; ++i) {
+        const CountryReport* row = &serial[i];
+        ParcelTotals totals;
+        Parcel lightest;
+        Parcel heaviest;
+        Parcel cheapest;
+        Parcel priciest;
+        sumRange(hashTable, columns, row->countryId, INT_MIN, INT_MAX, &totals);
+        findExtremes(hashTable, columns, row->countryId, 0, &lightest, &heaviest);
+        findExtremes(hashTable, columns, row->countryId, 1, &cheapest, &priciest);
+        if (row->countryId != parallel[i].countryId || row->totals.valuation != parallel[i].totals.valuation ||
+            row->totals.count != totals.count || row->totals.weight != totals.weight || row->totals.valuation != totals.valuation ||
+            row->minWeight != lightest.weight || row->maxWeight != heaviest.weight || row->totals.minValuation != cheapest.valuation ||
+            row->totals.maxValuation != priciest.valuation) {
+            mismatches++;
+        }
+    }
+    free(serial);
+    free(parallel);
+    const char* ways[] = { "per-country functions", "report, 1 thread", "report, all threads" };
+    printf("%d rounds of a report on %d destinations, %u hardware threads:\n", REPORT_BENCH_ROUNDS, countries, (unsigned int)threads);
+    for (int way = 0; way < 3; ++way) {
+        printf("  %-22s %10.3f ms per report\n", ways[way], seconds[way] * 1000.0 / REPORT_BENCH_ROUNDS);
+    }
+    printf("%d destinations differ: %s\n", mismatches, (mismatches == 0) ? "passed" : "FAILED");
+    return (mismatches == 0) ? SUCCESS : ERROR;
+}
+
+/* Query server */
+#ifdef __linux__
+volatile sig_atomic_t serverStopping = 0; //set by SIGINT or SIGTERM while --serve is running
+#endif
+
+//FUNCTION: runServer()
+//PARAMETERS: const char* path, HashTable* hashTable, ColumnStore* columns - the Unix socket to listen on (an old one at the path is replaced),
+// the loaded table and the column store, NULL unless the column engine is in use
+//DESCRIPTION: answers ServerRequests from any number of local clients until SIGINT or SIGTERM. one thread runs a level triggered epoll loop
+// over the listening socket and every connection, all of them non-blocking. whatever a connection has sent is read in one go and every
+// complete request in it is answered before anything is written back, so a client that pipelines requests gets its replies in as few
+// writes as the socket allows. the same queries as --batch run on whichever engine is loaded, reading the newest view while --follow is
+// running. prints the connections, requests and requests per second when it stops. only built on linux
+//RETURNS: int - SUCCESS, or ERROR if the socket couldn't be set up or serving isn't supported here
+int runServer(const char* path, HashTable* hashTable, ColumnStore* columns) {
+#ifndef __linux__
+    (void)path;
+    (void)hashTable;
+    (void)columns;
+    printf("--serve isn't supported on this platform\n");
+    return ERROR;
+#else
+    struct sockaddr_un address;
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    if (strlen(path) >= sizeof(address.sun_path)) {
+        printf("Socket path %s is too long\n", path);
+        return ERROR;
+    }
+    strcpy(address.sun_path, path);
+    int listener = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (listener < 0) {
+        perror("Unable to create server socket");
+        return ERROR;
+    }
+    unlink(path);
+    if (bind(listener, (struct sockaddr*)&address, sizeof(address)) != 0 || listen(listener, SOMAXCONN) != 0) {
+        perror("Unable to listen on server socket");
+        close(listener);
+        return ERROR;
+    }
+    int epoll = epoll_create1(EPOLL_CLOEXEC);
+    if (epoll < 0) {
+        perror("Unable to create epoll instance");
+        close(listener);
+        unlink(path);
+        return ERROR;
+    }
+    struct epoll_event event;
+    event.events = EPOLLIN;
+    event.data.ptr = NULL; //the listener is the only one without a connection
+    epoll_ctl(epoll, EPOLL_CTL_ADD, listener, &event);
+    serverStopping = 0;
+    struct sigaction stop;
+    memset(&stop, 0, sizeof(stop));
+    stop.sa_handler = stopServer;
+    sigemptyset(&stop.sa_mask);
+    struct sigaction savedInterrupt;
+    struct sigaction savedTerminate;
+    sigaction(SIGINT, &stop, &savedInterrupt);
+    sigaction(SIGTERM, &stop, &savedTerminate);
+    printf("Serving queries on %s, interrupt to stop\n", path);
+    fflush(stdout);
+
+    ServerConnection* connections = NULL;
+    struct epoll_event ready[SERVER_EVENTS];
+    long long accepted = 0;
+    long long requests = 0;
+    double start = nowSeconds();
+    while (!serverStopping) {
+        int count = epoll_wait(epoll, ready, SERVER_EVENTS, SERVER_POLL_MS);
+        for (int i = 0; i < count; ++i) {
+            ServerConnection* connection = (ServerConnection*)ready[i].data.ptr;
+            if (connection != NULL) {
+                if (serveConnection(connection, ready[i].events, epoll, hashTable, columns, &requests) == ERROR) {
+                    closeConnection(connection, &connections);
+                }
+                continue;
+            }
+            int fd;
+            while ((fd = accept4(listener, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC)) >= 0) {
+                connection = (ServerConnection*)countedCalloc(1, sizeof(ServerConnection));
+                if (connection == NULL) {
+                    perror("Unable to allocate memory for connection");
+                    exit(1);
+                }
+                connection->fd = fd;
+                connection->events = EPOLLIN;
+                connection->next = connections;
+                if (connections != NULL) {
+                    connections->previous = connection;
+                }
+                connections = connection;
+                event.events = connection->events;
+                event.data.ptr = connection;
+                epoll_ctl(epoll, EPOLL_CTL_ADD, fd, &event);
+                accepted++;
+            }
+        }
+    }
+    double seconds = nowSeconds() - start;
+    while (connections != NULL) {
+        closeConnection(connections, &connections);
+    }
+    sigaction(SIGINT, &savedInterrupt, NULL);
+    sigaction(SIGTERM, &savedTerminate, NULL);
+    close(epoll);
+    close(listener);
+    unlink(path);
+    printf("Served %lld requests on %lld connections in %.3f s: %.0f requests/s\n", requests, accepted, seconds,
+        (seconds > 0.0) ? requests / seconds : 0.0);
+    return SUCCESS;
+#endif
+}
+
+#ifdef __linux__
+//FUNCTION: stopServer()
+//PARAMETERS: int signal - SIGINT or SIGTERM
+//DESCRIPTION: signal handler that tells runServer() to stop, which it notices within SERVER_POLL_MS
+//RETURNS: void
+void stopServer(int signal) {
+    (void)signal;
+    serverStopping = 1;
+}
+
+//FUNCTION: serveConnection()
+//PARAMETERS: ServerConnection* connection, unsigned int events, int epoll, HashTable* hashTable, ColumnStore* columns, long long* requests -
+// a connection epoll reported, what it reported, the epoll instance, the engines and the server's request count
+//DESCRIPTION: reads everything the client has sent, answers the complete requests and sends as much of the replies as the socket takes.
+// while more than SERVER_MAX_PENDING bytes of replies are waiting, the connection is only watched for room to write, so a client that
+// doesn't read its replies can't make the server buffer without limit
+//RETURNS: int - SUCCESS, or ERROR if the connection should be closed
+int serveConnection(ServerConnection* connection, unsigned int events, int epoll, HashTable* hashTable, ColumnStore* columns, long long* requests) {
+    if ((events & (EPOLLERR | EPOLLHUP)) && !(events & EPOLLIN)) {
+        connection->closing = 1;
+    }
+    while ((events & EPOLLIN) && !connection->closing) {
+        if (connection->inUsed == connection->inCapacity) {
+            connection->inCapacity = (connection->inCapacity == 0) ? SERVER_READ_SIZE : connection->inCapacity * 2;
+            connection->in = (char*)countedRealloc(connection->in, connection->inCapacity);
+            if (connection->in == NULL) {
+                perror("Unable to allocate memory for connection");
+                exit(1);
+            }
+        }
+        ssize_t got = read(connection->fd, connection->in + connection->inUsed, connection->inCapacity - connection->inUsed);
+        if (got > 0) {
+            connection->inUsed += got;
+        }
+        else if (got == 0 || (errno != EINTR && errno != EAGAIN && errno != EWOULDBLOCK)) {
+            connection->closing = 1;
+        }
+        else if (errno != EINTR) {
+            break;
+        }
+    }
+    *requests += answerRequests(connection, hashTable, columns);
+    if (sendReplies(connection) == ERROR) {
+        return ERROR;
+    }
+    size_t pending = connection->outUsed - connection->outSent;
+    if (connection->closing && pending == 0) {
+        return ERROR;
+    }
+    unsigned int wanted = ((pending < SERVER_MAX_PENDING && !connection->closing) ? (unsigned int)EPOLLIN : 0u) |
+        ((pending > 0) ? (unsigned int)EPOLLOUT : 0u);
+    if (wanted != connection->events) {
+        struct epoll_event event;
+        event.events = wanted;
+        event.data.ptr = connection;
+        epoll_ctl(epoll, EPOLL_CTL_MOD, connection->fd, &event);
+        connection->events = wanted;
+    }
+    return SUCCESS;
+}
+
+//FUNCTION: answerRequests()
+//PARAMETERS: ServerConnection* connection, HashTable* hashTable, ColumnStore* columns - the connection and the engines
+//DESCRIPTION: answers the complete requests at the front of the input, in order, until a request is cut short or SERVER_MAX_PENDING bytes of
+// replies are waiting, then moves what is left to the front for the next read. a name longer than MAX_DESTINATION means the client isn't
+// speaking the protocol, so it gets a SERVER_BAD_REQUEST and the connection is closed once that is sent
+//RETURNS: int - the number of requests answered
+int answerRequests(ServerConnection* connection, HashTable* hashTable, ColumnStore* columns) {
+    size_t offset = 0;
+    int answered = 0;
+    while (connection->inUsed - offset >= sizeof(ServerRequest) && connection->outUsed - connection->outSent < SERVER_MAX_PENDING) {
+        ServerRequest request;
+        memcpy(&request, connection->in + offset, sizeof(request));
+        if (request.nameLength > MAX_DESTINATION) {
+            ServerReply reply;
+            memset(&reply, 0, sizeof(reply));
+            reply.id = request.id;
+            reply.status = SERVER_BAD_REQUEST;
+            memcpy(reserveReply(connection, sizeof(reply)), &reply, sizeof(reply));
+            connection->outUsed += sizeof(reply);
+            connection->closing = 1;
+            offset = connection->inUsed;
+            break;
+        }
+        if (connection->inUsed - offset < sizeof(request) + request.nameLength) {
+            break;
+        }
+        serveRequest(connection, &request, connection->in + offset + sizeof(request), hashTable, columns);
+        offset += sizeof(request) + request.nameLength;
+        answered++;
+    }
+    memmove(connection->in, connection->in + offset, connection->inUsed - offset);
+    connection->inUsed -= offset;
+    return answered;
+}
+
+//FUNCTION: serveRequest()
+//PARAMETERS: ServerConnection* connection, const ServerRequest* request, const char* name, HashTable* hashTable, ColumnStore* columns - the
+// connection, the request, its name (not 0 terminated) and the engines
+//DESCRIPTION: runs one query between beginRead() and endRead() and appends its ServerReply and ParcelRecords to the connection's output. the
+// reply goes in first with its record count filled in once the records are written
+//RETURNS: void
+void serveRequest(ServerConnection* connection, const ServerRequest* request, const char* name, HashTable* hashTable, ColumnStore* columns) {
+    PROBE(PROBE_SERVE_REQUEST);
+    ServerReply reply;
+    memset(&reply, 0, sizeof(reply));
+    reply.id = request->id;
+    reply.status = SERVER_OK;
+    reserveReply(connection, sizeof(reply));
+    size_t replyAt = connection->outUsed;
+    connection->outUsed += sizeof(reply);
+    HashTable* view = beginRead(hashTable, MAIN_READER);
+    int countryId = lookupCountry(readDictionary(), name, request->nameLength);
+    ParcelTotals totals;
+    Parcel low;
+    Parcel high;
+    if (!hasParcels(view, columns, countryId)) {
+        reply.status = SERVER_NO_PARCELS;
+    }
+    else if (request->kind == SERVER_LIST) {
+        reply.records = serveWeightRange(connection, view, columns, countryId, INT_MIN, INT_MAX);
+    }
+    else if (request->kind == SERVER_ABOVE) {
+        reply.records = (request->first == INT_MAX) ? 0 : serveWeightRange(connection, view, columns, countryId, request->first + 1, INT_MAX);
+    }
+    else if (request->kind == SERVER_BELOW) {
+        reply.records = (request->first == INT_MIN) ? 0 : serveWeightRange(connection, view, columns, countryId, INT_MIN, request->first - 1);
+    }
+    else if (request->kind == SERVER_RANGE) {
+        reply.records = serveWeightRange(connection, view, columns, countryId, request->first, request->second);
+    }
+    else if (request->kind == SERVER_COUNT) {
+        reply.count = countRange(view, columns, countryId, request->first, request->second);
+    }
+    else if (request->kind == SERVER_TOTAL) {
+        sumRange(view, columns, countryId, request->first, request->second, &totals);
+        reply.count = totals.count;
+        reply.weight = totals.weight;
+        reply.valuation = totals.valuation;
+    }
+    else if (request->kind == SERVER_PRICES || request->kind == SERVER_EXTREMES) {
+        findExtremes(view, columns, countryId, request->kind == SERVER_PRICES, &low, &high);
+        appendReplyRecord(connection, countryId, low.weight, low.valuation);
+        appendReplyRecord(connection, countryId, high.weight, high.valuation);
+        reply.records = 2;
+    }
+    else {
+        reply.status = SERVER_BAD_REQUEST;
+    }
+    endRead(MAIN_READER);
+    memcpy(connection->out + replyAt, &reply, sizeof(reply));
+}
+
+//FUNCTION: serveWeightRange()
+//PARAMETERS: ServerConnection* connection, HashTable* hashTable, ColumnStore* columns, int countryId, int minWeight, int maxWeight - the
+// connection, the engines, the country and the inclusive range of weights
+//DESCRIPTION: appends a ParcelRecord for every parcel of the country in the range, in weight order, the same way batchWeightRange() writes P
+// lines
+//RETURNS: int - the number of records appended
+int serveWeightRange(ServerConnection* connection, HashTable* hashTable, ColumnStore* columns, int countryId, int minWeight, int maxWeight) {
+    int rows = 0;
+    if (columns != NULL) {
+        int end = columns->offsets[countryId + 1];
+        int row = lowerBoundColumns(columns, columns->offsets[countryId], end, minWeight);
+        end = upperBoundColumns(columns, row, end, maxWeight);
+        for (; row < end; ++row, ++rows) {
+            appendReplyRecord(connection, countryId, columns->weights[row], columns->valuations[row]);
+        }
+        return rows;
+    }
+    WeightCursor cursor;
+    openWeightCursor(&cursor, countryNode(hashTable, countryId)->root, minWeight, maxWeight);
+    for (BSTNode* node = nextWeightCursor(&cursor); node != NULL; node = nextWeightCursor(&cursor), ++rows) {
+        appendReplyRecord(connection, countryId, node->parcel->weight, node->parcel->valuation);
+    }
+    closeTreeCursor(&cursor);
+    return rows;
+}
+
+//FUNCTION: reserveReply()
+//PARAMETERS: ServerConnection* connection, size_t size - the connection and the bytes about to be appended to its output
+//DESCRIPTION: makes room for them, first dropping the bytes already sent and then doubling the buffer if that isn't enough
+//RETURNS: char* - where to write them, outUsed is left for the caller to advance
+char* reserveReply(ServerConnection* connection, size_t size) {
+    if (connection->outUsed + size > connection->outCapacity && connection->outSent > 0) {
+        memmove(connection->out, connection->out + connection->outSent, connection->outUsed - connection->outSent);
+        connection->outUsed -= connection->outSent;
+        connection->outSent = 0;
+    }
+    if (connection->outUsed + size > connection->outCapacity) {
+        size_t capacity = (connection->outCapacity == 0) ? SERVER_READ_SIZE : connection->outCapacity;
+        while (connection->outUsed + size > capacity) {
+            capacity *= 2;
+        }
+        connection->out = (char*)countedRealloc(connection->out, capacity);
+        if (connection->out == NULL) {
+            perror("Unable to allocate memory for connection");
+            exit(1);
+        }
+        connection->outCapacity = capacity;
+    }
+    return connection->out + connection->outUsed;
+}
+
+//FUNCTION: appendReplyRecord()
+//PARAMETERS: ServerConnection* connection, int countryId, int weight, int valuation - the connection and the parcel
+//DESCRIPTION: appends the parcel as a ParcelRecord keyed by the country ID
+//RETURNS: void
+void appendReplyRecord(ServerConnection* connection, int countryId, int weight, int valuation) {
+    ParcelRecord record;
+    record.key = countryId;
+    record.weight = weight;
+    record.valuation = valuation;
+    memcpy(reserveReply(connection, sizeof(record)), &record, sizeof(record));
+    connection->outUsed += sizeof(record);
+}
+
+//FUNCTION: sendReplies()
+//PARAMETERS: ServerConnection* connection - a connection with replies waiting, or none
+//DESCRIPTION: sends until everything is sent or the socket is full. MSG_NOSIGNAL keeps a client that hung up from raising SIGPIPE
+//RETURNS: int - SUCCESS, or ERROR if the connection broke
+int sendReplies(ServerConnection* connection) {
+    while (connection->outSent < connection->outUsed) {
+        ssize_t sent = send(connection->fd, connection->out + connection->outSent, connection->outUsed - connection->outSent, MSG_NOSIGNAL);
+        if (sent > 0) {
+            connection->outSent += sent;
+        }
+        else if (errno == EAGAIN || errno == EWOULDBLOCK) {
+            return SUCCESS;
+        }
+        else if (errno != EINTR) {
+            return ERROR;
+        }
+    }
+    connection->outUsed = 0;
+    connection->outSent = 0;
+    return SUCCESS;
+}
+
+//FUNCTION: closeConnection()
+//PARAMETERS: ServerConnection* connection, ServerConnection** connections - the connection and the list of open ones
+//DESCRIPTION: closes the socket, which also takes it out of epoll, takes the connection off the list and frees it
+//RETURNS: void
+void closeConnection(ServerConnection* connection, ServerConnection** connections) {
+    close(connection->fd);
+    if (connection->previous != NULL) {
+        connection->previous->next = connection->next;
+    }
+    else {
+        *connections = connection->next;
+    }
+    if (connection->next != NULL) {
+        connection->next->previous = connection->previous;
+    }
+    free(connection->in);
+    free(connection->out);
+    free(connection);
+}
+#endif
+
+//FUNCTION: benchmarkServer()
+//PARAMETERS: const Options* options - the options, for the server's socket, the number of clients and how many requests each keeps in flight
+//DESCRIPTION: load generator for --serve. each client is a thread with its own connection that keeps its pipeline full of random count,
+// total, weight range, price and weight extreme requests for destinations of the loaded table for SERVER_BENCH_SECONDS, then waits for
+// the last replies. prints the requests per second and the spread of latencies from sending a request to reading its reply, and checks
+// every reply was SERVER_OK and came back in order. only built on linux
+//RETURNS: int - SUCCESS, or ERROR if a client couldn't connect or got a wrong reply
+int benchmarkServer(const Options* options) {
+#ifndef __linux__
+    (void)options;
+    printf("--bench-server isn't supported on this platform\n");
+    return ERROR;
+#else
+    if (countryDictionary.count == 0) {
+        printf("No destinations loaded to ask about\n");
+        return ERROR;
+    }
+    int clientCount = options->serverClients;
+    LoadClient* clients = new LoadClient[clientCount];
+    double start = nowSeconds();
+    for (int i = 0; i < clientCount; ++i) {
+        clients[i].path = options->benchServerPath;
+        clients[i].pipeline = options->serverPipeline;
+        clients[i].until = start + SERVER_BENCH_SECONDS;
+        clients[i].seed = 0x9E3779B97F4A7C15ULL * (i + 1);
+        clients[i].latencies = NULL;
+        clients[i].latencyCount = 0;
+        clients[i].latencyCapacity = 0;
+        clients[i].records = 0;
+        clients[i].errors = 0;
+        clients[i].failed = 0;
+        clients[i].thread = std::thread(runLoadClient, &clients[i]);
+    }
+    double* latencies = NULL;
+    int latencyCount = 0;
+    int latencyCapacity = 0;
+    long long records = 0;
+    int errors = 0;
+    int failed = 0;
+    for (int i = 0; i < clientCount; ++i) {
+        clients[i].thread.join();
+        for (int sample = 0; sample < clients[i].latencyCount; ++sample) {
+            latencies = appendSample(latencies, &latencyCount, &latencyCapacity, clients[i].latencies[sample]);
+        }
+        free(clients[i].latencies);
+        records += clients[i].records;
+        errors += clients[i].errors;
+        failed += clients[i].failed;
+    }
+    double seconds = nowSeconds() - start;
+    delete[] clients;
+    printf("%d clients with %d requests in flight each: %d replies with %lld parcels in %.3f s, %.0f requests/s\n", clientCount,
+        options->serverPipeline, latencyCount, records, seconds, latencyCount / seconds);
+    printPercentiles(stdout, "Request latency", latencies, latencyCount);
+    free(latencies);
+    int passed = errors == 0 && failed == 0 && latencyCount > 0;
+    printf("%d wrong replies, %d clients failed: %s\n", errors, failed, passed ? "passed" : "FAILED");
+    return passed ? SUCCESS : ERROR;
+#endif
+}
+
+#ifdef __linux__
+//FUNCTION: runLoadClient()
+//PARAMETERS: LoadClient* client - the client's settings and where its results go
+//DESCRIPTION: thread body for benchmarkServer(). tops the pipeline up with new requests in one write, then reads whatever replies have come
+// back with one blocking read and times each against when it was sent, until the time is up and every request has been answered. the
+// pipeline keeps the requests small enough that the write can't block behind replies the client isn't reading yet
+//RETURNS: void
+void runLoadClient(LoadClient* client) {
+    int fd = connectServer(client->path);
+    if (fd < 0) {
+        client->failed = 1;
+        return;
+    }
+    char* requests = (char*)countedMalloc((size_t)client->pipeline * (sizeof(ServerRequest) + MAX_DESTINATION));
+    double* sent = (double*)countedMalloc(client->pipeline * sizeof(double));
+    size_t capacity = SERVER_READ_SIZE;
+    char* replies = (char*)countedMalloc(capacity);
+    if (requests == NULL || sent == NULL || replies == NULL) {
+        perror("Unable to allocate memory for load client");
+        exit(1);
+    }
+    unsigned int nextId = 0;
+    unsigned int answered = 0;
+    size_t used = 0;
+    while (!client->failed) {
+        double now = nowSeconds();
+        size_t length = 0;
+        while (now < client->until && nextId - answered < (unsigned int)client->pipeline) {
+            sent[nextId % client->pipeline] = now;
+            length += writeLoadRequest(requests + length, nextId++, &client->seed);
+        }
+        for (size_t written = 0; written < length && !client->failed;) {
+            ssize_t count = write(fd, requests + written, length - written);
+            if (count > 0) {
+                written += count;
+            }
+            else if (count < 0 && errno != EINTR) {
+                client->failed = 1;
+            }
+        }
+        if (answered == nextId || client->failed) {
+            break;
+        }
+        if (used == capacity) {
+            capacity *= 2;
+            replies = (char*)countedRealloc(replies, capacity);
+            if (replies == NULL) {
+                perror("Unable to allocate memory for load client");
+                exit(1);
+            }
+        }
+        ssize_t got = read(fd, replies + used, capacity - used);
+        if (got <= 0) {
+            if (got == 0 || errno != EINTR) {
+                client->failed = 1;
+            }
+            continue;
+        }
+        used += got;
+        size_t offset = 0;
+        ServerReply reply;
+        while (used - offset >= sizeof(reply)) {
+            memcpy(&reply, replies + offset, sizeof(reply));
+            size_t size = sizeof(reply) + (size_t)reply.records * sizeof(ParcelRecord);
+            if (used - offset < size) {
+                break;
+            }
+            if (reply.id != answered || reply.status != SERVER_OK) {
+                client->errors++;
+            }
+            client->latencies = appendSample(client->latencies, &client->latencyCount, &client->latencyCapacity,
+                nowSeconds() - sent[answered % client->pipeline]);
+            client->records += reply.records;
+            answered++;
+            offset += size;
+        }
+        memmove(replies, replies + offset, used - offset);
+        used -= offset;
+    }
+    close(fd);
+    free(replies);
+    free(sent);
+    free(requests);
+}
+
+//FUNCTION: writeLoadRequest()
+//PARAMETERS: char* out, unsigned int id, unsigned long long* seed - where to write the request, its ID and the client's random state
+//DESCRIPTION: writes a request for a random destination, a fifth each of weight ranges, counts and totals over a random 1% of the weights,
+// and cheapest and most expensive or lightest and heaviest parcels
+//RETURNS: size_t - the bytes written, the request and its name
+size_t writeLoadRequest(char* out, unsigned int id, unsigned long long* seed) {
+    static const unsigned short kinds[] = { SERVER_RANGE, SERVER_COUNT, SERVER_TOTAL, SERVER_PRICES, SERVER_EXTREMES };
+    int span = (MAX_WEIGHT - MIN_WEIGHT) / 100;
+    int countryId = (int)(nextRandom(seed) % countryDictionary.count);
+    ServerRequest request;
+    request.id = id;
+    request.kind = kinds[nextRandom(seed) % 5];
+    request.nameLength = (unsigned short)countryDictionary.lengths[countryId];
+    request.first = MIN_WEIGHT + (int)(nextRandom(seed) % (MAX_WEIGHT - MIN_WEIGHT - span));
+    request.second = request.first + span;
+    memcpy(out, &request, sizeof(request));
+    memcpy(out + sizeof(request), countryName(countryId), request.nameLength);
+    return sizeof(request) + request.nameLength;
+}
+
+//FUNCTION: connectServer()
+//PARAMETERS: const char* path - the server's socket
+//DESCRIPTION: opens a blocking connection to it
+//RETURNS: int - the socket, or -1 if it couldn't connect
+int connectServer(const char* path) {
+    struct sockaddr_un address;
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    if (strlen(path) >= sizeof(address.sun_path)) {
+        printf("Socket path %s is too long\n", path);
+        return -1;
+    }
+    strcpy(address.sun_path, path);
+    int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0 || connect(fd, (struct sockaddr*)&address, sizeof(address)) != 0) {
+        perror("Unable to connect to server");
+        if (fd >= 0) {
+            close(fd);
+        }
+        return -1;
+    }
+    return fd;
+}
+#endif
+
+/* Follow mode */
+//FUNCTION: beginRead()
+//PARAMETERS: HashTable* hashTable, int reader - the loaded table and the calling thread's reader slot
+//DESCRIPTION: called before every query. while --follow is running it records the epoch the query started in, so nothing the query could
+// still be looking at is freed until endRead(), and hands out the newest view the follower has published. it never waits for the follower
+//RETURNS: HashTable* - the table the query should read, the loaded table itself when not following
+HashTable* beginRead(HashTable* hashTable, int reader) {
+    shared.readers[reader].store(shared.epoch.load());
+    HashTable* view = shared.view.load();
+    return (view != NULL) ? view : hashTable;
+}
+
+//FUNCTION: endRead()
+//PARAMETERS: int reader - the slot passed to beginRead()
+//DESCRIPTION: called once the query is done with the view, after this the follower may free it
+//RETURNS: void
+void endRead(int reader) {
+    shared.readers[reader].store(0);
+}
+
+//FUNCTION: readDictionary()
+//PARAMETERS: none
+//DESCRIPTION: the dictionary the queries resolve and print names with. while --follow is running that is the follower's latest published
+// copy, since it changes the global one whenever a new destination shows up
+//RETURNS: const CountryDictionary* - the dictionary to read
+const CountryDictionary* readDictionary(void) {
+    const CountryDictionary* dictionary = shared.dictionary.load();
+    return (dictionary != NULL) ? dictionary : &countryDictionary;
+}
+
+//FUNCTION: isUnpublished()
+//PARAMETERS: const Arena* arena, const ArenaMark* published, const void* memory - a country's arena, where it was at the last publication
+// and a node allocated from it
+//DESCRIPTION: an arena only ever bumps forward, so the node is newer than the mark if it is in a slab added since then or past the marked
+// offset in the marked slab. the newest slab comes first, so this nearly always stops at the first one
+//RETURNS: int - 1 if no published view can contain the node, 0 if one might
+int isUnpublished(const Arena* arena, const ArenaMark* published, const void* memory) {
+    const char* address = (const char*)memory;
+    for (const Slab* slab = arena->slabs; slab != NULL; slab = slab->next) {
+        const char* start = (const char*)(slab + 1);
+        if (slab == published->slab) {
+            return address >= start + published->used && address < start + slab->used;
+        }
+        if (address >= start && address < start + slab->used) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+//FUNCTION: followerOwns()
+//PARAMETERS: FollowState* follow, int countryId, const void* memory - the follower and a node of the country's trees
+//DESCRIPTION: a node no published view can contain, so the follower may change it in place. either it is past the country's arena mark
+// with isUnpublished(), or it is a reused block followerAlloc() handed out since the last publication, looked up in follow->reused
+//RETURNS: int - 1 if the follower owns the node, 0 if a reader might see it
+int followerOwns(FollowState* follow, int countryId, const void* memory) {
+    if (isUnpublished(&countryNode(follow->hashTable, countryId)->arena, &follow->marks[countryId], memory)) {
+        return 1;
+    }
+    if (follow->reusedCount == 0) {
+        return 0;
+    }
+    unsigned int mask = (unsigned int)follow->reusedSlots - 1;
+    unsigned int slot = (unsigned int)((((unsigned long long)(size_t)memory >> 3) * 11400714819323198485ull) >> 32) & mask;
+    while (follow->reused[slot] != NULL) {
+        if (follow->reused[slot] == memory) {
+            return 1;
+        }
+        slot = (slot + 1) & mask;
+    }
+    return 0;
+}
+
+//FUNCTION: followerAlloc()
+//PARAMETERS: FollowState* follow, int countryId, size_t size - the follower, the country and the size of the node
+//DESCRIPTION: arenaAlloc() from the country's arena for a node the follower is adding or copying. a block that came off a free list sits
+// before the mark, so it is remembered with rememberReused() to keep followerOwns() from copying it again in the same batch
+//RETURNS: void* - the node
+void* followerAlloc(FollowState* follow, int countryId, size_t size) {
+    Arena* arena = &countryNode(follow->hashTable, countryId)->arena;
+    void* memory = arenaAlloc(arena, size);
+    if (!isUnpublished(arena, &follow->marks[countryId], memory)) {
+        rememberReused(follow, memory);
+    }
+    return memory;
+}
+
+//FUNCTION: rememberReused()
+//PARAMETERS: FollowState* follow, const void* memory - the follower and a reused block
+//DESCRIPTION: adds the block to the open-addressing set of reused blocks, doubling it when it gets half full. publishView() empties it
+//RETURNS: void
+void rememberReused(FollowState* follow, const void* memory) {
+    if ((follow->reusedCount + 1) * 2 > follow->reusedSlots) {
+        const void** old = follow->reused;
+        int oldSlots = follow->reusedSlots;
+        follow->reusedSlots = (oldSlots == 0) ? 1024 : oldSlots * 2;
+        follow->reused = (const void**)countedCalloc(follow->reusedSlots, sizeof(const void*));
+        if (follow->reused == NULL) {
+            perror("Unable to allocate memory for reused blocks");
+            exit(1);
+        }
+        follow->reusedCount = 0;
+        for (int i = 0; i < oldSlots; ++i) {
+            if (old[i] != NULL) {
+                rememberReused(follow, old[i]);
+            }
+        }
+        free(old);
+    }
+    unsigned int mask = (unsigned int)follow->reusedSlots - 1;
+    unsigned int slot = (unsigned int)((((unsigned long long)(size_t)memory >> 3) * 11400714819323198485ull) >> 32) & mask;
+    while (follow->reused[slot] != NULL) {
+        slot = (slot + 1) & mask;
+    }
+    follow->reused[slot] = memory;
+    follow->reusedCount++;
+}
+
+//FUNCTION: retireNode()
+//PARAMETERS: FollowState* follow, int countryId, void* memory, size_t size - the follower and a node a published view may still hold,
+// which the follower has just replaced with a copy
+//DESCRIPTION: retires the node with the epoch the next publication will have. reclaimRetired() gives it back to the country's arena free
+// list once every reader that could see it has finished, so a long --follow reuses the nodes it replaces instead of growing
+//RETURNS: void
+void retireNode(FollowState* follow, int countryId, void* memory, size_t size) {
+    retireMemory(follow, memory, shared.epoch.load() + 1);
+    follow->retired->countryId = countryId;
+    follow->retired->size = size;
+}
+
+//FUNCTION: startFollowing()
+//PARAMETERS: FollowState* follow, const char* path, const char* loadedFile, HashTable* hashTable - the state to set up, the file or named
+// pipe to follow, the file the table was loaded from and the loaded table
+//DESCRIPTION: opens the path without blocking. if it is the loaded file itself, only lines appended from now on are read, anything else is
+// read from the start. then the first view is published with startPublishing() and the follower thread started. the caller's table
+// belongs to the follower until stopFollowing()
+//RETURNS: int - SUCCESS, or ERROR if the path couldn't be opened or following isn't supported here
+int startFollowing(FollowState* follow, const char* path, const char* loadedFile, HashTable* hashTable) {
+#ifdef _WIN32
+    printf("--follow isn't supported on this platform\n");
+    return ERROR;
+#else
+    follow->fd = open(path, O_RDONLY | O_NONBLOCK);
+    if (follow->fd < 0) {
+        perror("Unable to open followed file");
+        return ERROR;
+    }
+    struct stat info;
+    struct stat loaded;
+    follow->offset = 0;
+    if (fstat(follow->fd, &info) == 0 && S_ISREG(info.st_mode) && stat(loadedFile, &loaded) == 0 && info.st_dev == loaded.st_dev &&
+        info.st_ino == loaded.st_ino) {
+        follow->offset = (long long)lseek(follow->fd, 0, SEEK_END);
+    }
+    follow->path = path;
+    follow->publishedOffset.store(follow->offset);
+    startPublishing(follow, hashTable);
+    follow->batchCapacity = 64;
+    follow->batches = (FollowBatch*)countedMalloc(follow->batchCapacity * sizeof(FollowBatch));
+    if (follow->batches == NULL) {
+        perror("Unable to allocate memory for follow stats");
+        exit(1);
+    }
+    follow->batches[0].endOffset = follow->offset;
+    follow->batches[0].readTime = follow->batches[0].publishTime = nowSeconds();
+    follow->batches[0].parcels = 0;
+    follow->batchCount = 1;
+    follow->thread = std::thread(followFile, follow);
+    fprintf(stderr, "Following %s for new parcels\n", path);
+    return SUCCESS;
+#endif
+}
+
+//FUNCTION: stopFollowing()
+//PARAMETERS: FollowState* follow - a running follower
+//DESCRIPTION: stops and joins the follower thread, stops publishing with stopPublishing(), and prints how many parcels were added and how
+// long lines took from being read to being visible to stderr, so they stay out of --batch results
+//RETURNS: void
+void stopFollowing(FollowState* follow) {
+#ifndef _WIN32
+    follow->stop.store(1);
+    follow->thread.join();
+    close(follow->fd);
+    stopPublishing(follow);
+
+    double* lags = (double*)countedMalloc((follow->batchCount + 1) * sizeof(double));
+    if (lags == NULL) {
+        perror("Unable to allocate memory for follow stats");
+        exit(1);
+    }
+    for (int i = 0; i < follow->batchCount; ++i) {
+        lags[i] = follow->batches[i].publishTime - follow->batches[i].readTime;
+    }
+    fprintf(stderr, "Followed %s: added %d parcels (%d skipped) in %d views\n", follow->path, follow->parcelsAdded, follow->rowsSkipped,
+        follow->batchCount - 1);
+    printPercentiles(stderr, "Lag from read to visible", lags + 1, follow->batchCount - 1);
+    free(lags);
+#endif
+}
+
+//FUNCTION: startPublishing()
+//PARAMETERS: FollowState* follow, HashTable* hashTable - the writer's state to set up and the loaded table
+//DESCRIPTION: makes the queries read published views of the table from now on. the valuation indexes are all built first since readers
+// can't build them while the writer is changing the trees, then the first view is published. after this only the writer may change the
+// table, through followParcel() and publishView()
+//RETURNS: void
+void startPublishing(FollowState* follow, HashTable* hashTable) {
+    follow->hashTable = hashTable;
+    follow->marks = NULL;
+    follow->markCount = 0;
+    follow->reused = NULL;
+    follow->reusedCount = 0;
+    follow->reusedSlots = 0;
+    follow->publishedCountries = -1;
+    follow->stop.store(0);
+    follow->retired = NULL;
+    follow->parcelsAdded = 0;
+    follow->rowsSkipped = 0;
+    follow->batches = NULL;
+    follow->batchCount = 0;
+    follow->batchCapacity = 0;
+    buildAllPriceIndexes(hashTable);
+    shared.epoch.store(1);
+    publishView(follow);
+}
+
+//FUNCTION: stopPublishing()
+//PARAMETERS: FollowState* follow - a writer whose thread has finished
+//DESCRIPTION: takes the published view away so the queries go back to the table itself, and frees every view and dictionary copy. no
+// query may be running
+//RETURNS: void
+void stopPublishing(FollowState* follow) {
+    HashTable* view = shared.view.exchange(NULL);
+    CountryDictionary* dictionary = shared.dictionary.exchange(NULL);
+    retireMemory(follow, view->nodes, 0);
+    retireMemory(follow, view, 0);
+    retireMemory(follow, (void*)dictionary->names, 0);
+    retireMemory(follow, dictionary->lengths, 0);
+    retireMemory(follow, dictionary->hashes, 0);
+    retireMemory(follow, dictionary->slots, 0);
+    retireMemory(follow, dictionary, 0);
+    reclaimRetired(follow, 1);
+}
+
+//FUNCTION: releaseFollow()
+//PARAMETERS: FollowState* follow - a follower that has been stopped
+//DESCRIPTION: frees the arena marks, the set of reused blocks and the list of published batches
+//RETURNS: void
+void releaseFollow(FollowState* follow) {
+    free(follow->marks);
+    free(follow->reused);
+    free(follow->batches);
+    follow->marks = NULL;
+    follow->reused = NULL;
+    follow->batches = NULL;
+}
+
+//FUNCTION: followFile()
+//PARAMETERS: FollowState* follow - the follower's state
+//DESCRIPTION: runs on the follower thread until it is stopped. reads whatever has been written since the last read, FOLLOW_READ_SIZE bytes
+// at most, adds the valid parcels on every complete line with followParcel() and publishes a new view if any were added. a line that isn't
+// finished yet is kept for the next read, and one too long to fit in the buffer is skipped. when there is nothing new it sleeps
+// FOLLOW_POLL_MS, and if a regular file has become shorter than what was read it was truncated or replaced, so it is followed from the start
+//RETURNS: void
+void followFile(FollowState* follow) {
+#ifndef _WIN32
+    char* buffer = (char*)countedMalloc(FOLLOW_READ_SIZE);
+    if (buffer == NULL) {
+        perror("Unable to allocate memory for follow buffer");
+        exit(1);
+    }
+    size_t carry = 0;
+    int discarding = 0; //the rest of a line that was too long is still to come
+    while (!follow->stop.load()) {
+        ssize_t count = read(follow->fd, buffer + carry, FOLLOW_READ_SIZE - carry);
+        if (count > 0) {
+            double readTime = nowSeconds();
+            follow->offset += count;
+            char* cursor = buffer;
+            char* end = buffer + carry + count;
+            if (discarding) {
+                char* newline = (char*)memchr(cursor, '\n', (size_t)(end - cursor));
+                if (newline == NULL) {
+                    carry = 0;
+                    continue;
+                }
+                cursor = newline + 1;
+                discarding = 0;
+            }
+            char* complete = end;
+            while (complete > cursor && complete[-1] != '\n') {
+                complete--;
+            }
+            int added = 0;
+            while (cursor < complete) {
+                ParsedRecord record;
+                int valid = 0;
+                cursor = (char*)parseRecord(cursor, complete, &record, &valid);
+                if (!valid || !isValidParcel(record.weight, record.valuation)) {
+                    follow->rowsSkipped++;
+                    continue;
+                }
+                followParcel(follow, &record);
+                added++;
+            }
+            carry = (size_t)(end - complete);
+            memmove(buffer, complete, carry);
+            if (carry == FOLLOW_READ_SIZE) {
+                follow->rowsSkipped++;
+                carry = 0;
+                discarding = 1;
+            }
+            if (added > 0) {
+                if (follow->batchCount == follow->batchCapacity) {
+                    follow->batchCapacity *= 2;
+                    follow->batches = (FollowBatch*)countedRealloc(follow->batches, follow->batchCapacity * sizeof(FollowBatch));
+                    if (follow->batches == NULL) {
+                        perror("Unable to allocate memory for follow stats");
+                        exit(1);
+                    }
+                }
+                FollowBatch* batch = &follow->batches[follow->batchCount++];
+                batch->endOffset = follow->offset - (long long)carry;
+                batch->readTime = readTime;
+                batch->parcels = added;
+                publishView(follow);
+                batch->publishTime = nowSeconds();
+                follow->publishedOffset.store(batch->endOffset);
+            }
+            continue;
+        }
+        if (count < 0 && errno != EAGAIN && errno != EINTR) {
+            perror("Unable to read followed file");
+            break;
+        }
+        struct stat info;
+        if (fstat(follow->fd, &info) == 0 && S_ISREG(info.st_mode) && (long long)info.st_size < follow->offset) {
+            fprintf(stderr, "%s was truncated, following it from the start\n", follow->path);
+            lseek(follow->fd, 0, SEEK_SET);
+            follow->offset = 0;
+            carry = 0;
+            discarding = 0;
+            continue;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(FOLLOW_POLL_MS));
+    }
+    free(buffer);
+#endif
+}
+
+//FUNCTION: followParcel()
+//PARAMETERS: FollowState* follow, const ParsedRecord* record - the follower and a valid parcel line
+//DESCRIPTION: interns the destination and adds the parcel to its country's weight tree and valuation index, copying anything a published
+// view can see. a country seen for the first time has nothing published yet, so its mark is left empty
+//RETURNS: void
+void followParcel(FollowState* follow, const ParsedRecord* record) {
+    int countryId = internCountry(&countryDictionary, record->destination, record->destinationLength);
+    growMarks(follow, countryId + 1);
+    HashNode* node = countryNode(follow->hashTable, countryId);
+    Parcel* parcel = createParcel(&node->arena, countryId, record->weight, record->valuation);
+    node->root = insertBST(&node->arena, node->root, parcel, follow);
+    node->priceRoot = insertPrice(&node->arena, node->priceRoot, parcel, follow);
+    follow->parcelsAdded++;
+}
+
+//FUNCTION: growMarks()
+//PARAMETERS: FollowState* follow, int count - the follower and how many countries need a mark
+//DESCRIPTION: doubles the array of arena marks until it has room for count countries. the new marks are empty, which is right for a country
+// that has only just been added since nothing of it has been published
+//RETURNS: void
+void growMarks(FollowState* follow, int count) {
+    if (count <= follow->markCount) {
+        return;
+    }
+    int markCount = (follow->markCount == 0) ? 128 : follow->markCount;
+    while (markCount < count) {
+        markCount *= 2;
+    }
+    follow->marks = (ArenaMark*)countedRealloc(follow->marks, markCount * sizeof(ArenaMark));
+    if (follow->marks == NULL) {
+        perror("Unable to allocate memory for arena marks");
+        exit(1);
+    }
+    for (int i = follow->markCount; i < markCount; ++i) {
+        follow->marks[i].slab = NULL;
+        follow->marks[i].used = 0;
+    }
+    follow->markCount = markCount;
+}
+
+//FUNCTION: publishView()
+//PARAMETERS: FollowState* follow - the follower
+//DESCRIPTION: copies the follower's hash nodes into a new view, and the dictionary too if a destination was added, and swaps them in for the
+// queries. the dictionary goes first so a query that gets the new view also gets every name in it. the old ones are retired with the new
+// epoch and freed once every query that started before it has finished. the arena marks then move up to the end of every arena and the
+// set of reused blocks is emptied, since all of it is now in a published view
+//RETURNS: void
+void publishView(FollowState* follow) {
+    CountryDictionary* oldDictionary = NULL;
+    if (countryDictionary.count != follow->publishedCountries) {
+        oldDictionary = shared.dictionary.exchange(cloneDictionary(&countryDictionary));
+        follow->publishedCountries = countryDictionary.count;
+    }
+    HashTable* oldView = shared.view.exchange(copyTable(follow->hashTable));
+    unsigned long long epoch = shared.epoch.fetch_add(1) + 1;
+    if (oldView != NULL) {
+        retireMemory(follow, oldView->nodes, epoch);
+        retireMemory(follow, oldView, epoch);
+    }
+    if (oldDictionary != NULL) {
+        retireMemory(follow, (void*)oldDictionary->names, epoch);
+        retireMemory(follow, oldDictionary->lengths, epoch);
+        retireMemory(follow, oldDictionary->hashes, epoch);
+        retireMemory(follow, oldDictionary->slots, epoch);
+        retireMemory(follow, oldDictionary, epoch);
+    }
+    reclaimRetired(follow, 0);
+
+    growMarks(follow, countryDictionary.count);
+    for (int id = 0; id < countryDictionary.count; ++id) {
+        Slab* slab = countryNode(follow->hashTable, id)->arena.slabs;
+        follow->marks[id].slab = slab;
+        follow->marks[id].used = (slab == NULL) ? 0 : slab->used;
+    }
+    if (follow->reusedCount > 0) {
+        memset(follow->reused, 0, follow->reusedSlots * sizeof(const void*));
+        follow->reusedCount = 0;
+    }
+}
+
+//FUNCTION: copyTable()
+//PARAMETERS: const HashTable* hashTable - the follower's table
+//DESCRIPTION: copies the array of hash nodes, which is all a view needs since the trees it points to are never changed once published
+//RETURNS: HashTable* - the new view
+HashTable* copyTable(const HashTable* hashTable) {
+    HashTable* view = (HashTable*)countedMalloc(sizeof(HashTable));
+    HashNode* nodes = (HashNode*)countedMalloc((hashTable->capacity + 1) * sizeof(HashNode));
+    if (view == NULL || nodes == NULL) {
+        perror("Unable to allocate memory for table view");
+        exit(1);
+    }
+    memcpy(nodes, hashTable->nodes, hashTable->capacity * sizeof(HashNode));
+    view->nodes = nodes;
+    view->capacity = hashTable->capacity;
+    return view;
+}
+
+//FUNCTION: cloneDictionary()
+//PARAMETERS: const CountryDictionary* dictionary - the follower's dictionary
+//DESCRIPTION: copies the names, lengths, hashes and index into new arrays for the queries. the strings stay where they are, the dictionary's
+// arena only grows so they never move, which leaves the copy's own arena empty
+//RETURNS: CountryDictionary* - the copy
+CountryDictionary* cloneDictionary(const CountryDictionary* dictionary) {
+    int count = dictionary->count;
+    CountryDictionary* copy = (CountryDictionary*)countedMalloc(sizeof(CountryDictionary));
+    if (copy == NULL) {
+        perror("Unable to allocate memory for country dictionary");
+        exit(1);
+    }
+    copy->names = (const char**)countedMalloc((count + 1) * sizeof(const char*));
+    copy->lengths = (int*)countedMalloc((count + 1) * sizeof(int));
+    copy->hashes = (unsigned long long*)countedMalloc((count + 1) * sizeof(unsigned long long));
+    copy->slots = (int*)countedMalloc(dictionary->slotCount * sizeof(int));
+    if (copy->names == NULL || copy->lengths == NULL || copy->hashes == NULL || copy->slots == NULL) {
+        perror("Unable to allocate memory for country dictionary");
+        exit(1);
+    }
+    memcpy((void*)copy->names, dictionary->names, count * sizeof(const char*));
+    memcpy(copy->lengths, dictionary->lengths, count * sizeof(int));
+    memcpy(copy->hashes, dictionary->hashes, count * sizeof(unsigned long long));
+    memcpy(copy->slots, dictionary->slots, dictionary->slotCount * sizeof(int));
+    copy->slotCount = dictionary->slotCount;
+    copy->count = count;
+    copy->capacity = count;
+    copy->text.slabs = NULL;
+    copy->text.bytesReserved = 0;
+    copy->text.bytesUsed = 0;
+    memset(copy->text.freeBlocks, 0, sizeof(copy->text.freeBlocks));
+    return copy;
+}
+
+//FUNCTION: retireMemory()
+//PARAMETERS: FollowState* follow, void* memory, unsigned long long epoch - the follower, a block from a replaced view and the epoch of the
+// view that replaced it
+//DESCRIPTION: adds the block to the follower's list of memory waiting to be freed
+//RETURNS: void
+void retireMemory(FollowState* follow, void* memory, unsigned long long epoch) {
+    RetiredBlock* block = (RetiredBlock*)countedMalloc(sizeof(RetiredBlock));
+    if (block == NULL) {
+        perror("Unable to allocate memory for retired block");
+        exit(1);
+    }
+    block->memory = memory;
+    block->epoch = epoch;
+    block->countryId = NO_COUNTRY;
+    block->size = 0;
+    block->next = follow->retired;
+    follow->retired = block;
+}
+
+//FUNCTION: reclaimRetired()
+//PARAMETERS: FollowState* follow, int everything - the follower, and 1 to free every block once there are no readers left
+//DESCRIPTION: finds the oldest epoch any query is still in and frees the blocks retired at or before it, since every query that could have
+// seen them has finished. tree nodes go back to their country's arena with arenaFree(), anything else to free()
+//RETURNS: void
+void reclaimRetired(FollowState* follow, int everything) {
+    unsigned long long oldest = ULLONG_MAX;
+    for (int i = 0; i < MAX_READERS && !everything; ++i) {
+        unsigned long long epoch = shared.readers[i].load();
+        if (epoch != 0 && epoch < oldest) {
+            oldest = epoch;
+        }
+    }
+    RetiredBlock** link = &follow->retired;
+    while (*link != NULL) {
+        RetiredBlock* block = *link;
+        if (block->epoch <= oldest) {
+            *link = block->next;
+            if (block->countryId == NO_COUNTRY) {
+                free(block->memory);
+            }
+            else {
+                arenaFree(&countryNode(follow->hashTable, block->countryId)->arena, block->memory, block->size);
+            }
+            free(block);
+        }
+        else {
+            link = &block->next;
+        }
+    }
+}
+
+//FUNCTION: compareDoubles()
+//PARAMETERS: const void* first, const void* second - two doubles
+//DESCRIPTION: qsort() comparison in ascending order
+//RETURNS: int - negative, 0 or positive
+int compareDoubles(const void* first, const void* second) {
+    double a = *(const double*)first;
+    double b = *(const double*)second;
+    return (a > b) - (a < b);
+}
+
+//FUNCTION: compareInts()
+//PARAMETERS: const void* first, const void* second - two ints
+//DESCRIPTION: qsort() comparison in ascending order
+//RETURNS: int - negative, 0 or positive
+int compareInts(const void* first, const void* second) {
+    int a = *(const int*)first;
+    int b = *(const int*)second;
+    return (a > b) - (a < b);
+}
+
+//FUNCTION: percentile()
+//PARAMETERS: const double* sorted, int count, double fraction - values in ascending order, how many there are and the percentile wanted
+// as a fraction
+//DESCRIPTION: nearest rank percentile
+//RETURNS: double - the value, 0 if there are none
+double percentile(const double* sorted, int count, double fraction) {
+    if (count == 0) {
+        return 0.0;
+    }
+    int rank = (int)ceil(fraction * count) - 1;
+    return sorted[(rank < 0) ? 0 : (rank >= count) ? count - 1 : rank];
+}
+
+//FUNCTION: printPercentiles()
+//PARAMETERS: FILE* file, const char* label, double* seconds, int count - where to print, what was timed and the times, which get sorted
+//DESCRIPTION: prints the median, 99th percentile and worst of the times in microseconds
+//RETURNS: void
+void printPercentiles(FILE* file, const char* label, double* seconds, int count) {
+    qsort(seconds, count, sizeof(double), compareDoubles);
+    fprintf(file, "%s: p50 %.1f us, p99 %.1f us, max %.1f us over %d samples\n", label, percentile(seconds, count, 0.50) * 1e6,
+        percentile(seconds, count, 0.99) * 1e6, percentile(seconds, count, 1.0) * 1e6, count);
+}
+
+//FUNCTION: appendSample()
+//PARAMETERS: double* samples, int* count, int* capacity, double value - a growable list of times, its size and room, and the time to add
+//DESCRIPTION: appends the time, doubling the list when it is full
+//RETURNS: double* - the list, which may have moved
+double* appendSample(double* samples, int* count, int* capacity, double value) {
+    if (*count == *capacity) {
+        *capacity = (*capacity == 0) ? 1024 : *capacity * 2;
+        samples = (double*)countedRealloc(samples, *capacity * sizeof(double));
+        if (samples == NULL) {
+            perror("Unable to allocate memory for latency samples");
+            exit(1);
+        }
+    }
+    samples[(*count)++] = value;
+    return samples;
+}
+
+//FUNCTION: benchmarkFollow()
+//PARAMETERS: const Options* options, HashTable* hashTable - the options, for the loaded file's name, and the loaded table
+//DESCRIPTION: follows a scratch file next to the loaded one and times FOLLOW_BENCH_QUERIES weight range queries with nothing being written.
+// then a second thread appends FOLLOW_BENCH_ROWS rows in bursts of FOLLOW_BENCH_BURST, a few with new destinations, while the same queries
+// keep running until the follower has published every row. it reports the lag from each burst being written to it being visible, the query
+// latencies with and without the follower working, and checks that every query saw a consistent view, that the visible parcel count never
+// went down, and that the trees, totals and valuation indexes all check out with every row added at the end
+//RETURNS: int - SUCCESS, or ERROR if the scratch file couldn't be followed or a check failed
+int benchmarkFollow(const Options* options, HashTable* hashTable) {
+    size_t pathLength = strlen(options->filename) + 8;
+    char* path = (char*)countedMalloc(pathLength);
+    if (path == NULL) {
+        perror("Unable to allocate memory for scratch file name");
+        exit(1);
+    }
+    snprintf(path, pathLength, "%s.follow", options->filename);
+    FollowGenerator generator;
+    generator.file = fopen(path, "wb");
+    if (generator.file == NULL) {
+        perror("Unable to create scratch file");
+        free(path);
+        return ERROR;
+    }
+    generator.nameCount = countryDictionary.count;
+    generator.names = (const char**)countedMalloc(generator.nameCount * sizeof(const char*));
+    generator.bursts = (FOLLOW_BENCH_ROWS + FOLLOW_BENCH_BURST - 1) / FOLLOW_BENCH_BURST;
+    generator.endOffsets = (long long*)countedMalloc(generator.bursts * sizeof(long long));
+    generator.writeTimes = (double*)countedMalloc(generator.bursts * sizeof(double));
+    if (generator.names == NULL || generator.endOffsets == NULL || generator.writeTimes == NULL) {
+        perror("Unable to allocate memory for follow benchmark");
+        exit(1);
+    }
+    memcpy((void*)generator.names, countryDictionary.names, generator.nameCount * sizeof(const char*));
+    long long loaded = 0;
+    for (int id = 0; id < countryDictionary.count; ++id) {
+        BSTNode* root = countryNode(hashTable, id)->root;
+        loaded += (root == NULL) ? 0 : root->subtree.count;
+    }
+
+    FollowState follow;
+    if (startFollowing(&follow, path, options->filename, hashTable) == ERROR) {
+        fclose(generator.file);
+        remove(path);
+        free(path);
+        return ERROR;
+    }
+    unsigned long long seed = 0x9E3779B97F4A7C15ULL;
+    int inconsistent = 0;
+    long long visible = 0;
+    double* idle = NULL;
+    int idleCount = 0;
+    int idleCapacity = 0;
+    for (int i = 0; i < FOLLOW_BENCH_QUERIES; ++i) {
+        idle = appendSample(idle, &idleCount, &idleCapacity, timeFollowQuery(hashTable, &seed, &inconsistent, &visible));
+    }
+
+    double* busy = NULL;
+    int busyCount = 0;
+    int busyCapacity = 0;
+    double start = nowSeconds();
+    generator.finalOffset.store(-1);
+    std::thread writer(appendRows, &generator);
+    while (generator.finalOffset.load() < 0 || follow.publishedOffset.load() < generator.finalOffset.load()) {
+        busy = appendSample(busy, &busyCount, &busyCapacity, timeFollowQuery(hashTable, &seed, &inconsistent, &visible));
+    }
+    writer.join();
+    double seconds = nowSeconds() - start;
+    fclose(generator.file);
+    stopFollowing(&follow);
+
+    double* lags = (double*)countedMalloc(generator.bursts * sizeof(double));
+    if (lags == NULL) {
+        perror("Unable to allocate memory for follow benchmark");
+        exit(1);
+    }
+    int batch = 0;
+    for (int i = 0; i < generator.bursts; ++i) {
+        while (follow.batches[batch].endOffset < generator.endOffsets[i]) {
+            batch++;
+        }
+        lags[i] = follow.batches[batch].publishTime - generator.writeTimes[i];
+    }
+    printf("Appended %d rows in %d bursts and %d new destinations, published in %d views over %.3f ms (%.0f rows/s)\n", FOLLOW_BENCH_ROWS,
+        generator.bursts, generator.newCountries, follow.batchCount - 1, seconds * 1000.0, FOLLOW_BENCH_ROWS / seconds);
+    printPercentiles(stdout, "Lag from write to visible", lags, generator.bursts);
+    printPercentiles(stdout, "Query latency, nothing written", idle, idleCount);
+    printPercentiles(stdout, "Query latency, while following", busy, busyCount);
+
+    int broken = 0;
+    long long total = 0;
+    for (int id = 0; id < countryDictionary.count; ++id) {
+        HashNode* node = countryNode(hashTable, id);
+        total += (node->root == NULL) ? 0 : node->root->subtree.count;
+        if (!checkSubtreeTotals(node->root) || !checkPriceIndex(node)) {
+            broken++;
+        }
+    }
+    int passed = inconsistent == 0 && broken == 0 && total == loaded + FOLLOW_BENCH_ROWS && follow.parcelsAdded == FOLLOW_BENCH_ROWS;
+    printf("%d queries saw an inconsistent view, %d countries failed their checks, %lld of %lld parcels in the table: %s\n", inconsistent,
+        broken, total, loaded + FOLLOW_BENCH_ROWS, passed ? "passed" : "FAILED");
+    releaseFollow(&follow);
+    remove(path);
+    free(path);
+    free(lags);
+    free(idle);
+    free(busy);
+    free((void*)generator.names);
+    free(generator.endOffsets);
+    free(generator.writeTimes);
+    return passed ? SUCCESS : ERROR;
+}
+
+//FUNCTION: appendRows()
+//PARAMETERS: FollowGenerator* generator - the scratch file and where to record the bursts
+//DESCRIPTION: runs on its own thread for --bench-follow. writes FOLLOW_BENCH_BURST random valid rows at a time, flushing after each burst
+// and noting the time and where the burst ended, then sleeps a millisecond. every 50th burst starts with a destination that wasn't loaded
+//RETURNS: void
+void appendRows(FollowGenerator* generator) {
+    unsigned long long seed = 0x2545F4914F6CDD1DULL;
+    long long offset = 0;
+    int written = 0;
+    generator->newCountries = 0;
+    for (int burst = 0; burst < generator->bursts; ++burst) {
+        for (int row = 0; row < FOLLOW_BENCH_BURST && written < FOLLOW_BENCH_ROWS; ++row, ++written) {
+            int weight = MIN_WEIGHT + (int)(nextRandom(&seed) % (MAX_WEIGHT - MIN_WEIGHT + 1));
+            int cents = MIN_PRICE * 100 + (int)(nextRandom(&seed) % ((MAX_PRICE - MIN_PRICE) * 100 + 1));
+            int length = 0;
+            if (row == 0 && burst % 50 == 0) {
+                length = fprintf(generator->file, "Newland %d,%d,%d.%02d\n", ++generator->newCountries, weight, cents / 100, cents % 100);
+            }
+            else {
+                length = fprintf(generator->file, "%s,%d,%d.%02d\n", generator->names[nextRandom(&seed) % generator->nameCount], weight,
+                    cents / 100, cents % 100);
+            }
+            offset += length;
+        }
+        fflush(generator->file);
+        generator->endOffsets[burst] = offset;
+        generator->writeTimes[burst] = nowSeconds();
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    generator->finalOffset.store(offset);
+}
+
+//FUNCTION: timeFollowQuery()
+//PARAMETERS: HashTable* hashTable, unsigned long long* seed, int* inconsistent, long long* visible - the loaded table, the random state, the
+// count of inconsistent views seen and the number of parcels the last query could see
+//DESCRIPTION: one --bench-follow query. counts a random weight range of a random country with countWeightRange() and times it, then walks
+// the same range with a cursor. the two only agree if the view's totals and links are consistent. it also adds up every country's count and
+// checks it isn't less than the previous query saw, since views only ever gain parcels
+//RETURNS: double - how long the counted query took in seconds
+double timeFollowQuery(HashTable* hashTable, unsigned long long* seed, int* inconsistent, long long* visible) {
+    double start = nowSeconds();
+    HashTable* view = beginRead(hashTable, MAIN_READER);
+    int countries = readDictionary()->count;
+    if (countries > view->capacity) {
+        countries = view->capacity;
+    }
+    BSTNode* root = view->nodes[nextRandom(seed) % countries].root;
+    int minWeight = MIN_WEIGHT + (int)(nextRandom(seed) % (MAX_WEIGHT - MIN_WEIGHT));
+    int maxWeight = minWeight + (int)(nextRandom(seed) % 5000);
+    int count = countWeightRange(root, minWeight, maxWeight);
+    double seconds = nowSeconds() - start;
+
+    WeightCursor cursor;
+    openWeightCursor(&cursor, root, minWeight, maxWeight);
+    int walked = 0;
+    while (nextWeightCursor(&cursor) != NULL) {
+        walked++;
+    }
+    closeTreeCursor(&cursor);
+    long long total = 0;
+    for (int id = 0; id < countries; ++id) {
+        total += (view->nodes[id].root == NULL) ? 0 : view->nodes[id].root->subtree.count;
+    }
+    endRead(MAIN_READER);
+    if (walked != count || total < *visible) {
+        (*inconsistent)++;
+    }
+    *visible = total;
+    return seconds;
+}
+
+/* Thread-safe queries */
+//FUNCTION: registerReader()
+//PARAMETERS: none
+//DESCRIPTION: claims a reader slot for a query thread. every thread running the thread-safe queries needs its own slot, MAIN_READER is kept
+// for the menu and batch thread
+//RETURNS: int - the slot, or -1 if all MAX_READERS slots are taken
+int registerReader(void) {
+    for (int i = MAIN_READER + 1; i < MAX_READERS; ++i) {
+        int expected = 0;
+        if (shared.claimed[i].compare_exchange_strong(expected, 1)) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+//FUNCTION: releaseReader()
+//PARAMETERS: int reader - a slot from registerReader()
+//DESCRIPTION: gives the slot back once the thread has no query running
+//RETURNS: void
+void releaseReader(int reader) {
+    shared.readers[reader].store(0);
+    shared.claimed[reader].store(0);
+}
+
+//FUNCTION: queryTotals()
+//PARAMETERS: HashTable* hashTable, int reader, const char* country, int minWeight, int maxWeight, ParcelTotals* totals - the loaded table,
+// the caller's reader slot, the country, the inclusive range of weights (INT_MIN and INT_MAX for all of them) and where the totals go
+//DESCRIPTION: the count, load, valuation and price range of the country's parcels in the range, from sumWeightRange(). like the other
+// thread-safe queries it never prints, never builds a valuation index and only reads the trees between beginRead() and endRead(), so any
+// number of threads can run it at once and each call sees one whole view while a writer adds parcels. no locks are taken
+//RETURNS: int - SUCCESS, or ERROR if there are no parcels for the country
+int queryTotals(HashTable* hashTable, int reader, const char* country, int minWeight, int maxWeight, ParcelTotals* totals) {
+    PROBE(PROBE_QUERY_TOTALS);
+    HashNode* node = findCountryNode(country, beginRead(hashTable, reader));
+    int result = ERROR;
+    if (node != NULL && node->root != NULL) {
+        clearTotals(totals);
+        sumWeightRange(node->root, minWeight, maxWeight, totals);
+        result = SUCCESS;
+    }
+    endRead(reader);
+    return result;
+}
+
+//FUNCTION: queryLightestAndHeaviest()
+//PARAMETERS: HashTable* hashTable, int reader, const char* country, Parcel* lightest, Parcel* heaviest - the table, the reader slot, the
+// country and where copies of its lightest and heaviest parcels go
+//DESCRIPTION: thread-safe displayLightestAndHeaviest()
+//RETURNS: int - SUCCESS, or ERROR if there are no parcels for the country
+int queryLightestAndHeaviest(HashTable* hashTable, int reader, const char* country, Parcel* lightest, Parcel* heaviest) {
+    PROBE(PROBE_QUERY_WEIGHT_EXTREMES);
+    HashNode* node = findCountryNode(country, beginRead(hashTable, reader));
+    int result = ERROR;
+    if (node != NULL && node->root != NULL) {
+        Parcel* low = NULL;
+        Parcel* high = NULL;
+        weightExtremes(node->root, &low, &high);
+        *lightest = *low;
+        *heaviest = *high;
+        result = SUCCESS;
+    }
+    endRead(reader);
+    return result;
+}
+
+//FUNCTION: queryCheapestAndMostExpensive()
+//PARAMETERS: HashTable* hashTable, int reader, const char* country, Parcel* cheapest, Parcel* mostExpensive - the table, the reader slot,
+// the country and where copies of its cheapest and most expensive parcels go
+//DESCRIPTION: thread-safe displayCheapestAndMostExpensive(). uses the valuation index if it was built, the weight tree if not
+//RETURNS: int - SUCCESS, or ERROR if there are no parcels for the country
+int queryCheapestAndMostExpensive(HashTable* hashTable, int reader, const char* country, Parcel* cheapest, Parcel* mostExpensive) {
+    PROBE(PROBE_QUERY_PRICE_EXTREMES);
+    HashNode* node = findCountryNode(country, beginRead(hashTable, reader));
+    int result = ERROR;
+    if (node != NULL && node->root != NULL) {
+        Parcel* low = NULL;
+        Parcel* high = NULL;
+        priceExtremes(node, &low, &high);
+        *cheapest = *low;
+        *mostExpensive = *high;
+        result = SUCCESS;
+    }
+    endRead(reader);
+    return result;
+}
+
+//FUNCTION: queryWeightRange()
+//PARAMETERS: HashTable* hashTable, int reader, const char* country, int minWeight, int maxWeight, Parcel* parcels, int capacity - the
+// table, the reader slot, the country, the inclusive range of weights and room for capacity parcels
+//DESCRIPTION: thread-safe searchByWeightRange(). copies the first capacity parcels in the range, in weight order, with a cursor and counts
+// all of them with countWeightRange()
+//RETURNS: int - how many parcels are in the range, which can be more than were copied, or -1 if there are no parcels for the country
+int queryWeightRange(HashTable* hashTable, int reader, const char* country, int minWeight, int maxWeight, Parcel* parcels, int capacity) {
+    PROBE(PROBE_QUERY_WEIGHT_RANGE);
+    HashNode* node = findCountryNode(country, beginRead(hashTable, reader));
+    int count = -1;
+    if (node != NULL && node->root != NULL) {
+        WeightCursor cursor;
+        openWeightCursor(&cursor, node->root, minWeight, maxWeight);
+        BSTNode* next = NULL;
+        for (int i = 0; i < capacity && (next = nextWeightCursor(&cursor)) != NULL; ++i) {
+            parcels[i] = *next->parcel;
+        }
+        closeTreeCursor(&cursor);
+        count = countWeightRange(node->root, minWeight, maxWeight);
+    }
+    endRead(reader);
+    return count;
+}
+
+//FUNCTION: benchmarkReaders()
+//PARAMETERS: HashTable* hashTable - the loaded table
+//DESCRIPTION: runs the thread-safe queries on 1, 2, 4 and so on up to READER_BENCH_THREADS threads for READER_BENCH_MS each, with random
+// queries on random destinations, while one writer thread adds WRITER_BENCH_BURST parcels and publishes a view every millisecond. prints
+// queries/s for each number of threads, then checks every answer made sense and the trees, totals and valuation indexes are right with all
+// the writer's parcels in them
+//RETURNS: int - SUCCESS, or ERROR if a check failed
+int benchmarkReaders(HashTable* hashTable) {
+    int nameCount = countryDictionary.count;
+    const char** names = (const char**)countedMalloc(nameCount * sizeof(const char*));
+    StressWorker* workers = (StressWorker*)countedMalloc((READER_BENCH_THREADS + 1) * sizeof(StressWorker));
+    if (names == NULL || workers == NULL) {
+        perror("Unable to allocate memory for reader benchmark");
+        exit(1);
+    }
+    memcpy((void*)names, countryDictionary.names, nameCount * sizeof(const char*));
+    long long loaded = 0;
+    for (int id = 0; id < countryDictionary.count; ++id) {
+        BSTNode* root = countryNode(hashTable, id)->root;
+        loaded += (root == NULL) ? 0 : root->subtree.count;
+    }
+    FollowState writer;
+    startPublishing(&writer, hashTable);
+    std::thread* threads = new std::thread[READER_BENCH_THREADS + 1];
+    int failures = 0;
+    printf("%u hardware threads, one writer publishing %d parcels a millisecond\n", std::thread::hardware_concurrency(), WRITER_BENCH_BURST);
+    for (int count = 1; count <= READER_BENCH_THREADS; count *= 2) {
+        std::atomic<int> stop(0);
+        for (int i = 0; i <= count; ++i) {
+            workers[i].hashTable = hashTable;
+            workers[i].writer = (i == count) ? &writer : NULL;
+            workers[i].names = names;
+            workers[i].nameCount = nameCount;
+            workers[i].stop = &stop;
+            workers[i].seed = 0x9E3779B97F4A7C15ULL * (unsigned long long)(i + 1) + (unsigned long long)count;
+            workers[i].operations = 0;
+            workers[i].failures = 0;
+        }
+        double start = nowSeconds();
+        for (int i = 0; i <= count; ++i) {
+            threads[i] = std::thread((i == count) ? runStressWriter : runStressReader, &workers[i]);
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(READER_BENCH_MS));
+        stop.store(1);
+        for (int i = 0; i <= count; ++i) {
+            threads[i].join();
+        }
+        double seconds = nowSeconds() - start;
+        long long queries = 0;
+        for (int i = 0; i < count; ++i) {
+            queries += workers[i].operations;
+            failures += workers[i].failures;
+        }
+        printf("%2d query threads: %11.0f queries/s, %10.0f per thread, writer added %lld parcels\n", count, queries / seconds,
+            queries / seconds / count, workers[count].operations);
+    }
+    delete[] threads;
+    stopPublishing(&writer);
+
+    int broken = 0;
+    long long total = 0;
+    for (int id = 0; id < countryDictionary.count; ++id) {
+        HashNode* node = countryNode(hashTable, id);
+        total += (node->root == NULL) ? 0 : node->root->subtree.count;
+        if (!checkSubtreeTotals(node->root) || !checkPriceIndex(node)) {
+            broken++;
+        }
+    }
+    int passed = failures == 0 && broken == 0 && total == loaded + writer.parcelsAdded;
+    printf("%d wrong answers, %d countries failed their checks, %lld of %lld parcels in the table: %s\n", failures, broken, total,
+        loaded + writer.parcelsAdded, passed ? "passed" : "FAILED");
+    releaseFollow(&writer);
+    free((void*)names);
+    free(workers);
+    return passed ? SUCCESS : ERROR;
+}
+
+//FUNCTION: runStressReader()
+//PARAMETERS: StressWorker* worker - the thread's settings and counters
+//DESCRIPTION: a --bench-readers query thread. registers a reader slot and runs random thread-safe queries on random destinations until
+// told to stop, counting the answers that contradict themselves
+//RETURNS: void
+void runStressReader(StressWorker* worker) {
+    int reader = registerReader();
+    if (reader < 0) {
+        worker->failures++;
+        return;
+    }
+    Parcel parcels[RANGE_SAMPLE];
+    while (!worker->stop->load()) {
+        const char* country = worker->names[nextRandom(&worker->seed) % worker->nameCount];
+        int minWeight = MIN_WEIGHT + (int)(nextRandom(&worker->seed) % (MAX_WEIGHT - MIN_WEIGHT));
+        int maxWeight = minWeight + (int)(nextRandom(&worker->seed) % 5000);
+        int wrong = 0;
+        switch (nextRandom(&worker->seed) % 4) {
+        case 0: {
+            ParcelTotals totals;
+            wrong = queryTotals(worker->hashTable, reader, country, minWeight, maxWeight, &totals) == ERROR ||
+                (totals.count > 0 && totals.minValuation > totals.maxValuation);
+            break;
+        }
+        case 1: {
+            Parcel lightest;
+            Parcel heaviest;
+            wrong = queryLightestAndHeaviest(worker->hashTable, reader, country, &lightest, &heaviest) == ERROR ||
+                lightest.weight > heaviest.weight;
+            break;
+        }
+        case 2: {
+            Parcel cheapest;
+            Parcel mostExpensive;
+            wrong = queryCheapestAndMostExpensive(worker->hashTable, reader, country, &cheapest, &mostExpensive) == ERROR ||
+                cheapest.valuation > mostExpensive.valuation;
+            break;
+        }
+        default: {
+            int count = queryWeightRange(worker->hashTable, reader, country, minWeight, maxWeight, parcels, RANGE_SAMPLE);
+            wrong = count < 0;
+            for (int i = 0; i < count && i < RANGE_SAMPLE; ++i) {
+                if (parcels[i].weight < minWeight || parcels[i].weight > maxWeight || (i > 0 && parcels[i].weight < parcels[i - 1].weight)) {
+                    wrong = 1;
+                }
+            }
+            break;
+        }
+        }
+        worker->failures += wrong;
+        worker->operations++;
+    }
+    releaseReader(reader);
+}
+
+//FUNCTION: runStressWriter()
+//PARAMETERS: StressWorker* worker - the writer's settings and counters
+//DESCRIPTION: the --bench-readers writer. adds WRITER_BENCH_BURST random parcels to random destinations with followParcel(), publishes them
+// and sleeps a millisecond, until told to stop
+//RETURNS: void
+void runStressWriter(StressWorker* worker) {
+    while (!worker->stop->load()) {
+        for (int i = 0; i < WRITER_BENCH_BURST; ++i) {
+            ParsedRecord record;
+            record.destination = worker->names[nextRandom(&worker->seed) % worker->nameCount];
+            record.destinationLength = (int)strlen(record.destination);
+            record.weight = MIN_WEIGHT + (int)(nextRandom(&worker->seed) % (MAX_WEIGHT - MIN_WEIGHT + 1));
+            record.valuation = MIN_PRICE * 100 + (int)(nextRandom(&worker->seed) % ((MAX_PRICE - MIN_PRICE) * 100 + 1));
+            followParcel(worker->writer, &record);
+        }
+        publishView(worker->writer);
+        worker->operations += WRITER_BENCH_BURST;
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+}
+
+/* Read the command line */
+//FUNCTION: parseOptions()
+//PARAMETERS: int argc, char* argv[], Options* options - the arguments given to main and the struct to fill in
+//DESCRIPTION: sets the defaults (courier.txt, MAX_FLIGHTS rows, serial mmap loader) then applies --file <path>, --max-rows <n> (0 for no cap),
+// --loader mmap|scanf, --threads <n> (0 for one per core), --verify-load, --memory-report, --diagnostics, --bench-index, --bench-balance <n>,
+// --verify-totals <n>, --engine tree|columns, --bench-engines, --bench-kernels, --bench-range, --price-index, --snapshot <path>,
+// --batch <path>, --records <path>, --bench-output, --follow <path>, --bench-follow, --bench-readers, --bench-churn, --bench-traversal,
+// --report-all, --bench-report, --serve <path>, --bench-server <path>, --clients <n>, --pipeline <n>, --bench-suite, --suite-rows <n>,
+// --suite-countries <n>, --suite-skew <s>, --suite-order random|sorted, --bench-tables, --table-size <n>, --min-weight <g>,
+// --max-weight <g>, --min-price <dollars>, --max-price <dollars> and --min-rows <n>. prints the usage on anything it doesn't recognize.
+// --follow adds parcels to the trees, so it can't be used with the column engine or a snapshot, which are read-only. a snapshot only holds
+// the column store, so --snapshot picks the column engine and is refused with --engine tree
+//RETURNS: int - SUCCESS or ERROR if the arguments were invalid
+int parseOptions(int argc, char* argv[], Options* options) {
+    int engineGiven = 0;
+    options->filename = "courier.txt";
+    options->maxRows = MAX_FLIGHTS;
+    options->useScanfLoader = 0;
+    options->threads = 1;
+    options->verifyLoad = 0;
+    options->memoryReport = 0;
+    options->diagnostics = 0;
+    options->benchIndex = 0;
+    options->benchBalanceRows = 0;
+    options->verifyTotalsRows = 0;
+    options->engine = ENGINE_TREE;
+    options->benchEngines = 0;
+    options->benchKernels = 0;
+    options->benchRange = 0;
+    options->priceIndex = 0;
+    options->snapshotPath = NULL;
+    options->batchPath = NULL;
+    options->recordsPath = NULL;
+    options->benchOutput = 0;
+    options->followPath = NULL;
+    options->benchFollow = 0;
+    options->benchReaders = 0;
+    options->benchChurn = 0;
+    options->benchTraversal = 0;
+    options->benchTables = 0;
+    options->tableSize = TABLE_SIZE;
+    options->reportAll = 0;
+    options->benchReport = 0;
+    options->serverPath = NULL;
+    options->benchServerPath = NULL;
+    options->serverClients = SERVER_BENCH_CLIENTS;
+    options->serverPipeline = SERVER_BENCH_PIPELINE;
+    options->benchSuite = 0;
+    options->suiteRows = SUITE_ROWS;
+    options->suiteCountries = SUITE_COUNTRIES;
+    options->suiteSkew = SUITE_SKEW;
+    options->suiteSorted = 0;
+    options->limits = courierLimits;
+    options->minRows = MIN_FLIGHTS;
+    for (int i = 1; i < argc; ++i) {
+        const char* value = (i + 1 < argc) ? argv[i + 1] : NULL;
+        if (strcmp(argv[i], "--file") == 0 && value != NULL) {
+            options->filename = value;
+            i++;
+        }
+        else if (strcmp(argv[i], "--max-rows") == 0 && value != NULL && atoi(value) >= 0) {
+            options->maxRows = atoi(value);
+            i++;
+        }
+        else if (strcmp(argv[i], "--loader") == 0 && value != NULL &&
+            (strcmp(value, "mmap") == 0 || strcmp(value, "scanf") == 0)) {
+            options->useScanfLoader = (strcmp(value, "scanf") == 0);
+            i++;
+        }
+        else if (strcmp(argv[i], "--threads") == 0 && value != NULL && atoi(value) >= 0) {
+            options->threads = atoi(value);
+            if (options->threads == 0) {
+                options->threads = (int)std::thread::hardware_concurrency();
+                if (options->threads < 1) {
+                    options->threads = 1;
+                }
+            }
+            i++;
+        }
+        else if (strcmp(argv[i], "--verify-load") == 0) {
+            options->verifyLoad = 1;
+        }
+        else if (strcmp(argv[i], "--memory-report") == 0) {
+            options->memoryReport = 1;
+        }
+        else if (strcmp(argv[i], "--diagnostics") == 0) {
+            options->diagnostics = 1;
+        }
+        else if (strcmp(argv[i], "--bench-index") == 0) {
+            options->benchIndex = 1;
+        }
+        else if (strcmp(argv[i], "--bench-balance") == 0 && value != NULL && atoi(value) > 0) {
+            options->benchBalanceRows = atoi(value);
+            i++;
+        }
+        else if (strcmp(argv[i], "--verify-totals") == 0 && value != NULL && atoi(value) > 0) {
+            options->verifyTotalsRows = atoi(value);
+            i++;
+        }
+        else if (strcmp(argv[i], "--engine") == 0 && value != NULL &&
+            (strcmp(value, "tree") == 0 || strcmp(value, "columns") == 0)) {
+            options->engine = (strcmp(value, "columns") == 0) ? ENGINE_COLUMNS : ENGINE_TREE;
+            engineGiven = 1;
+            i++;
+        }
+        else if (strcmp(argv[i], "--bench-engines") == 0) {
+            options->benchEngines = 1;
+        }
+        else if (strcmp(argv[i], "--bench-kernels") == 0) {
+            options->benchKernels = 1;
+        }
+        else if (strcmp(argv[i], "--bench-range") == 0) {
+            options->benchRange = 1;
+        }
+        else if (strcmp(argv[i], "--price-index") == 0) {
+            options->priceIndex = 1;
+        }
+        else if (strcmp(argv[i], "--snapshot") == 0 && value != NULL) {
+            options->snapshotPath = value;
+            i++;
+        }
+        else if (strcmp(argv[i], "--batch") == 0 && value != NULL) {
+            options->batchPath = value;
+            i++;
+        }
+        else if (strcmp(argv[i], "--records") == 0 && value != NULL) {
+            options->recordsPath = value;
+            i++;
+        }
+        else if (strcmp(argv[i], "--bench-output") == 0) {
+            options->benchOutput = 1;
+        }
+        else if (strcmp(argv[i], "--follow") == 0 && value != NULL) {
+            options->followPath = value;
+            i++;
+        }
+        else if (strcmp(argv[i], "--bench-follow") == 0) {
+            options->benchFollow = 1;
+        }
+        else if (strcmp(argv[i], "--bench-readers") == 0) {
+            options->benchReaders = 1;
+        }
+        else if (strcmp(argv[i], "--bench-churn") == 0) {
+            options->benchChurn = 1;
+        }
+        else if (strcmp(argv[i], "--bench-traversal") == 0) {
+            options->benchTraversal = 1;
+        }
+        else if (strcmp(argv[i], "--bench-tables") == 0) {
+            options->benchTables = 1;
+        }
+        else if (strcmp(argv[i], "--table-size") == 0 && value != NULL && atoi(value) > 0) {
+            options->tableSize = atoi(value);
+            i++;
+        }
+        else if (strcmp(argv[i], "--report-all") == 0) {
+            options->reportAll = 1;
+        }
+        else if (strcmp(argv[i], "--bench-report") == 0) {
+            options->benchReport = 1;
+        }
+        else if (strcmp(argv[i], "--serve") == 0 && value != NULL) {
+            options->serverPath = value;
+            i++;
+        }
+        else if (strcmp(argv[i], "--bench-server") == 0 && value != NULL) {
+            options->benchServerPath = value;
+            i++;
+        }
+        else if (strcmp(argv[i], "--clients") == 0 && value != NULL && atoi(value) > 0) {
+            options->serverClients = atoi(value);
+            i++;
+        }
+        else if (strcmp(argv[i], "--pipeline") == 0 && value != NULL && atoi(value) > 0) {
+            options->serverPipeline = atoi(value);
+            i++;
+        }
+        else if (strcmp(argv[i], "--bench-suite") == 0) {
+            options->benchSuite = 1;
+        }
+        else if (strcmp(argv[i], "--suite-rows") == 0 && value != NULL && atoi(value) > 0) {
+            options->suiteRows = atoi(value);
+            i++;
+        }
+        else if (strcmp(argv[i], "--suite-countries") == 0 && value != NULL && atoi(value) > 0) {
+            options->suiteCountries = atoi(value);
+            i++;
+        }
+        else if (strcmp(argv[i], "--suite-skew") == 0 && value != NULL && atof(value) >= 0.0) {
+            options->suiteSkew = atof(value);
+            i++;
+        }
+        else if (strcmp(argv[i], "--suite-order") == 0 && value != NULL &&
+            (strcmp(value, "random") == 0 || strcmp(value, "sorted") == 0)) {
+            options->suiteSorted = strcmp(value, "sorted") == 0;
+            i++;
+        }
+        else if (strcmp(argv[i], "--min-weight") == 0 && value != NULL && atoi(value) > 0) {
+            options->limits.minWeight = atoi(value);
+            i++;
+        }
+        else if (strcmp(argv[i], "--max-weight") == 0 && value != NULL && atoi(value) > 0) {
+            options->limits.maxWeight = atoi(value);
+            i++;
+        }
+        else if (strcmp(argv[i], "--min-price") == 0 && value != NULL && atoi(value) > 0 && atoi(value) <= INT_MAX / 100) {
+            options->limits.minValuation = atoi(value) * 100;
+            i++;
+        }
+        else if (strcmp(argv[i], "--max-price") == 0 && value != NULL && atoi(value) > 0 && atoi(value) <= INT_MAX / 100) {
+            options->limits.maxValuation = atoi(value) * 100;
+            i++;
+        }
+        else if (strcmp(argv[i], "--min-rows") == 0 && value != NULL && atoi(value) >= 0) {
+            options->minRows = atoi(value);
+            i++;
+        }
+        else {
+            printf("Usage: %s [--file <path>] [--max-rows <n>, 0 for no cap] [--loader mmap|scanf] [--threads <n>, 0 for all cores]\n"
+                "          [--verify-load] [--memory-report] [--diagnostics] [--bench-index] [--bench-balance <n>] [--engine tree|columns] [--bench-engines]\n"
+                "          [--bench-kernels] [--bench-range] [--price-index] [--snapshot <path>] [--batch <path>, - for stdin] [--records <path>]\n"
+                "          [--bench-output] [--follow <path>] [--bench-follow] [--bench-readers] [--bench-churn] [--bench-traversal]\n"
+                "          [--report-all] [--bench-report] [--serve <path>] [--bench-server <path>] [--clients <n>] [--pipeline <n>]\n"
+                "          [--bench-suite] [--suite-rows <n>] [--suite-countries <n>] [--suite-skew <s>] [--suite-order random|sorted]\n"
+                "          [--verify-totals <n>] [--bench-tables] [--table-size <n>] [--min-weight <g>] [--max-weight <g>]\n"
+                "          [--min-price <dollars>] [--max-price <dollars>] [--min-rows <n>]\n", argv[0]);
+            return ERROR;
+        }
+    }
+    if (options->limits.minWeight > options->limits.maxWeight || options->limits.minValuation > options->limits.maxValuation) {
+        printf("--min-weight and --min-price can't be above --max-weight and --max-price\n");
+        return ERROR;
+    }
+    if (options->followPath != NULL && (options->engine == ENGINE_COLUMNS || options->snapshotPath != NULL)) {
+        printf("--follow adds parcels to the trees, it can't be used with --engine columns or --snapshot\n");
+        return ERROR;
+    }
+    if (options->snapshotPath != NULL && engineGiven && options->engine == ENGINE_TREE) {
+        printf("a snapshot only holds the column store, --snapshot can't be used with --engine tree\n");
+        return ERROR;
+    }
+    if (options->snapshotPath != NULL) {
+        options->engine = ENGINE_COLUMNS;
+    }
+    return SUCCESS;
+}
+
+/* Initialize the hash table */
+//FUNCTION: initializeHashTable()
+//PARAMETERS: void
+//DESCRIPTION: uses dynamically allocated space to create an empty hash table. the hash nodes are added by countryNode() as the country
+// dictionary hands out IDs, so the table grows with the number of countries instead of being fixed at 127
+//RETURNS: hashTable - pointer to the new hashtable
+HashTable* initializeHashTable(void) {
+    HashTable* hashTable = (HashTable*)countedMalloc(sizeof(HashTable));
+    if (hashTable == NULL) {
+        perror("Unable to allocate memory for hash table");
+        exit(1);
+    }
+    hashTable->nodes = NULL;
+    hashTable->capacity = 0;
+    return hashTable;
+}
+
+//FUNCTION: countryNode()
+//PARAMETERS: HashTable* hashTable, int countryId - the table and the ID of the country whose parcels are wanted
+//DESCRIPTION: gets the country's hash node, growing the table first if the ID is new. new hash nodes are initialized to a null root (so
+// there is no dangling pointer) and an empty arena. the nodes are in consecutive blocks so they can still be accessed like an array.
+//RETURNS: HashNode* - the hash node for the country
+HashNode* countryNode(HashTable* hashTable, int countryId) {
+    if (countryId >= hashTable->capacity) {
+        int capacity = (hashTable->capacity == 0) ? 128 : hashTable->capacity;
+        while (capacity <= countryId) {
+            capacity *= 2;
+        }
+        hashTable->nodes = (HashNode*)countedRealloc(hashTable->nodes, capacity * sizeof(HashNode));
+        if (hashTable->nodes == NULL) {
+            perror("Unable to allocate memory for hash table");
+            exit(1);
+        }
+        for (int i = hashTable->capacity; i < capacity; ++i) {
+            hashTable->nodes[i].root = NULL;
+            hashTable->nodes[i].priceRoot = NULL;
+            hashTable->nodes[i].arena.slabs = NULL;
+            hashTable->nodes[i].arena.bytesReserved = 0;
+            hashTable->nodes[i].arena.bytesUsed = 0;
+            memset(hashTable->nodes[i].arena.freeBlocks, 0, sizeof(hashTable->nodes[i].arena.freeBlocks));
+        }
+        hashTable->capacity = capacity;
+    }
+    return &hashTable->nodes[countryId];
+}
+
+//FUNCTION: findCountryNode()
+//PARAMETERS: const char* country, HashTable* hashTable - the country typed by the user and the table to look in
+//DESCRIPTION: resolves the name with findCountry() and returns that country's hash node, so the queries only ever see the one country's parcels
+//RETURNS: HashNode* - the country's hash node or NULL if no parcels were loaded for it
+HashNode* findCountryNode(const char* country, HashTable* hashTable) {
+    int countryId = findCountry(country);
+    if (countryId == NO_COUNTRY || countryId >= hashTable->capacity) {
+        return NULL;
+    }
+    return &hashTable->nodes[countryId];
+}
+
+/* Hash function using DJB2 algorithm */
+//FUNCTION: computeHash()
+//PARAMETERS: const char* str - the name of the country
+//DESCRIPTION: using the "djb2 function", this function creates the index of the bucket the country would have in the original 127 bucket
+// table. only used now by --bench-index to compare against that layout
+//RETURNS: unsigned long - a generated index to be used in the hash table for the country that was passed to this function
+unsigned long computeHash(const char* str) {
+    PROBE(PROBE_COMPUTE_HASH);
+    unsigned long hash = 5381;
+    int c = 0;
+    while ((c = *str++)) {
+        hash = ((hash << 5) + hash) + c;
+    }
+    return hash % TABLE_SIZE;
+}
+
+//FUNCTION: hashCountryName()
+//PARAMETERS: const char* name, int length - a country name that doesn't need to be null terminated (e.g. still inside the mapped file)
+//DESCRIPTION: the same djb2 hash as computeHash() but kept at full 64 bits instead of being cut down to a bucket, for the country index
+//RETURNS: unsigned long long - the hash of the name
+unsigned long long hashCountryName(const char* name, int length) {
+    PROBE(PROBE_HASH_NAME);
+    unsigned long long hash = 5381;
+    for (int i = 0; i < length; ++i) {
+        hash = ((hash << 5) + hash) + (unsigned char)name[i];
+    }
+    return hash;
+}
+
+//FUNCTION: homeSlot()
+//PARAMETERS: unsigned long long hash, int slotCount - a name's hash and the size of the index (a power of two)
+//DESCRIPTION: multiplies the hash by 2^64 / golden ratio so every bit of the name affects the slot, then masks it to the index size
+//RETURNS: int - the first slot to probe for the name
+int homeSlot(unsigned long long hash, int slotCount) {
+    return (int)(((hash * 11400714819323198485ull) >> 32) & (unsigned long long)(slotCount - 1));
+}
+
+/* Create a new parcel */
+//FUNCTION: isValidParcel()
+//PARAMETERS: int weight, int valuation - the values read for a parcel, the valuation in cents
+//DESCRIPTION: checks the weight is between 100gms and 50 000gms and the valuation between $10 and $2000
+//RETURNS: int - 1 if the parcel is in range, 0 if it should be skipped
+int isValidParcel(int weight, int valuation) {
+    return parcelInLimits(&parcelLimits, weight, valuation);
+}
+
+//FUNCTION: parcelInLimits()
+//PARAMETERS: const ParcelLimits* limits, int weight, int valuation - the limits and the parcel, the valuation in cents
+//DESCRIPTION: checks the parcel is within the limits, ends included. constexpr, so with limits known when compiling it folds to constants
+//RETURNS: int - 1 if the parcel is in range, 0 if not
+constexpr int parcelInLimits(const ParcelLimits* limits, int weight, int valuation) {
+    return weight >= limits->minWeight && weight <= limits->maxWeight && valuation >= limits->minValuation && valuation <= limits->maxValuation;
+}
+
+//FUNCTION: createParcel()
+//PARAMETERS: Arena* arena - the arena of the country the parcel belongs to, int countryId, int weight, int valuation - values 
+// that will be given to the fields of the parcel struct, the valuation in cents
+//DESCRIPTION: allocates space for the new parcel from the country's arena, so it sits next to the country's other parcels and is released
+// together with them by cleanup(). the destination is already interned in the country dictionary, so the parcel is a fixed size record
+//RETURNS: newParcel - pointer to the new parcel or NULL if the weight and valuation is out of the range
+Parcel* createParcel(Arena* arena, int countryId, int weight, int valuation) {
+    PROBE(PROBE_CREATE_PARCEL);
+    if (!isValidParcel(weight, valuation)) {
+        return NULL;
+    }
+    Parcel* newParcel = (Parcel*)arenaAlloc(arena, sizeof(Parcel));
+    newParcel->countryId = countryId;
+    newParcel->weight = weight;
+    newParcel->valuation = valuation;
+    return newParcel;
+}
+
+//FUNCTION: parseCents()
+//PARAMETERS: const char* text, const char* end - an amount of dollars: an optional "-", up to 7 whole digits and an optional "." and
+// fraction digits, with nothing else before end, int* cents - where to put it
+//DESCRIPTION: reads the amount straight into whole cents with integer arithmetic, so no price ever goes through a float. fraction digits
+// past the second round to the nearest cent, half a cent up, so 12.345 is 1235 cents
+//RETURNS: int - 1 if the text was an amount, 0 if not
+int parseCents(const char* text, const char* end, int* cents) {
+    const char* p = text;
+    int negative = (p < end && *p == '-');
+    p += negative;
+    const char* digitsStart = p;
+    unsigned int digit = 0;
+    int amount = 0;
+    while (p < end && (digit = (unsigned int)(*p - '0')) < 10 && p - digitsStart < 7) {
+        amount = amount * 10 + (int)digit;
+        p++;
+    }
+    int digits = (int)(p - digitsStart);
+    int fractionDigits = 0;
+    int roundUp = 0;
+    if (p < end && *p == '.') {
+        p++;
+        while (p < end && (digit = (unsigned int)(*p - '0')) < 10) {
+            if (fractionDigits < 2) {
+                amount = amount * 10 + (int)digit;
+            }
+            else if (fractionDigits == 2) {
+                roundUp = (digit >= 5);
+            }
+            fractionDigits++;
+            p++;
+        }
+    }
+    if (digits + fractionDigits == 0 || p != end) {
+        return 0;
+    }
+    for (int i = fractionDigits; i < 2; ++i) {
+        amount *= 10;
+    }
+    amount += roundUp;
+    *cents = negative ? -amount : amount;
+    return 1;
+}
+
+/* Country dictionary */
+//FUNCTION: initializeDictionary()
+//PARAMETERS: CountryDictionary* dictionary - the dictionary to set up
+//DESCRIPTION: starts the dictionary with no countries and an index of FIRST_INDEX_SLOTS empty slots
+//RETURNS: void
+void initializeDictionary(CountryDictionary* dictionary) {
+    dictionary->names = NULL;
+    dictionary->lengths = NULL;
+    dictionary->hashes = NULL;
+    dictionary->count = 0;
+    dictionary->capacity = 0;
+    dictionary->text.slabs = NULL;
+    dictionary->text.bytesReserved = 0;
+    dictionary->text.bytesUsed = 0;
+    memset(dictionary->text.freeBlocks, 0, sizeof(dictionary->text.freeBlocks));
+    dictionary->slotCount = FIRST_INDEX_SLOTS;
+    dictionary->slots = (int*)countedMalloc(FIRST_INDEX_SLOTS * sizeof(int));
+    if (dictionary->slots == NULL) {
+        perror("Unable to allocate memory for country index");
+        exit(1);
+    }
+    for (int i = 0; i < FIRST_INDEX_SLOTS; ++i) {
+        dictionary->slots[i] = NO_COUNTRY;
+    }
+}
+
+//FUNCTION: internCountry()
+//PARAMETERS: CountryDictionary* dictionary, const char* name, int length - the dictionary and a country name that doesn't need to be null terminated
+//DESCRIPTION: looks the name up with lookupCountry() and, the first time it is seen, copies it into the dictionary, gives it the next ID and
+// puts the ID in the first free slot after its home slot. the index is grown first if the new country would take it past MAX_LOAD_PERCENT.
+// IDs are handed out in the order the countries first appear, starting at 0
+//RETURNS: int - the country's ID
+int internCountry(CountryDictionary* dictionary, const char* name, int length) {
+    int id = lookupCountry(dictionary, name, length);
+    if (id != NO_COUNTRY) {
+        return id;
+    }
+    if (dictionary->count == dictionary->capacity) {
+        dictionary->capacity = (dictionary->capacity == 0) ? 128 : dictionary->capacity * 2;
+        dictionary->names = (const char**)countedRealloc(dictionary->names, dictionary->capacity * sizeof(const char*));
+        dictionary->lengths = (int*)countedRealloc(dictionary->lengths, dictionary->capacity * sizeof(int));
+        dictionary->hashes = (unsigned long long*)countedRealloc(dictionary->hashes, dictionary->capacity * sizeof(unsigned long long));
+        if (dictionary->names == NULL || dictionary->lengths == NULL || dictionary->hashes == NULL) {
+            perror("Unable to allocate memory for country dictionary");
+            exit(1);
+        }
+    }
+    if ((long long)(dictionary->count + 1) * 100 > (long long)dictionary->slotCount * MAX_LOAD_PERCENT) {
+        growCountryIndex(dictionary);
+    }
+    id = dictionary->count++;
+    char* copy = (char*)arenaAlloc(&dictionary->text, (size_t)length + 1);
+    memcpy(copy, name, length);
+    copy[length] = '\0';
+    dictionary->names[id] = copy;
+    dictionary->lengths[id] = length;
+    dictionary->hashes[id] = hashCountryName(name, length);
+    int slot = homeSlot(dictionary->hashes[id], dictionary->slotCount);
+    while (dictionary->slots[slot] != NO_COUNTRY) {
+        slot = (slot + 1) & (dictionary->slotCount - 1);
+    }
+    dictionary->slots[slot] = id;
+    return id;
+}
+
+//FUNCTION: lookupCountry()
+//PARAMETERS: const CountryDictionary* dictionary, const char* name, int length - the dictionary to search and the name to find
+//DESCRIPTION: linear probing from the name's home slot until the name or an empty slot is found. the full hashes are compared first, the
+// strings only when they match, so two countries never get mixed up even when their hashes land in the same slot
+//RETURNS: int - the country's ID or NO_COUNTRY if it isn't in the dictionary
+int lookupCountry(const CountryDictionary* dictionary, const char* name, int length) {
+    unsigned long long hash = hashCountryName(name, length);
+    int mask = dictionary->slotCount - 1;
+    int slot = homeSlot(hash, dictionary->slotCount);
+    int id = 0;
+    while ((id = dictionary->slots[slot]) != NO_COUNTRY) {
+        if (dictionary->hashes[id] == hash && dictionary->lengths[id] == length && memcmp(dictionary->names[id], name, length) == 0) {
+            return id;
+        }
+        slot = (slot + 1) & mask;
+    }
+    return NO_COUNTRY;
+}
+
+//FUNCTION: growCountryIndex()
+//PARAMETERS: CountryDictionary* dictionary - the dictionary whose index is too full
+//DESCRIPTION: doubles the number of slots and re-inserts every country using the hashes already stored for them
+//RETURNS: void
+void growCountryIndex(CountryDictionary* dictionary) {
+    int slotCount = dictionary->slotCount * 2;
+    int* slots = (int*)countedMalloc(slotCount * sizeof(int));
+    if (slots == NULL) {
+        perror("Unable to allocate memory for country index");
+        exit(1);
+    }
+    for (int i = 0; i < slotCount; ++i) {
+        slots[i] = NO_COUNTRY;
+    }
+    for (int id = 0; id < dictionary->count; ++id) {
+        int slot = homeSlot(dictionary->hashes[id], slotCount);
+        while (slots[slot] != NO_COUNTRY) {
+            slot = (slot + 1) & (slotCount - 1);
+        }
+        slots[slot] = id;
+    }
+    free(dictionary->slots);
+    dictionary->slots = slots;
+    dictionary->slotCount = slotCount;
+}
+
+//FUNCTION: findCountry()
+//PARAMETERS: const char* name - a country name typed by the user
+//DESCRIPTION: resolves the name to its ID in the global dictionary, or the follower's latest copy of it while --follow is running. after this
+// the queries only compare integers
+//RETURNS: int - the country's ID or NO_COUNTRY if no parcels were loaded for it
+int findCountry(const char* name) {
+    return lookupCountry(readDictionary(), name, (int)strlen(name));
+}
+
+//FUNCTION: countryName()
+//PARAMETERS: int countryId - an ID from the global dictionary
+//DESCRIPTION: gets the name back for printing
+//RETURNS: const char* - the country name
+const char* countryName(int countryId) {
+    return readDictionary()->names[countryId];
+}
+
+//FUNCTION: printIndexStats()
+//PARAMETERS: const CountryDictionary* dictionary - the dictionary to report on
+//DESCRIPTION: prints the load factor of the country index and how many slots a lookup probes, on average and at worst, to find each country
+//RETURNS: void
+void printIndexStats(const CountryDictionary* dictionary) {
+    long long totalProbes = 0;
+    int maxProbes = 0;
+    for (int slot = 0; slot < dictionary->slotCount; ++slot) {
+        int id = dictionary->slots[slot];
+        if (id == NO_COUNTRY) {
+            continue;
+        }
+        int probes = ((slot - homeSlot(dictionary->hashes[id], dictionary->slotCount)) & (dictionary->slotCount - 1)) + 1;
+        totalProbes += probes;
+        if (probes > maxProbes) {
+            maxProbes = probes;
+        }
+    }
+    printf("Country index: %d countries in %d slots, load factor %.2f, probes per lookup %.2f average, %d max\n",
+        dictionary->count, dictionary->slotCount, (double)dictionary->count / dictionary->slotCount,
+        dictionary->count > 0 ? (double)totalProbes / dictionary->count : 0.0, maxProbes);
+}
+
+//FUNCTION: releaseDictionary()
+//PARAMETERS: CountryDictionary* dictionary - the dictionary to free
+//DESCRIPTION: frees the name strings, the arrays and the index, leaving an empty dictionary
+//RETURNS: void
+void releaseDictionary(CountryDictionary* dictionary) {
+    free(dictionary->names);
+    free(dictionary->lengths);
+    free(dictionary->hashes);
+    free(dictionary->slots);
+    arenaRelease(&dictionary->text);
+    initializeDictionary(dictionary);
+}
+
+/* Country index benchmark */
+//FUNCTION: benchmarkCountryIndex()
+//PARAMETERS: HashTable* hashTable - the loaded table
+//DESCRIPTION: rebuilds the loaded parcels into the original layout of 127 djb2 buckets, then times both layouts. first just finding where a
+// country's parcels are (computeHash() against findCountry()), then a total load query for every country, which in the old layout has to
+// walk the whole shared bucket. it also counts how many of the old table's totals were wrong because another country shared the bucket.
+//RETURNS: void
+void benchmarkCountryIndex(HashTable* hashTable) {
+    int countries = countryDictionary.count;
+    if (countries == 0) {
+        printf("No countries loaded\n");
+        return;
+    }
+    HashNode* buckets = (HashNode*)countedCalloc(TABLE_SIZE, sizeof(HashNode));
+    if (buckets == NULL) {
+        perror("Unable to allocate memory for bucket table");
+        exit(1);
+    }
+    for (int id = 0; id < countries; ++id) {
+        copyIntoBuckets(countryNode(hashTable, id)->root, buckets);
+    }
+    printIndexStats(&countryDictionary);
+
+    unsigned long checksum = 0;
+    double start = nowSeconds();
+    for (int i = 0; i < INDEX_BENCH_LOOKUPS; ++i) {
+        checksum += computeHash(countryName(i % countries));
+    }
+    double bucketSeconds = nowSeconds() - start;
+    start = nowSeconds();
+    for (int i = 0; i < INDEX_BENCH_LOOKUPS; ++i) {
+        checksum += (unsigned long)findCountry(countryName(i % countries));
+    }
+    double indexSeconds = nowSeconds() - start;
+    printf("Lookups: 127 bucket table %.1f M/s, country index %.1f M/s (checksum %lu)\n",
+        INDEX_BENCH_LOOKUPS / bucketSeconds / 1e6, INDEX_BENCH_LOOKUPS / indexSeconds / 1e6, checksum);
+
+    long long bucketWeights = 0;
+    long long indexWeights = 0;
+    long long valuation = 0;
+    start = nowSeconds();
+    for (int id = 0; id < countries; ++id) {
+        long long totalWeight = 0;
+        traverseAndAddBST(buckets[computeHash(countryName(id))].root, totalWeight, valuation);
+        bucketWeights += totalWeight;
+    }
+    bucketSeconds = nowSeconds() - start;
+    start = nowSeconds();
+    for (int id = 0; id < countries; ++id) {
+        long long totalWeight = 0;
+        traverseAndAddBST(findCountryNode(countryName(id), hashTable)->root, totalWeight, valuation);
+        indexWeights += totalWeight;
+    }
+    indexSeconds = nowSeconds() - start;
+
+    int wrongTotals = 0;
+    for (int id = 0; id < countries; ++id) {
+        long long bucketWeight = 0;
+        long long countryWeight = 0;
+        traverseAndAddBST(buckets[computeHash(countryName(id))].root, bucketWeight, valuation);
+        traverseAndAddBST(countryNode(hashTable, id)->root, countryWeight, valuation);
+        if (bucketWeight != countryWeight) {
+            wrongTotals++;
+        }
+    }
+    int usedBuckets = 0;
+    for (int i = 0; i < TABLE_SIZE; ++i) {
+        usedBuckets += (buckets[i].root != NULL);
+    }
+    printf("Total load for all %d countries: 127 bucket table %.3f ms, country index %.3f ms (checksum %lld/%lld)\n",
+        countries, bucketSeconds * 1000.0, indexSeconds * 1000.0, bucketWeights, indexWeights);
+    printf("127 bucket table: %d buckets used, %d of %d totals included another country's parcels\n", usedBuckets, wrongTotals, countries);
+    for (int i = 0; i < TABLE_SIZE; ++i) {
+        arenaRelease(&buckets[i].arena);
+    }
+    free(buckets);
+}
+
+//FUNCTION: copyIntoBuckets()
+//PARAMETERS: BSTNode* root, HashNode* buckets - a country's tree and the 127 bucket table being rebuilt for the benchmark
+//DESCRIPTION: inserts a copy of every parcel in the tree into the bucket computeHash() gives its country, like the original loader did. the
+// tree is walked in pre-order so the copies go in the same order as they always have
+//RETURNS: void
+void copyIntoBuckets(BSTNode* root, HashNode* buckets) {
+    WeightCursor cursor;
+    openTreeCursor(&cursor, root, CURSOR_PRE_ORDER);
+    for (BSTNode* node = nextTreeCursor(&cursor); node != NULL; node = nextTreeCursor(&cursor)) {
+        HashNode* bucket = &buckets[computeHash(countryName(node->parcel->countryId))];
+        Parcel* parcel = createParcel(&bucket->arena, node->parcel->countryId, node->parcel->weight, node->parcel->valuation);
+        bucket->root = insertBST(&bucket->arena, bucket->root, parcel, NULL);
+    }
+    closeTreeCursor(&cursor);
+}
+
+/* Bucket tables */
+//FUNCTION: bucketHash()
+//PARAMETERS: const char* name or int countryId - a key
+//DESCRIPTION: the djb2 hash of a country name, or the country ID itself, multiplied by 2^64 / golden ratio like homeSlot() does, so the low
+// bits a power-of-two table masks off depend on the whole key
+//RETURNS: unsigned int - the hash the bucket is taken from
+inline unsigned int bucketHash(const char* name) {
+    return (unsigned int)((hashCountryName(name, (int)strlen(name)) * 11400714819323198485ull) >> 32);
+}
+
+inline unsigned int bucketHash(int countryId) {
+    return (unsigned int)(((unsigned long long)countryId * 11400714819323198485ull) >> 32);
+}
+
+//FUNCTION: sameKey()
+//PARAMETERS: two country names or two country IDs
+//DESCRIPTION: compares two keys of a bucket table
+//RETURNS: int - 1 if they are the same key, 0 if not
+inline int sameKey(const char* a, const char* b) {
+    return strcmp(a, b) == 0;
+}
+
+inline int sameKey(int a, int b) {
+    return a == b;
+}
+
+//FUNCTION: countryKey()
+//PARAMETERS: int countryId - a country in the dictionary
+//DESCRIPTION: the key a bucket table of that key type files the country's parcels under, its name or its ID
+//RETURNS: Key - the key
+template <> const char* countryKey<const char*>(int countryId) {
+    return countryName(countryId);
+}
+
+template <> int countryKey<int>(int countryId) {
+    return countryId;
+}
+
+//FUNCTION: openBucketTable()
+//PARAMETERS: BucketTable<Key, Buckets, Limits>* table, int bucketCount, const ParcelLimits* limits - the table to set up, and the bucket count
+// and limits for a table that takes them at run time. bucketCount is ignored unless Buckets is TABLE_RUNTIME and limits unless Limits is
+// RUNTIME_LIMITS, where NULL means courierLimits
+//DESCRIPTION: allocates the empty buckets and works out whether the count can be masked
+//RETURNS: void
+template <typename Key, int Buckets, const ParcelLimits* Limits>
+void openBucketTable(BucketTable<Key, Buckets, Limits>* table, int bucketCount, const ParcelLimits* limits) {
+    if (Buckets != TABLE_RUNTIME) {
+        bucketCount = Buckets;
+    }
+    table->buckets = (BucketEntry<Key>**)countedCalloc(bucketCount, sizeof(BucketEntry<Key>*));
+    if (table->buckets == NULL) {
+        perror("Unable to allocate memory for bucket table");
+        exit(1);
+    }
+    table->bucketCount = bucketCount;
+    table->mask = ((bucketCount & (bucketCount - 1)) == 0) ? (unsigned int)(bucketCount - 1) : 0;
+    table->limits = (limits != NULL) ? *limits : courierLimits;
+    table->keys = 0;
+    table->parcels = 0;
+    table->rejected = 0;
+    Arena empty = { NULL, 0, 0, { NULL } };
+    table->entries = empty;
+}
+
+//FUNCTION: closeBucketTable()
+//PARAMETERS: BucketTable<Key, Buckets, Limits>* table - an open table
+//DESCRIPTION: releases every key's arena, the entries and the buckets
+//RETURNS: void
+template <typename Key, int Buckets, const ParcelLimits* Limits>
+void closeBucketTable(BucketTable<Key, Buckets, Limits>* table) {
+    for (int i = 0; i < table->bucketCount; ++i) {
+        for (BucketEntry<Key>* entry = table->buckets[i]; entry != NULL; entry = entry->next) {
+            arenaRelease(&entry->node.arena);
+        }
+    }
+    arenaRelease(&table->entries);
+    free(table->buckets);
+    table->buckets = NULL;
+}
+
+//BucketReduction cuts a hash down to a compiled in bucket count: a power of two is a constant mask and any other count a modulo by a
+// constant, which the compiler turns into a multiply
+template <int Buckets, bool Masked = ((Buckets & (Buckets - 1)) == 0)>
+struct BucketReduction {
+    static unsigned int reduce(unsigned int hash) { return hash % (unsigned int)Buckets; }
+};
+
+template <int Buckets>
+struct BucketReduction<Buckets, true> {
+    static unsigned int reduce(unsigned int hash) { return hash & (unsigned int)(Buckets - 1); }
+};
+
+//FUNCTION: bucketIndex()
+//PARAMETERS: const BucketTable<Key, Buckets, Limits>* table, unsigned int hash - a table and a key's bucketHash()
+//DESCRIPTION: cuts the hash down to a bucket with BucketReduction. a TABLE_RUNTIME table masks if it was opened with a power of two and
+// divides if not
+//RETURNS: int - the bucket
+template <typename Key, int Buckets, const ParcelLimits* Limits>
+inline int bucketIndex(const BucketTable<Key, Buckets, Limits>* table, unsigned int hash) {
+    if (Buckets == TABLE_RUNTIME) {
+        return (int)((table->mask != 0) ? hash & table->mask : hash % (unsigned int)table->bucketCount);
+    }
+    return (int)BucketReduction<Buckets>::reduce(hash);
+}
+
+//FUNCTION: bucketLimits()
+//PARAMETERS: const BucketTable<Key, Buckets, Limits>* table - a table
+//DESCRIPTION: the compiled in limits, or the ones the table was opened with when Limits is RUNTIME_LIMITS
+//RETURNS: const ParcelLimits* - the limits parcels are checked against
+template <typename Key, int Buckets, const ParcelLimits* Limits>
+inline const ParcelLimits* bucketLimits(const BucketTable<Key, Buckets, Limits>* table) {
+    return (Limits != RUNTIME_LIMITS) ? Limits : &table->limits;
+}
+
+//FUNCTION: findBucketEntry()
+//PARAMETERS: const BucketTable<Key, Buckets, Limits>* table, Key key - a table and the key to look for
+//DESCRIPTION: walks the chain of the key's bucket until it finds the key
+//RETURNS: BucketEntry<Key>* - the key's entry, or NULL if the table has no parcels for it
+template <typename Key, int Buckets, const ParcelLimits* Limits>
+BucketEntry<Key>* findBucketEntry(const BucketTable<Key, Buckets, Limits>* table, Key key) {
+    BucketEntry<Key>* entry = table->buckets[bucketIndex(table, bucketHash(key))];
+    while (entry != NULL && !sameKey(entry->key, key)) {
+        entry = entry->next;
+    }
+    return entry;
+}
+
+//FUNCTION: addToBucketTable()
+//PARAMETERS: BucketTable<Key, Buckets, Limits>* table, Key key, int countryId, int weight, int valuation - the table, the key to file the
+// parcel under and the parcel, the valuation in cents
+//DESCRIPTION: checks the parcel against the table's limits, then inserts it into the key's tree, adding an entry to the front of the
+// bucket's chain the first time the key is seen
+//RETURNS: int - SUCCESS, or ERROR if the parcel was outside the limits and was counted as rejected instead
+template <typename Key, int Buckets, const ParcelLimits* Limits>
+int addToBucketTable(BucketTable<Key, Buckets, Limits>* table, Key key, int countryId, int weight, int valuation) {
+    if (!parcelInLimits(bucketLimits(table), weight, valuation)) {
+        table->rejected++;
+        return ERROR;
+    }
+    int bucket = bucketIndex(table, bucketHash(key));
+    BucketEntry<Key>* entry = table->buckets[bucket];
+    while (entry != NULL && !sameKey(entry->key, key)) {
+        entry = entry->next;
+    }
+    if (entry == NULL) {
+        entry = (BucketEntry<Key>*)arenaAlloc(&table->entries, sizeof(BucketEntry<Key>));
+        memset(entry, 0, sizeof(BucketEntry<Key>));
+        entry->key = key;
+        entry->next = table->buckets[bucket];
+        table->buckets[bucket] = entry;
+        table->keys++;
+    }
+    Parcel* parcel = createParcel(&entry->node.arena, countryId, weight, valuation);
+    entry->node.root = insertBST(&entry->node.arena, entry->node.root, parcel, NULL);
+    table->parcels++;
+    return SUCCESS;
+}
+
+//FUNCTION: bucketTableTotals()
+//PARAMETERS: const BucketTable<Key, Buckets, Limits>* table, Key key, ParcelTotals* totals - the table, a key and where to put its totals
+//DESCRIPTION: finds the key and copies the totals its tree's root keeps for the whole tree
+//RETURNS: int - SUCCESS, or ERROR with empty totals if the table has no parcels for the key
+template <typename Key, int Buckets, const ParcelLimits* Limits>
+int bucketTableTotals(const BucketTable<Key, Buckets, Limits>* table, Key key, ParcelTotals* totals) {
+    BucketEntry<Key>* entry = findBucketEntry(table, key);
+    if (entry == NULL || entry->node.root == NULL) {
+        clearTotals(totals);
+        return ERROR;
+    }
+    *totals = entry->node.root->subtree;
+    return SUCCESS;
+}
+
+//FUNCTION: benchmarkBucketTable()
+//PARAMETERS: Table* table, const char* name, HashTable* hashTable - an open, empty bucket table, what to call it and the loaded table
+//DESCRIPTION: copies every loaded parcel into the table, then times INDEX_BENCH_LOOKUPS lookups of a destination's totals. prints both times
+// and the longest chain, and checks every destination's totals against the loaded table's
+//RETURNS: int - how many destinations had different totals
+template <typename Table> int benchmarkBucketTable(Table* table, const char* name, HashTable* hashTable) {
+    typedef typename Table::KeyType Key;
+    int countries = countryDictionary.count;
+    double start = nowSeconds();
+    for (int id = 0; id < countries; ++id) {
+        WeightCursor cursor;
+        openTreeCursor(&cursor, countryNode(hashTable, id)->root, CURSOR_PRE_ORDER);
+        for (BSTNode* node = nextTreeCursor(&cursor); node != NULL; node = nextTreeCursor(&cursor)) {
+            addToBucketTable(table, countryKey<Key>(id), id, node->parcel->weight, node->parcel->valuation);
+        }
+        closeTreeCursor(&cursor);
+    }
+    double buildSeconds = nowSeconds() - start;
+    long long checksum = 0;
+    start = nowSeconds();
+    for (int i = 0; i < INDEX_BENCH_LOOKUPS; ++i) {
+        ParcelTotals totals;
+        bucketTableTotals(table, countryKey<Key>(i % countries), &totals);
+        checksum += totals.weight;
+    }
+    double lookupSeconds = nowSeconds() - start;
+    int wrong = 0;
+    for (int id = 0; id < countries; ++id) {
+        ParcelTotals totals;
+        ParcelTotals expected;
+        BSTNode* root = countryNode(hashTable, id)->root;
+        clearTotals(&expected);
+        if (root != NULL) {
+            expected = root->subtree;
+        }
+        bucketTableTotals(table, countryKey<Key>(id), &totals);
+        wrong += totals.count != expected.count || totals.weight != expected.weight || totals.valuation != expected.valuation ||
+            totals.minValuation != expected.minValuation || totals.maxValuation != expected.maxValuation;
+    }
+    int usedBuckets = 0;
+    int longestChain = 0;
+    for (int i = 0; i < table->bucketCount; ++i) {
+        int chain = 0;
+        for (BucketEntry<Key>* entry = table->buckets[i]; entry != NULL; entry = entry->next) {
+            chain++;
+        }
+        usedBuckets += (chain > 0);
+        longestChain = (chain > longestChain) ? chain : longestChain;
+    }
+    printf("  %-40s %9.3f ms %9.1f M/s  %4d of %4d buckets used, longest chain %d (checksum %lld)\n", name, buildSeconds * 1000.0,
+        INDEX_BENCH_LOOKUPS / lookupSeconds / 1e6, usedBuckets, table->bucketCount, longestChain, checksum);
+    return wrong;
+}
+
+//FUNCTION: benchmarkTables()
+//PARAMETERS: HashTable* hashTable, int runtimeBuckets - the loaded table and the bucket count for the TABLE_RUNTIME table, --table-size
+//DESCRIPTION: times the country index against bucket tables compiled for the original TABLE_SIZE buckets, for MASKED_TABLE_SIZE keyed on
+// names and on IDs, and a TABLE_RUNTIME table opened with runtimeBuckets, with benchmarkBucketTable(). then fills a runtime table opened
+// with narrower limits and checks it rejected exactly the parcels outside them
+//RETURNS: int - SUCCESS if every table agreed with the loaded one, ERROR if not
+int benchmarkTables(HashTable* hashTable, int runtimeBuckets) {
+    int countries = countryDictionary.count;
+    if (countries == 0) {
+        printf("No countries loaded\n");
+        return SUCCESS;
+    }
+    long long checksum = 0;
+    double start = nowSeconds();
+    for (int i = 0; i < INDEX_BENCH_LOOKUPS; ++i) {
+        HashNode* node = findCountryNode(countryName(i % countries), hashTable);
+        checksum += (node != NULL && node->root != NULL) ? node->root->subtree.weight : 0;
+    }
+    double indexSeconds = nowSeconds() - start;
+    printf("%d destinations, %d lookups of a destination's totals in each table:\n", countries, INDEX_BENCH_LOOKUPS);
+    printf("  %-40s %12s %13s\n", "table", "build", "lookups");
+    printf("  %-40s %12s %9.1f M/s  %4d slots (checksum %lld)\n", "country index", "loaded", INDEX_BENCH_LOOKUPS / indexSeconds / 1e6,
+        countryDictionary.slotCount, checksum);
+    int wrong = 0;
+    char name[64];
+    BucketTable<const char*, TABLE_SIZE, &courierLimits> oldSize;
+    openBucketTable(&oldSize, TABLE_SIZE, NULL);
+    snprintf(name, sizeof(name), "names, %d buckets, modulo", TABLE_SIZE);
+    wrong += benchmarkBucketTable(&oldSize, name, hashTable);
+    closeBucketTable(&oldSize);
+    BucketTable<const char*, MASKED_TABLE_SIZE, &courierLimits> masked;
+    openBucketTable(&masked, MASKED_TABLE_SIZE, NULL);
+    snprintf(name, sizeof(name), "names, %d buckets, mask", MASKED_TABLE_SIZE);
+    wrong += benchmarkBucketTable(&masked, name, hashTable);
+    closeBucketTable(&masked);
+    BucketTable<int, MASKED_TABLE_SIZE, &courierLimits> byId;
+    openBucketTable(&byId, MASKED_TABLE_SIZE, NULL);
+    snprintf(name, sizeof(name), "IDs, %d buckets, mask", MASKED_TABLE_SIZE);
+    wrong += benchmarkBucketTable(&byId, name, hashTable);
+    closeBucketTable(&byId);
+    BucketTable<const char*, TABLE_RUNTIME, RUNTIME_LIMITS> runtime;
+    openBucketTable(&runtime, runtimeBuckets, &parcelLimits);
+    snprintf(name, sizeof(name), "names, %d buckets at run time, %s", runtimeBuckets, (runtime.mask != 0) ? "mask" : "modulo");
+    wrong += benchmarkBucketTable(&runtime, name, hashTable);
+    closeBucketTable(&runtime);
+
+    ParcelLimits regional = parcelLimits;
+    regional.maxWeight = REGIONAL_MAX_WEIGHT;
+    int outside = 0;
+    openBucketTable(&runtime, runtimeBuckets, &regional);
+    for (int id = 0; id < countries; ++id) {
+        WeightCursor cursor;
+        openTreeCursor(&cursor, countryNode(hashTable, id)->root, CURSOR_PRE_ORDER);
+        for (BSTNode* node = nextTreeCursor(&cursor); node != NULL; node = nextTreeCursor(&cursor)) {
+            outside += !parcelInLimits(&regional, node->parcel->weight, node->parcel->valuation);
+            addToBucketTable(&runtime, countryName(id), id, node->parcel->weight, node->parcel->valuation);
+        }
+        closeTreeCursor(&cursor);
+    }
+    int limitsWrong = (runtime.rejected != outside);
+    printf("Run time limits of %d to %d g: %d parcels kept, %d rejected, %d expected\n", regional.minWeight, regional.maxWeight,
+        runtime.parcels, runtime.rejected, outside);
+    closeBucketTable(&runtime);
+    printf("%d destinations had different totals in a bucket table, limits %s: %s\n", wrong, limitsWrong ? "wrong" : "right",
+        (wrong == 0 && !limitsWrong) ? "passed" : "FAILED");
+    return (wrong == 0 && !limitsWrong) ? SUCCESS : ERROR;
+}
+
+/* Insert parcel into BST */
+//FUNCTION: insertBST()
+//PARAMETERS: Arena* arena - the arena of the country, BSTNode* root - the root of the BST the parcel is about to be inserted into, Parcel* parcel - 
+// the new parcel node to be inserted, FollowState* follow - NULL to change the tree in place, or the --follow writer whose published views
+// can see the tree
+//DESCRIPTION: allocates space for the parcel as a BST node from the country's arena, which holds a ptr to the parcel itself, as well as left and right.
+// each node in the BST represents a parcel. each node is placed using the parcel's weight, parcels of equal weight go to the right so they keep
+// the order they were loaded in. the function walks down with a loop, remembering the link it followed at each level, until it finds the null
+// link where the node goes, adding the parcel to the subtree totals of every node it passes. it then walks back up that path updating heights
+// and rotating any node that is out of balance, so the tree stays AVL balanced no matter what order the file is in (a weight sorted manifest
+// used to turn the tree into a linked list). it stops early once a node's height doesn't change, since nothing above it can have changed
+// either and their totals already include the parcel. when follow is given, every node on the path that is part of a published view is
+// copied before it is changed, so readers of that view never see the insert, and the original is retired with retireNode() to go back to
+// the arena once they are done. the rotations only ever move nodes on that path, so they only touch copies. nodes copied or added earlier in
+// the same batch are changed in place
+//RETURNS: root - the root of the whole bst, which a rotation may have changed
+BSTNode* insertBST(Arena* arena, BSTNode* root, Parcel* parcel, FollowState* follow) {
+    PROBE(PROBE_INSERT);
+    int countryId = parcel->countryId;
+    BSTNode* newNode = (BSTNode*)((follow != NULL) ? followerAlloc(follow, countryId, sizeof(BSTNode)) : arenaAlloc(arena, sizeof(BSTNode)));
+    newNode->parcel = parcel;
+    newNode->left = newNode->right = NULL;
+    newNode->height = 1;
+    newNode->weight = parcel->weight;
+    clearTotals(&newNode->subtree);
+    addParcelToTotals(&newNode->subtree, parcel);
+
+    BSTNode** path[MAX_TREE_HEIGHT];
+    int depth = 0;
+    BSTNode** link = &root;
+    while (*link != NULL) {
+        if (follow != NULL && !followerOwns(follow, countryId, *link)) {
+            BSTNode* copy = (BSTNode*)followerAlloc(follow, countryId, sizeof(BSTNode));
+            *copy = **link;
+            retireNode(follow, countryId, *link, sizeof(BSTNode));
+            *link = copy;
+        }
+        path[depth++] = link;
+        addParcelToTotals(&(*link)->subtree, parcel);
+        link = (parcel->weight < (*link)->weight) ? &(*link)->left : &(*link)->right;
+    }
+    *link = newNode;
+    COUNT_VISITS(depth);
+    RECORD_DEPTH(parcel->countryId, depth + 1);
+    while (depth > 0) {
+        link = path[--depth];
+        int oldHeight = (*link)->height;
+        updateNode(*link);
+        *link = rebalanceBST(*link);
+        if ((*link)->height == oldHeight) {
+            break;
+        }
+    }
+    return root;
+}
+
+//FUNCTION: nodeHeight()
+//PARAMETERS: BSTNode* node - a node or NULL
+//DESCRIPTION: height of the subtree, an empty subtree is 0
+//RETURNS: int - the height
+int nodeHeight(BSTNode* node) {
+    return (node == NULL) ? 0 : node->height;
+}
+
+//FUNCTION: updateNode()
+//PARAMETERS: BSTNode* node - a node whose children may have changed
+//DESCRIPTION: sets the node's height and subtree totals from its children's and its own parcel
+//RETURNS: void
+void updateNode(BSTNode* node) {
+    int left = nodeHeight(node->left);
+    int right = nodeHeight(node->right);
+    node->height = ((left > right) ? left : right) + 1;
+    clearTotals(&node->subtree);
+    if (node->left != NULL) {
+        addTotals(&node->subtree, &node->left->subtree);
+    }
+    addParcelToTotals(&node->subtree, node->parcel);
+    if (node->right != NULL) {
+        addTotals(&node->subtree, &node->right->subtree);
+    }
+}
+
+//FUNCTION: clearTotals()
+//PARAMETERS: ParcelTotals* totals - the totals to reset
+//DESCRIPTION: sets the totals to those of no parcels at all
+//RETURNS: void
+void clearTotals(ParcelTotals* totals) {
+    totals->count = 0;
+    totals->weight = 0;
+    totals->valuation = 0;
+    totals->minValuation = INT_MAX;
+    totals->maxValuation = INT_MIN;
+}
+
+//FUNCTION: addParcelToTotals()
+//PARAMETERS: ParcelTotals* totals, const Parcel* parcel - the totals and the parcel to add to them
+//DESCRIPTION: counts the parcel, adds its weight and valuation and widens the price range if needed
+//RETURNS: void
+void addParcelToTotals(ParcelTotals* totals, const Parcel* parcel) {
+    totals->count++;
+    totals->weight += parcel->weight;
+    totals->valuation += parcel->valuation;
+    if (parcel->valuation < totals->minValuation) {
+        totals->minValuation = parcel->valuation;
+    }
+    if (parcel->valuation > totals->maxValuation) {
+        totals->maxValuation = parcel->valuation;
+    }
+}
+
+//FUNCTION: addTotals()
+//PARAMETERS: ParcelTotals* totals, const ParcelTotals* more - the totals and another set of totals to add to them
+//DESCRIPTION: combines two sets of totals as if their parcels had been added one by one
+//RETURNS: void
+void addTotals(ParcelTotals* totals, const ParcelTotals* more) {
+    totals->count += more->count;
+    totals->weight += more->weight;
+    totals->valuation += more->valuation;
+    if (more->minValuation < totals->minValuation) {
+        totals->minValuation = more->minValuation;
+    }
+    if (more->maxValuation > totals->maxValuation) {
+        totals->maxValuation = more->maxValuation;
+    }
+}
+
+//FUNCTION: checkSubtreeTotals()
+//PARAMETERS: BSTNode* root - a tree
+//DESCRIPTION: recomputes every node's totals from its children's stored ones and compares them to its own. each node is only checked against
+// its children, so the nodes can be visited in any order and a cursor walks them in pre-order. used by --verify-load
+//RETURNS: int - 1 if every node's totals are right, 0 if not
+int checkSubtreeTotals(BSTNode* root) {
+    WeightCursor cursor;
+    openTreeCursor(&cursor, root, CURSOR_PRE_ORDER);
+    int correct = 1;
+    for (BSTNode* node = nextTreeCursor(&cursor); node != NULL && correct; node = nextTreeCursor(&cursor)) {
+        ParcelTotals stored = node->subtree;
+        updateNode(node);
+        correct = stored.count == node->subtree.count && stored.weight == node->subtree.weight &&
+            stored.valuation == node->subtree.valuation && stored.minValuation == node->subtree.minValuation &&
+            stored.maxValuation == node->subtree.maxValuation;
+    }
+    closeTreeCursor(&cursor);
+    return correct;
+}
+
+//FUNCTION: rotateLeft()
+//PARAMETERS: BSTNode* node - the root of a subtree that is too tall on the right
+//DESCRIPTION: makes the right child the root of the subtree, the node becomes its left child and takes over its old left subtree
+//RETURNS: BSTNode* - the new root of the subtree
+BSTNode* rotateLeft(BSTNode* node) {
+    BSTNode* right = node->right;
+    node->right = right->left;
+    right->left = node;
+    updateNode(node);
+    updateNode(right);
+    return right;
+}
+
+//FUNCTION: rotateRight()
+//PARAMETERS: BSTNode* node - the root of a subtree that is too tall on the left
+//DESCRIPTION: the mirror of rotateLeft()
+//RETURNS: BSTNode* - the new root of the subtree
+BSTNode* rotateRight(BSTNode* node) {
+    BSTNode* left = node->left;
+    node->left = left->right;
+    left->right = node;
+    updateNode(node);
+    updateNode(left);
+    return left;
+}
+
+//FUNCTION: rebalanceBST()
+//PARAMETERS: BSTNode* node - a node whose height is up to date and whose subtrees are balanced
+//DESCRIPTION: if one side is two taller than the other, rotates the node the other way. when the taller child leans the opposite way, that
+// child is rotated first (the double rotation case) so the result is balanced
+//RETURNS: BSTNode* - the root of the subtree, which is a different node if it rotated
+BSTNode* rebalanceBST(BSTNode* node) {
+    int balance = nodeHeight(node->left) - nodeHeight(node->right);
+    if (balance > 1) {
+        if (nodeHeight(node->left->left) < nodeHeight(node->left->right)) {
+            node->left = rotateLeft(node->left);
+        }
+        return rotateRight(node);
+    }
+    if (balance < -1) {
+        if (nodeHeight(node->right->right) < nodeHeight(node->right->left)) {
+            node->right = rotateRight(node->right);
+        }
+        return rotateLeft(node);
+    }
+    return node;
+}
+
+/* Valuation index */
+//FUNCTION: addParcel()
+//PARAMETERS: HashNode* node, Parcel* parcel - the country's hash node and a parcel allocated from its arena
+//DESCRIPTION: inserts the parcel into the country's weight tree, and into its valuation index too if that has been built. the loaders add
+// every parcel through here so the two trees always hold the same parcels
+//RETURNS: void
+void addParcel(HashNode* node, Parcel* parcel) {
+    node->root = insertBST(&node->arena, node->root, parcel, NULL);
+    if (node->priceRoot != NULL) {
+        node->priceRoot = insertPrice(&node->arena, node->priceRoot, parcel, NULL);
+    }
+}
+
+//FUNCTION: buildPriceIndex()
+//PARAMETERS: HashNode* node - a country's hash node
+//DESCRIPTION: builds the country's valuation index if it doesn't have one yet. the index isn't kept during loading since most countries
+// never get a price query, so the first one that needs it collects the parcels in weight order, sorts them by valuation and builds a
+// balanced tree from the sorted list in one go. the nodes come from the country's arena like the rest of its trees
+//RETURNS: void
+void buildPriceIndex(HashNode* node) {
+    if (node->priceRoot != NULL || node->root == NULL) {
+        return;
+    }
+    int count = node->root->subtree.count;
+    PricedParcel* parcels = (PricedParcel*)countedMalloc(count * sizeof(PricedParcel));
+    if (parcels == NULL) {
+        perror("Unable to allocate memory for valuation index");
+        exit(1);
+    }
+    int next = 0;
+    collectParcels(node->root, parcels, next);
+    qsort(parcels, count, sizeof(PricedParcel), comparePricedParcels);
+    node->priceRoot = buildPriceTree(&node->arena, parcels, count);
+    free(parcels);
+}
+
+//FUNCTION: buildAllPriceIndexes()
+//PARAMETERS: HashTable* hashTable - the loaded table
+//DESCRIPTION: builds the valuation index of every country, used by --price-index so no query has to wait for one
+//RETURNS: void
+void buildAllPriceIndexes(HashTable* hashTable) {
+    for (int id = 0; id < countryDictionary.count; ++id) {
+        buildPriceIndex(countryNode(hashTable, id));
+    }
+}
+
+//FUNCTION: collectParcels()
+//PARAMETERS: BSTNode* root, PricedParcel* parcels, int& next - a weight tree, the list to fill and the next free place in it
+//DESCRIPTION: in-order traversal that appends each parcel to the list along with its position in weight order
+//RETURNS: void - next is passed by reference and ends one past the last parcel added
+void collectParcels(BSTNode* root, PricedParcel* parcels, int& next) {
+    WeightCursor cursor;
+    openTreeCursor(&cursor, root, CURSOR_IN_ORDER);
+    for (BSTNode* node = nextTreeCursor(&cursor); node != NULL; node = nextTreeCursor(&cursor)) {
+        parcels[next].parcel = node->parcel;
+        parcels[next].order = next;
+        next++;
+    }
+    closeTreeCursor(&cursor);
+}
+
+//FUNCTION: comparePricedParcels()
+//PARAMETERS: const void* first, const void* second - two PricedParcels
+//DESCRIPTION: qsort() comparison by valuation, parcels of equal valuation keep their weight order so the index is the same every run
+//RETURNS: int - negative, zero or positive like strcmp()
+int comparePricedParcels(const void* first, const void* second) {
+    const PricedParcel* a = (const PricedParcel*)first;
+    const PricedParcel* b = (const PricedParcel*)second;
+    if (a->parcel->valuation != b->parcel->valuation) {
+        return (a->parcel->valuation < b->parcel->valuation) ? -1 : 1;
+    }
+    return a->order - b->order;
+}
+
+//FUNCTION: buildPriceTree()
+//PARAMETERS: Arena* arena, PricedParcel* parcels, int count - the country's arena and its parcels sorted by valuation
+//DESCRIPTION: makes the middle parcel the root and builds the two halves the same way, which gives a tree that is as balanced as possible
+//RETURNS: PriceNode* - the root of the new index, NULL if count is 0
+PriceNode* buildPriceTree(Arena* arena, PricedParcel* parcels, int count) {
+    if (count == 0) {
+        return NULL;
+    }
+    int middle = count / 2;
+    PriceNode* node = (PriceNode*)arenaAlloc(arena, sizeof(PriceNode));
+    node->parcel = parcels[middle].parcel;
+    node->valuation = node->parcel->valuation;
+    node->left = buildPriceTree(arena, parcels, middle);
+    node->right = buildPriceTree(arena, parcels + middle + 1, count - middle - 1);
+    updatePriceHeight(node);
+    return node;
+}
+
+//FUNCTION: insertPrice()
+//PARAMETERS: Arena* arena, PriceNode* root, Parcel* parcel, FollowState* follow - the country's arena, the root of its valuation
+// index, the parcel to add and the same follower insertBST() takes
+//DESCRIPTION: the same iterative AVL insert as insertBST() keyed on valuation instead of weight, used for parcels added after the index was
+// built. parcels of equal valuation are ordered by weight, and of equal weight too go to the right, after the ones already in the index.
+// that keeps ties in the weight tree's order, as buildPriceIndex() leaves them, so the ends of the index stay the parcels findPriceRange()
+// finds. published nodes are copied like insertBST() does
+//RETURNS: PriceNode* - the root of the index, which a rotation may have changed
+PriceNode* insertPrice(Arena* arena, PriceNode* root, Parcel* parcel, FollowState* follow) {
+    int countryId = parcel->countryId;
+    PriceNode* newNode = (PriceNode*)((follow != NULL) ? followerAlloc(follow, countryId, sizeof(PriceNode)) : arenaAlloc(arena, sizeof(PriceNode)));
+    newNode->parcel = parcel;
+    newNode->left = newNode->right = NULL;
+    newNode->height = 1;
+    newNode->valuation = parcel->valuation;
+
+    PriceNode** path[MAX_TREE_HEIGHT];
+    int depth = 0;
+    PriceNode** link = &root;
+    while (*link != NULL) {
+        if (follow != NULL && !followerOwns(follow, countryId, *link)) {
+            PriceNode* copy = (PriceNode*)followerAlloc(follow, countryId, sizeof(PriceNode));
+            *copy = **link;
+            retireNode(follow, countryId, *link, sizeof(PriceNode));
+            *link = copy;
+        }
+        path[depth++] = link;
+        int before = parcel->valuation < (*link)->valuation ||
+            (parcel->valuation == (*link)->valuation && parcel->weight < (*link)->parcel->weight);
+        link = before ? &(*link)->left : &(*link)->right;
+    }
+    *link = newNode;
+    while (depth > 0) {
+        link = path[--depth];
+        int oldHeight = (*link)->height;
+        updatePriceHeight(*link);
+        *link = rebalancePrice(*link);
+        if ((*link)->height == oldHeight) {
+            break;
+        }
+    }
+    return root;
+}
+
+//FUNCTION: priceHeight()
+//PARAMETERS: PriceNode* node - a node or NULL
+//DESCRIPTION: nodeHeight() for the valuation index
+//RETURNS: int - the height
+int priceHeight(PriceNode* node) {
+    return (node == NULL) ? 0 : node->height;
+}
+
+//FUNCTION: updatePriceHeight()
+//PARAMETERS: PriceNode* node - a node whose children may have changed
+//DESCRIPTION: sets the node's height from its children's
+//RETURNS: void
+void updatePriceHeight(PriceNode* node) {
+    int left = priceHeight(node->left);
+    int right = priceHeight(node->right);
+    node->height = ((left > right) ? left : right) + 1;
+}
+
+//FUNCTION: rotatePriceLeft()
+//PARAMETERS: PriceNode* node - the root of a subtree that is too tall on the right
+//DESCRIPTION: rotateLeft() for the valuation index
+//RETURNS: PriceNode* - the new root of the subtree
+PriceNode* rotatePriceLeft(PriceNode* node) {
+    PriceNode* right = node->right;
+    node->right = right->left;
+    right->left = node;
+    updatePriceHeight(node);
+    updatePriceHeight(right);
+    return right;
+}
+
+//FUNCTION: rotatePriceRight()
+//PARAMETERS: PriceNode* node - the root of a subtree that is too tall on the left
+//DESCRIPTION: rotateRight() for the valuation index
+//RETURNS: PriceNode* - the new root of the subtree
+PriceNode* rotatePriceRight(PriceNode* node) {
+    PriceNode* left = node->left;
+    node->left = left->right;
+    left->right = node;
+    updatePriceHeight(node);
+    updatePriceHeight(left);
+    return left;
+}
+
+//FUNCTION: rebalancePrice()
+//PARAMETERS: PriceNode* node - a node whose height is up to date and whose subtrees are balanced
+//DESCRIPTION: rebalanceBST() for the valuation index
+//RETURNS: PriceNode* - the root of the subtree, which is a different node if it rotated
+PriceNode* rebalancePrice(PriceNode* node) {
+    int balance = priceHeight(node->left) - priceHeight(node->right);
+    if (balance > 1) {
+        if (priceHeight(node->left->left) < priceHeight(node->left->right)) {
+            node->left = rotatePriceLeft(node->left);
+        }
+        return rotatePriceRight(node);
+    }
+    if (balance < -1) {
+        if (priceHeight(node->right->right) < priceHeight(node->right->left)) {
+            node->right = rotatePriceRight(node->right);
+        }
+        return rotatePriceLeft(node);
+    }
+    return node;
+}
+
+//FUNCTION: checkPriceIndex()
+//PARAMETERS: HashNode* node - a country's hash node
+//DESCRIPTION: checks the valuation index is in order, holds as many parcels as the weight tree, and that its two ends have the same prices
+// and weights as the parcels findPriceRange() finds by walking the weight tree. used by --verify-load
+//RETURNS: int - 1 if the index matches the weight tree, 0 if not
+int checkPriceIndex(HashNode* node) {
+    if (node->root == NULL || node->priceRoot == NULL) {
+        return node->root == NULL && node->priceRoot == NULL;
+    }
+    int previous = INT_MIN;
+    int count = 0;
+    if (!checkPriceOrder(node->priceRoot, &previous, &count) || count != node->root->subtree.count) {
+        return 0;
+    }
+    PriceNode* cheapest = node->priceRoot;
+    PriceNode* expensive = node->priceRoot;
+    while (cheapest->left != NULL) {
+        cheapest = cheapest->left;
+    }
+    while (expensive->right != NULL) {
+        expensive = expensive->right;
+    }
+    Parcel* lowest = node->root->parcel;
+    Parcel* highest = node->root->parcel;
+    findPriceRange(node->root, &lowest, &highest);
+    return cheapest->valuation == lowest->valuation && cheapest->parcel->weight == lowest->weight &&
+        expensive->valuation == highest->valuation && expensive->parcel->weight == highest->weight;
+}
+
+//FUNCTION: checkPriceOrder()
+//PARAMETERS: PriceNode* root, int* previous, int* count - a valuation index, the valuation of the node visited before it and the number of
+// nodes visited so far
+//DESCRIPTION: in-order traversal checking no node is cheaper than the one before it, and counting the nodes
+//RETURNS: int - 1 if the index is in order, 0 if not
+int checkPriceOrder(PriceNode* root, int* previous, int* count) {
+    PriceCursor cursor;
+    openTreeCursor(&cursor, root, CURSOR_IN_ORDER);
+    int ordered = 1;
+    for (PriceNode* node = nextTreeCursor(&cursor); node != NULL; node = nextTreeCursor(&cursor)) {
+        if (node->valuation < *previous || node->valuation != node->parcel->valuation) {
+            ordered = 0;
+            break;
+        }
+        *previous = node->valuation;
+        (*count)++;
+    }
+    closeTreeCursor(&cursor);
+    return ordered;
+}
+
+/* Tree balance benchmark */
+//FUNCTION: benchmarkBalance()
+//PARAMETERS: int rows - how many parcels to insert for each input order
+//DESCRIPTION: builds one country's tree from generated parcels in weight sorted, reverse sorted and random order and prints the time taken and
+// the height of the tree against log2 of the parcel count. sorted input is what turned the old unbalanced tree into a linked list, an AVL
+// tree is never more than about 1.44 times log2(n) tall whatever the order
+//RETURNS: void
+void benchmarkBalance(int rows) {
+    const char* orders[] = { "sorted", "reverse sorted", "random" };
+    Parcel* parcels = (Parcel*)countedMalloc((size_t)rows * sizeof(Parcel));
+    if (parcels == NULL) {
+        perror("Unable to allocate memory for benchmark parcels");
+        exit(1);
+    }
+    unsigned long long seed = 12345;
+    for (int order = 0; order < 3; ++order) {
+        for (int i = 0; i < rows; ++i) {
+            int weight = MIN_WEIGHT + (int)((long long)i * (MAX_WEIGHT - MIN_WEIGHT) / rows);
+            if (order == 1) {
+                weight = MAX_WEIGHT - (weight - MIN_WEIGHT);
+            }
+            else if (order == 2) {
+                weight = MIN_WEIGHT + (int)(nextRandom(&seed) % (MAX_WEIGHT - MIN_WEIGHT + 1));
+            }
+            parcels[i].countryId = 0;
+            parcels[i].weight = weight;
+            parcels[i].valuation = MIN_PRICE * 100 + (int)(nextRandom(&seed) % ((MAX_PRICE - MIN_PRICE) * 100));
+        }
+        Arena arena = { NULL, 0, 0, { NULL } };
+        BSTNode* root = NULL;
+        double start = nowSeconds();
+        for (int i = 0; i < rows; ++i) {
+            root = insertBST(&arena, root, &parcels[i], NULL);
+        }
+        double seconds = nowSeconds() - start;
+        int log2Rows = 0;
+        while ((1LL << (log2Rows + 1)) <= rows) {
+            log2Rows++;
+        }
+        printf("%-15s %d parcels: %.3f ms (%.0f inserts/s), height %d, minimum possible %d\n",
+            orders[order], rows, seconds * 1000.0, rows / (seconds > 0.0 ? seconds : 1e-9), nodeHeight(root), log2Rows + 1);
+        arenaRelease(&arena);
+    }
+    free(parcels);
+}
+
+//FUNCTION: nextRandom()
+//PARAMETERS: unsigned long long* state - the generator state, any value but 0 to start
+//DESCRIPTION: xorshift64 generator, so the generated benchmark data is the same on every run and platform
+//RETURNS: unsigned long long - the next random number
+unsigned long long nextRandom(unsigned long long* state) {
+    unsigned long long x = *state;
+    x ^= x << 13;
+    x ^= x >> 7;
+    x ^= x << 17;
+    *state = x;
+    return x;
+}
+
+/* Arena allocator */
+//FUNCTION: arenaAlloc()
+//PARAMETERS: Arena* arena, size_t size - the arena to allocate from and how many bytes are needed
+//DESCRIPTION: reuses a block of the same size given back with arenaFree() if there is one. otherwise bumps a pointer in the arena's newest
+// slab. when the slab is full a new one is malloc'd, each one twice the size of the last up to MAX_SLAB_SIZE, so a country's nodes end up in
+// a handful of contiguous blocks instead of one malloc each. the slabs themselves are only freed all at once in arenaRelease().
+//RETURNS: void* - the allocated memory, aligned to ARENA_ALIGNMENT
+void* arenaAlloc(Arena* arena, size_t size) {
+    size = (size + ARENA_ALIGNMENT - 1) & ~(size_t)(ARENA_ALIGNMENT - 1);
+    size_t sizeClass = size / ARENA_ALIGNMENT - 1;
+    if (sizeClass < FREE_LIST_CLASSES && arena->freeBlocks[sizeClass] != NULL) {
+        void* block = arena->freeBlocks[sizeClass];
+        arena->freeBlocks[sizeClass] = *(void**)block;
+        arena->bytesUsed += size;
+        return block;
+    }
+    Slab* slab = arena->slabs;
+    if (slab == NULL || slab->used + size > slab->capacity) {
+        size_t capacity = (slab == NULL) ? FIRST_SLAB_SIZE : slab->capacity * 2;
+        if (capacity > MAX_SLAB_SIZE) {
+            capacity = MAX_SLAB_SIZE;
+        }
+        if (capacity < size) {
+            capacity = size;
+        }
+        Slab* newSlab = (Slab*)countedMalloc(sizeof(Slab) + capacity);
+        if (newSlab == NULL) {
+            perror("Unable to allocate memory for arena slab");
+            exit(1);
+        }
+        newSlab->next = slab;
+        newSlab->used = 0;
+        newSlab->capacity = capacity;
+        arena->slabs = newSlab;
+        arena->bytesReserved += sizeof(Slab) + capacity;
+        slab = newSlab;
+    }
+    void* memory = (char*)(slab + 1) + slab->used;
+    slab->used += size;
+    arena->bytesUsed += size;
+    return memory;
+}
+
+//FUNCTION: arenaFree()
+//PARAMETERS: Arena* arena, void* memory, size_t size - the arena the block came from, the block and the size it was allocated with
+//DESCRIPTION: puts the block on the free list for its size so the next arenaAlloc() of that size gets it back, which keeps a country's
+// memory from growing when parcels are delivered and new ones arrive. blocks bigger than the free lists cover stay used until
+// arenaRelease(). under --follow only the follower frees, through reclaimRetired(), once no published view can be reading the block
+//RETURNS: void
+void arenaFree(Arena* arena, void* memory, size_t size) {
+    size = (size + ARENA_ALIGNMENT - 1) & ~(size_t)(ARENA_ALIGNMENT - 1);
+    size_t sizeClass = size / ARENA_ALIGNMENT - 1;
+    if (sizeClass >= FREE_LIST_CLASSES) {
+        return;
+    }
+    *(void**)memory = arena->freeBlocks[sizeClass];
+    arena->freeBlocks[sizeClass] = memory;
+    arena->bytesUsed -= size;
+}
+
+//FUNCTION: arenaRelease()
+//PARAMETERS: Arena* arena - the arena to empty
+//DESCRIPTION: frees every slab of the arena, which frees every parcel, node and destination that was allocated from it
+//RETURNS: void
+void arenaRelease(Arena* arena) {
+    Slab* slab = arena->slabs;
+    while (slab != NULL) {
+        Slab* next = slab->next;
+        free(slab);
+        slab = next;
+    }
+    arena->slabs = NULL;
+    arena->bytesReserved = 0;
+    arena->bytesUsed = 0;
+    memset(arena->freeBlocks, 0, sizeof(arena->freeBlocks));
+}
+
+/* Table diagnostics */
+//FUNCTION: printDiagnostics()
+//PARAMETERS: HashTable* hashTable - the loaded table
+//DESCRIPTION: prints what the table and trees look like, to tell a slow country's tree shape apart from bucket sharing: the country index's
+// load and a histogram of the probes each lookup takes, then every country's parcel count, tree height next to the best possible height,
+// average node depth, valuation index height and arena memory. the old 127 bucket table is rebuilt with copyIntoBuckets() so the same is
+// printed for each of its buckets with the countries that would share it, followed by how many buckets hold 0, 1, 2 and more countries.
+// it ends with the bytes per parcel of the trees next to what the column store would need
+//RETURNS: void
+void printDiagnostics(HashTable* hashTable) {
+    int countries = countryDictionary.count;
+    printIndexStats(&countryDictionary);
+    int* probeCounts = (int*)countedCalloc((size_t)countryDictionary.slotCount + 1, sizeof(int));
+    HashNode* buckets = (HashNode*)countedCalloc(TABLE_SIZE, sizeof(HashNode));
+    int* bucketCountries = (int*)countedCalloc(TABLE_SIZE, sizeof(int));
+    if (probeCounts == NULL || buckets == NULL || bucketCountries == NULL) {
+        perror("Unable to allocate memory for diagnostics");
+        exit(1);
+    }
+    for (int slot = 0; slot < countryDictionary.slotCount; ++slot) {
+        int id = countryDictionary.slots[slot];
+        if (id != NO_COUNTRY) {
+            probeCounts[((slot - homeSlot(countryDictionary.hashes[id], countryDictionary.slotCount)) & (countryDictionary.slotCount - 1)) + 1]++;
+        }
+    }
+    printf("Probes per country lookup:");
+    int listed = 0;
+    for (int probes = 1; probes <= countryDictionary.slotCount; ++probes) {
+        if (probeCounts[probes] > 0) {
+            printf("%s %d probe%s x %d", (listed++ > 0) ? "," : "", probes, (probes == 1) ? "" : "s", probeCounts[probes]);
+        }
+    }
+    printf("\n\n%-20s %9s %7s %8s %10s %12s %14s %12s\n", "Country", "parcels", "height", "optimal", "avg depth", "price height",
+        "arena bytes", "bytes/parcel");
+    size_t treeBytes = 0;
+    int parcels = 0;
+    for (int id = 0; id < countries; ++id) {
+        HashNode* node = countryNode(hashTable, id);
+        int count = (node->root == NULL) ? 0 : node->root->subtree.count;
+        printf("%-20s", countryDictionary.names[id]);
+        printTreeShape(node->root);
+        printf(" %12d %14zu %12.1f\n", priceHeight(node->priceRoot), node->arena.bytesReserved,
+            (count == 0) ? 0.0 : (double)node->arena.bytesReserved / count);
+        treeBytes += node->arena.bytesReserved;
+        parcels += count;
+        copyIntoBuckets(node->root, buckets);
+        bucketCountries[computeHash(countryDictionary.names[id])]++;
+    }
+
+    printf("\nOld 127 bucket table, rebuilt with computeHash() for comparison:\n%-6s %9s %9s %7s %8s %10s %14s  %s\n", "Bucket",
+        "countries", "parcels", "height", "optimal", "avg depth", "arena bytes", "countries in it");
+    for (int i = 0; i < TABLE_SIZE; ++i) {
+        if (bucketCountries[i] == 0) {
+            continue;
+        }
+        printf("%-6d %9d", i, bucketCountries[i]);
+        printTreeShape(buckets[i].root);
+        printf(" %14zu  ", buckets[i].arena.bytesReserved);
+        listed = 0;
+        for (int id = 0; id < countries; ++id) {
+            if ((int)computeHash(countryDictionary.names[id]) == i) {
+                printf("%s%s", (listed++ > 0) ? ", " : "", countryDictionary.names[id]);
+            }
+        }
+        printf("\n");
+    }
+    int most = 0;
+    for (int i = 0; i < TABLE_SIZE; ++i) {
+        most = (bucketCountries[i] > most) ? bucketCountries[i] : most;
+    }
+    printf("Countries per bucket:");
+    for (int shared = 0; shared <= most; ++shared) {
+        int count = 0;
+        for (int i = 0; i < TABLE_SIZE; ++i) {
+            count += (bucketCountries[i] == shared);
+        }
+        if (count > 0) {
+            printf(" %d in %d bucket%s%s", shared, count, (count == 1) ? "" : "s", (shared < most) ? "," : "");
+        }
+    }
+    size_t columnBytes = (size_t)parcels * (4 * sizeof(int)) + (size_t)(countries + 1) * sizeof(int);
+    printf("\nEngines: trees %zu bytes (%.1f bytes/parcel), column store %zu bytes (%.1f bytes/parcel)\n", treeBytes,
+        (parcels == 0) ? 0.0 : (double)treeBytes / parcels, columnBytes, (parcels == 0) ? 0.0 : (double)columnBytes / parcels);
+    for (int i = 0; i < TABLE_SIZE; ++i) {
+        arenaRelease(&buckets[i].arena);
+    }
+    free(buckets);
+    free(bucketCountries);
+    free(probeCounts);
+}
+
+//FUNCTION: printTreeShape()
+//PARAMETERS: BSTNode* root - a tree, which may be empty
+//DESCRIPTION: prints the tree's parcel count, height, the height a perfectly balanced tree of that many parcels would have and the average
+// depth of its nodes, the root being at depth 1, as columns of a printDiagnostics() row
+//RETURNS: void
+void printTreeShape(BSTNode* root) {
+    int count = (root == NULL) ? 0 : root->subtree.count;
+    long long depths = sumDepths(root);
+    printf(" %9d %7d %8d %10.2f", count, nodeHeight(root), optimalHeight(count), (count == 0) ? 0.0 : (double)depths / count);
+}
+
+//FUNCTION: sumDepths()
+//PARAMETERS: BSTNode* root - a tree, which may be empty
+//DESCRIPTION: adds up the depth of every node, the root being at depth 1. a node is counted once in the subtree of each node on its path
+// from the root, itself included, so the total is the sum of every node's subtree count and the walk doesn't need to know any depths
+//RETURNS: long long - the total depth
+long long sumDepths(BSTNode* root) {
+    WeightCursor cursor;
+    openTreeCursor(&cursor, root, CURSOR_PRE_ORDER);
+    long long total = 0;
+    for (BSTNode* node = nextTreeCursor(&cursor); node != NULL; node = nextTreeCursor(&cursor)) {
+        total += node->subtree.count;
+    }
+    closeTreeCursor(&cursor);
+    return total;
+}
+
+//FUNCTION: optimalHeight()
+//PARAMETERS: int count - a number of parcels
+//DESCRIPTION: the height of the shortest binary tree that can hold them, the smallest h with 2^h - 1 >= count
+//RETURNS: int - the height, 0 for no parcels
+int optimalHeight(int count) {
+    int height = 0;
+    while (height < 31 && ((1LL << height) - 1) < count) {
+        height++;
+    }
+    return height;
+}
+
+/* Memory report */
+//FUNCTION: printMemoryReport()
+//PARAMETERS: HashTable* hashTable - the loaded table
+//DESCRIPTION: prints the bytes per parcel the arenas actually reserved next to what the old one-malloc-per-object layout would have used
+// for the same parcels (a Parcel with a destination pointer, a BSTNode and a destination string each, with malloc's chunk header and rounding).
+// the dictionary's one copy of each name is counted on the arena side
+//RETURNS: void
+void printMemoryReport(HashTable* hashTable) {
+    size_t reserved = 0;
+    size_t used = 0;
+    size_t mallocBytes = 0;
+    int parcels = 0;
+    for (int i = 0; i < hashTable->capacity; ++i) {
+        reserved += hashTable->nodes[i].arena.bytesReserved;
+        used += hashTable->nodes[i].arena.bytesUsed;
+        addMallocFootprint(hashTable->nodes[i].root, mallocBytes, parcels);
+    }
+    size_t dictionaryEntry = sizeof(const char*) + sizeof(int) + sizeof(unsigned long long);
+    reserved += countryDictionary.text.bytesReserved + countryDictionary.capacity * dictionaryEntry +
+        countryDictionary.slotCount * sizeof(int) + hashTable->capacity * sizeof(HashNode);
+    used += countryDictionary.text.bytesUsed + countryDictionary.count * dictionaryEntry +
+        countryDictionary.slotCount * sizeof(int) + countryDictionary.count * sizeof(HashNode);
+    if (parcels == 0) {
+        printf("No parcels loaded\n");
+        return;
+    }
+    printf("Memory for %d parcels:\n", parcels);
+    printf("  malloc per object (before): %zu bytes, %.1f bytes/parcel\n", mallocBytes, (double)mallocBytes / parcels);
+    printf("  arena slabs (after):        %zu bytes reserved, %zu used, %.1f bytes/parcel\n", reserved, used, (double)reserved / parcels);
+}
+
+//FUNCTION: addMallocFootprint()
+//PARAMETERS: BSTNode* root, size_t& bytes, int& parcels - the tree to measure and the running totals
+//DESCRIPTION: adds what the parcel, its destination and its node would cost as three separate mallocs, for every node in the tree
+//RETURNS: void - totals are passed by reference
+void addMallocFootprint(BSTNode* root, size_t& bytes, int& parcels) {
+    WeightCursor cursor;
+    openTreeCursor(&cursor, root, CURSOR_PRE_ORDER);
+    for (BSTNode* node = nextTreeCursor(&cursor); node != NULL; node = nextTreeCursor(&cursor)) {
+        bytes += mallocChunkSize(sizeof(char*) + sizeof(int) + sizeof(float)) + mallocChunkSize(sizeof(BSTNode)) +
+            mallocChunkSize(strlen(countryName(node->parcel->countryId)) + 1);
+        parcels++;
+    }
+    closeTreeCursor(&cursor);
+}
+
+//FUNCTION: mallocChunkSize()
+//PARAMETERS: size_t request - bytes asked of malloc
+//DESCRIPTION: the size of the chunk a typical 64-bit malloc hands out for the request: an 8 byte header, rounded up to 16 bytes, 32 at least
+//RETURNS: size_t - bytes of heap used
+size_t mallocChunkSize(size_t request) {
+    size_t chunk = (request + 8 + 15) & ~(size_t)15;
+    return chunk < 32 ? 32 : chunk;
+}
+
+/* Load data from file into hash table */
+//FUNCTION: loadData()
+//PARAMETERS: const char* filename, HashTable* hashTable - the file name from main to be opened, and the hash table to insert the countries into
+// int maxRows - the most rows to load (NO_ROW_CAP for all of them), LoadStats* stats - filled in with the row count and timing of the load
+//DESCRIPTION: using FILE i/o to read from the courier.txt file. after reading the name of the country as well as it's details, the info is sent
+// to the createParcel function to create a new parcel node. the name of the country is interned in the country dictionary, which gives the
+// country's ID, which value is then used to index the hashTable. the parcel is then inserted at this index of the hashTable with the insertBST() function. the total flights 
+// then incremented to ensure that the number of flights does not exceed maxRows. ensures proper error checking for file io. this is the original
+// loader, kept so it can be compared against loadDataMapped() with --loader scanf
+//RETURNS: int - success or error whether there was enough flight data read
+int loadData(const char* filename, HashTable* hashTable, int maxRows, LoadStats* stats) {
+    double start = nowSeconds();
+    FILE* pFile = fopen(filename, "r");
+    if (pFile == NULL) {
+        perror("Unable to open file\n\n");
+        exit(1);
+    }
+    int totalFlights = 0; //to ensure that the list of names is at least 2000 but does not exceed maxRows
+    int skipped = 0;
+    char destination[21];
+    char price[32] = { 0 };
+    int weight = 0;
+    int valuation = 0; //in cents
+    while ((maxRows == NO_ROW_CAP || totalFlights < maxRows) && (fscanf(pFile, "%20[^,],%d,%31[^\n]\n", destination, &weight, price) != EOF)) { 
+        size_t priceLength = strlen(price);
+        if (priceLength > 0 && price[priceLength - 1] == '\r') {
+            priceLength--;
+        }
+        if (!parseCents(price, price + priceLength, &valuation) || !isValidParcel(weight, valuation)) { //means there was an issue with weight or valuation
+            skipped++;
+            continue;
+        }
+        int countryId = internCountry(&countryDictionary, destination, (int)strlen(destination));
+        HashNode* node = countryNode(hashTable, countryId);
+        Parcel* parcel = createParcel(&node->arena, countryId, weight, valuation);
+        addParcel(node, parcel);
+        totalFlights++;
+    }
+    stats->rowsLoaded = totalFlights;
+    stats->rowsSkipped = skipped;
+    stats->bytesRead = (size_t)ftell(pFile);
+    if (ferror(pFile)) {
+        clearerr(pFile);
+    }
+    if (fclose(pFile) == EOF) {
+        fprintf(statusOutput, "Error closing file\n\n");
+    }
+    stats->seconds = nowSeconds() - start;
+    if (totalFlights < minimumRows)
+    {
+        return ERROR;
+    }
+    return SUCCESS;
+}
+
+/* Load data from a memory-mapped file into hash table */
+//FUNCTION: loadDataMapped()
+//PARAMETERS: const char* filename, HashTable* hashTable, int maxRows, LoadStats* stats - same as loadData()
+//DESCRIPTION: maps the whole file into memory with mapFile() and walks it with parseRecord(), which reads the destination, weight and valuation
+// straight out of the mapped bytes without scanf or strtof. the destination is interned straight from the mapped bytes too. unlike the fscanf loader, country names longer than 20 characters are kept whole instead of being split into two bad rows.
+//RETURNS: int - success or error whether there was enough flight data read
+int loadDataMapped(const char* filename, HashTable* hashTable, int maxRows, LoadStats* stats) {
+    double start = nowSeconds();
+    MappedFile file;
+    if (mapFile(filename, &file) == ERROR) {
+        perror("Unable to open file\n\n");
+        exit(1);
+    }
+    int totalFlights = 0;
+    int skipped = 0;
+    const char* cursor = file.data;
+    const char* end = file.data + file.size;
+    while (cursor < end && (maxRows == NO_ROW_CAP || totalFlights < maxRows)) {
+        ParsedRecord record;
+        int valid = 0;
+        cursor = parseRecord(cursor, end, &record, &valid);
+        if (!valid) {
+            skipped++;
+            continue;
+        }
+        if (!isValidParcel(record.weight, record.valuation)) { //weight or valuation out of range
+            skipped++;
+            continue;
+        }
+        int countryId = internCountry(&countryDictionary, record.destination, record.destinationLength);
+        HashNode* node = countryNode(hashTable, countryId);
+        Parcel* parcel = createParcel(&node->arena, countryId, record.weight, record.valuation);
+        addParcel(node, parcel);
+        totalFlights++;
+    }
+    stats->rowsLoaded = totalFlights;
+    stats->rowsSkipped = skipped;
+    stats->bytesRead = (size_t)(cursor - file.data);
+    unmapFile(&file);
+    stats->seconds = nowSeconds() - start;
+    if (totalFlights < minimumRows) {
+        return ERROR;
+    }
+    return SUCCESS;
+}
+
+/* Load data from a memory-mapped file with several threads */
+//FUNCTION: loadDataParallel()
+//PARAMETERS: const char* filename, HashTable* hashTable, int maxRows, LoadStats* stats - same as loadData(), int threads - how many loader threads to run
+//DESCRIPTION: splits the mapped file into one chunk per thread, moving each split point forward to the start of the next line. every thread
+// parses its chunk with parseChunk() at the same time, interning destinations into the chunk's own dictionary and sorting the valid rows into
+// per-country runs in file order. the row cap is then applied across the chunks in file order, and each chunk's countries are added to the
+// global dictionary in chunk order, which hands out the same IDs the serial loader would. the runs are merged into the hash table by
+// mergeChunks(), again one thread per share of the countries since every country is independent and has its own arena. the runs are replayed
+// chunk by chunk, so each country sees its parcels in the same order the serial loader would and ends up with the exact same tree.
+//RETURNS: int - success or error whether there was enough flight data read
+int loadDataParallel(const char* filename, HashTable* hashTable, int maxRows, int threads, LoadStats* stats) {
+    double start = nowSeconds();
+    MappedFile file;
+    if (mapFile(filename, &file) == ERROR) {
+        perror("Unable to open file\n\n");
+        exit(1);
+    }
+    LoadChunk* chunks = (LoadChunk*)countedCalloc((size_t)threads, sizeof(LoadChunk));
+    std::thread* workers = new std::thread[threads];
+    if (chunks == NULL) {
+        perror("Unable to allocate memory for loader chunks");
+        exit(1);
+    }
+    const char* end = file.data + file.size;
+    const char* chunkStart = file.data;
+    for (int i = 0; i < threads; ++i) {
+        const char* chunkEnd = (i == threads - 1) ? end : file.data + file.size / threads * (i + 1);
+        if (chunkEnd < chunkStart) {
+            chunkEnd = chunkStart;
+        }
+        if (chunkEnd < end) {
+            const char* newline = (const char*)memchr(chunkEnd, '\n', (size_t)(end - chunkEnd));
+            chunkEnd = (newline == NULL) ? end : newline + 1;
+        }
+        chunks[i].start = chunkStart;
+        chunks[i].end = chunkEnd;
+        chunks[i].maxRows = maxRows;
+        initializeDictionary(&chunks[i].countries);
+        chunkStart = chunkEnd;
+    }
+    for (int i = 0; i < threads; ++i) {
+        workers[i] = std::thread(parseChunk, &chunks[i]);
+    }
+    for (int i = 0; i < threads; ++i) {
+        workers[i].join();
+    }
+
+    int totalFlights = 0;
+    int skipped = 0;
+    size_t bytesParsed = 0;
+    for (int i = 0; i < threads; ++i) {
+        int remaining = (maxRows == NO_ROW_CAP) ? chunks[i].rowsLoaded : maxRows - totalFlights;
+        chunks[i].rowsKept = (chunks[i].rowsLoaded < remaining) ? chunks[i].rowsLoaded : remaining;
+        totalFlights += chunks[i].rowsKept;
+        if (chunks[i].rowsKept > 0 || i == 0) {
+            skipped += chunks[i].rowsSkipped;
+            bytesParsed += chunks[i].bytesParsed;
+        }
+        for (int id = 0; id < chunks[i].countries.count; ++id) {
+            if (chunks[i].firstRows[id] < chunks[i].rowsKept) {
+                internCountry(&countryDictionary, chunks[i].countries.names[id], chunks[i].countries.lengths[id]);
+            }
+        }
+    }
+    if (countryDictionary.count > 0) {
+        countryNode(hashTable, countryDictionary.count - 1); //grow the table before the merge threads use it
+    }
+    for (int i = 0; i < threads; ++i) {
+        chunks[i].localIds = (int*)countedMalloc((countryDictionary.count + 1) * sizeof(int));
+        if (chunks[i].localIds == NULL) {
+            perror("Unable to allocate memory for loader chunks");
+            exit(1);
+        }
+        for (int id = 0; id < countryDictionary.count; ++id) {
+            chunks[i].localIds[id] = lookupCountry(&chunks[i].countries, countryDictionary.names[id], countryDictionary.lengths[id]);
+        }
+    }
+
+    for (int i = 0; i < threads; ++i) {
+        workers[i] = std::thread(mergeChunks, chunks, threads, hashTable, i, threads);
+    }
+    for (int i = 0; i < threads; ++i) {
+        workers[i].join();
+    }
+    for (int i = 0; i < threads; ++i) {
+        for (int id = 0; id < chunks[i].countries.count; ++id) {
+            free(chunks[i].runs[id].records);
+            free(chunks[i].runs[id].rows);
+        }
+        free(chunks[i].runs);
+        free(chunks[i].firstRows);
+        free(chunks[i].localIds);
+        releaseDictionary(&chunks[i].countries);
+    }
+    delete[] workers;
+    free(chunks);
+    unmapFile(&file);
+
+    stats->rowsLoaded = totalFlights;
+    stats->rowsSkipped = skipped;
+    stats->bytesRead = bytesParsed;
+    stats->seconds = nowSeconds() - start;
+    if (totalFlights < minimumRows) {
+        return ERROR;
+    }
+    return SUCCESS;
+}
+
+//FUNCTION: parseChunk()
+//PARAMETERS: LoadChunk* chunk - the slice of the file to parse, its results are written back into the struct
+//DESCRIPTION: runs on a loader thread. parses every line in the chunk with parseRecord(), checks the weight and valuation, interns the
+// destination in the chunk's dictionary and appends valid rows to the run for their country along with their row number in the chunk. a
+// chunk never needs more than maxRows rows, so it stops there.
+//RETURNS: void
+void parseChunk(LoadChunk* chunk) {
+    const char* cursor = chunk->start;
+    while (cursor < chunk->end && (chunk->maxRows == NO_ROW_CAP || chunk->rowsLoaded < chunk->maxRows)) {
+        ParsedRecord record;
+        int valid = 0;
+        cursor = parseRecord(cursor, chunk->end, &record, &valid);
+        if (!valid || !isValidParcel(record.weight, record.valuation)) {
+            chunk->rowsSkipped++;
+            continue;
+        }
+        int known = chunk->countries.count;
+        record.countryId = internCountry(&chunk->countries, record.destination, record.destinationLength);
+        if (chunk->countries.count > known) {
+            if (chunk->runCapacity < chunk->countries.capacity) {
+                chunk->runs = (ParcelRun*)countedRealloc(chunk->runs, chunk->countries.capacity * sizeof(ParcelRun));
+                chunk->firstRows = (int*)countedRealloc(chunk->firstRows, chunk->countries.capacity * sizeof(int));
+                if (chunk->runs == NULL || chunk->firstRows == NULL) {
+                    perror("Unable to allocate memory for loader chunks");
+                    exit(1);
+                }
+                memset(chunk->runs + chunk->runCapacity, 0, (chunk->countries.capacity - chunk->runCapacity) * sizeof(ParcelRun));
+                chunk->runCapacity = chunk->countries.capacity;
+            }
+            chunk->firstRows[record.countryId] = chunk->rowsLoaded;
+        }
+        appendToRun(&chunk->runs[record.countryId], &record, chunk->rowsLoaded);
+        chunk->rowsLoaded++;
+    }
+    chunk->bytesParsed = (size_t)(cursor - chunk->start);
+}
+
+//FUNCTION: mergeChunks()
+//PARAMETERS: LoadChunk* chunks, int chunkCount - the parsed chunks in file order, HashTable* hashTable - the table to build,
+// int firstCountry, int step - this thread merges country IDs firstCountry, firstCountry + step, ...
+//DESCRIPTION: runs on a loader thread. for each of its countries, creates and inserts the parcels from every chunk's run in chunk order so the
+// tree is built in the same order as the serial loader. rows past a chunk's rowsKept fell outside the row cap and are left out.
+//RETURNS: void
+void mergeChunks(LoadChunk* chunks, int chunkCount, HashTable* hashTable, int firstCountry, int step) {
+    for (int countryId = firstCountry; countryId < countryDictionary.count; countryId += step) {
+        HashNode* node = &hashTable->nodes[countryId];
+        for (int i = 0; i < chunkCount; ++i) {
+            if (chunks[i].localIds[countryId] == NO_COUNTRY) {
+                continue;
+            }
+            ParcelRun* run = &chunks[i].runs[chunks[i].localIds[countryId]];
+            for (int j = 0; j < run->count; ++j) {
+                if (run->rows[j] < chunks[i].rowsKept) {
+                    Parcel* parcel = createParcel(&node->arena, countryId, run->records[j].weight, run->records[j].valuation);
+                    addParcel(node, parcel);
+                }
+            }
+        }
+    }
+}
+
+//FUNCTION: appendToRun()
+//PARAMETERS: ParcelRun* run, const ParsedRecord* record, int row - the run to grow, the row to add and its row number within the chunk
+//DESCRIPTION: adds the row to the end of the run, doubling the arrays when they are full
+//RETURNS: void
+void appendToRun(ParcelRun* run, const ParsedRecord* record, int row) {
+    if (run->count == run->capacity) {
+        run->capacity = (run->capacity == 0) ? 64 : run->capacity * 2;
+        run->records = (ParsedRecord*)countedRealloc(run->records, run->capacity * sizeof(ParsedRecord));
+        run->rows = (int*)countedRealloc(run->rows, run->capacity * sizeof(int));
+        if (run->records == NULL || run->rows == NULL) {
+            perror("Unable to allocate memory for parcel run");
+            exit(1);
+        }
+    }
+    run->records[run->count] = *record;
+    run->rows[run->count] = row;
+    run->count++;
+}
+
+/* Determinism check for the parallel loader */
+//FUNCTION: verifyParallelLoad()
+//PARAMETERS: const Options* options, HashTable* hashTable - the options the table was loaded with and the loaded table
+//DESCRIPTION: loads the same file again with the serial mmap loader into a second table and compares every country with compareBST(). used by
+// --verify-load to prove the parallel loader (or any other) builds exactly what the serial loader does. it also checks each country's subtree
+// totals, and builds its valuation index and checks that against the weight tree.
+//RETURNS: int - SUCCESS if every country matched, ERROR otherwise
+int verifyParallelLoad(const Options* options, HashTable* hashTable) {
+    HashTable* reference = initializeHashTable();
+    LoadStats stats;
+    loadDataMapped(options->filename, reference, options->maxRows, &stats);
+    printLoadStats("serial mmap", &stats);
+    int mismatches = 0;
+    for (int id = 0; id < countryDictionary.count; ++id) {
+        buildPriceIndex(countryNode(hashTable, id));
+        if (!compareBST(countryNode(hashTable, id)->root, countryNode(reference, id)->root)) {
+            printf("%s differs from the serial loader\n", countryName(id));
+            mismatches++;
+        }
+        else if (!checkSubtreeTotals(countryNode(hashTable, id)->root)) {
+            printf("%s has subtree totals that don't match its parcels\n", countryName(id));
+            mismatches++;
+        }
+        else if (!checkPriceIndex(countryNode(hashTable, id))) {
+            printf("%s has a valuation index that doesn't match its parcels\n", countryName(id));
+            mismatches++;
+        }
+    }
+    cleanup(reference);
+    free(reference);
+    if (mismatches > 0) {
+        printf("Verification failed: %d of %d countries differ\n", mismatches, countryDictionary.count);
+        return ERROR;
+    }
+    printf("Verification passed: all %d countries match the serial loader\n", countryDictionary.count);
+    return SUCCESS;
+}
+
+//FUNCTION: compareBST()
+//PARAMETERS: BSTNode* first, BSTNode* second - the two trees to compare
+//DESCRIPTION: walks both trees together with a pre-order cursor each, checking each pair of nodes has children on the same sides, which
+// keeps the two walks in step and means the trees have the same shape, and holds the same destination ID, weight and valuation
+//RETURNS: int - 1 if the trees are identical, 0 if not
+int compareBST(BSTNode* first, BSTNode* second) {
+    WeightCursor firstCursor;
+    WeightCursor secondCursor;
+    openTreeCursor(&firstCursor, first, CURSOR_PRE_ORDER);
+    openTreeCursor(&secondCursor, second, CURSOR_PRE_ORDER);
+    int same = 1;
+    while (same) {
+        BSTNode* a = nextTreeCursor(&firstCursor);
+        BSTNode* b = nextTreeCursor(&secondCursor);
+        if (a == NULL || b == NULL) {
+            same = a == b;
+            break;
+        }
+        same = a->parcel->weight == b->parcel->weight && a->parcel->valuation == b->parcel->valuation &&
+            a->parcel->countryId == b->parcel->countryId && (a->left == NULL) == (b->left == NULL) && (a->right == NULL) == (b->right == NULL);
+    }
+    closeTreeCursor(&firstCursor);
+    closeTreeCursor(&secondCursor);
+    return same;
+}
+
+//FUNCTION: mapFile()
+//PARAMETERS: const char* filename, MappedFile* file - the file to open and the struct that receives its contents
+//DESCRIPTION: maps the file read-only into memory so the parser can scan it in place. on windows (or if mmap fails, e.g. for a pipe) the 
+// file is read into one malloc'd buffer instead, which the parser can't tell apart from a mapping.
+//RETURNS: int - SUCCESS or ERROR if the file could not be opened or read
+int mapFile(const char* filename, MappedFile* file) {
+    file->data = NULL;
+    file->size = 0;
+    file->isMapped = 0;
+#ifndef _WIN32
+    int fd = open(filename, O_RDONLY);
+    if (fd < 0) {
+        return ERROR;
+    }
+    struct stat info;
+    if (fstat(fd, &info) == 0 && S_ISREG(info.st_mode)) {
+        if (info.st_size == 0) {
+            close(fd);
+            return SUCCESS;
+        }
+        void* mapped = mmap(NULL, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (mapped != MAP_FAILED) {
+            madvise(mapped, (size_t)info.st_size, MADV_SEQUENTIAL);
+            file->data = (const char*)mapped;
+            file->size = (size_t)info.st_size;
+            file->isMapped = 1;
+            close(fd);
+            return SUCCESS;
+        }
+    }
+    close(fd);
+#endif
+    FILE* pFile = fopen(filename, "rb");
+    if (pFile == NULL) {
+        return ERROR;
+    }
+    size_t capacity = 1 << 20;
+    char* buffer = (char*)countedMalloc(capacity);
+    if (buffer == NULL) {
+        perror("Unable to allocate memory for input file");
+        exit(1);
+    }
+    size_t size = 0;
+    size_t count = 0;
+    while ((count = fread(buffer + size, 1, capacity - size, pFile)) > 0) {
+        size += count;
+        if (size == capacity) {
+            capacity *= 2;
+            buffer = (char*)countedRealloc(buffer, capacity);
+            if (buffer == NULL) {
+                perror("Unable to allocate memory for input file");
+                exit(1);
+            }
+        }
+    }
+    fclose(pFile);
+    file->data = buffer;
+    file->size = size;
+    return SUCCESS;
+}
+
+//FUNCTION: unmapFile()
+//PARAMETERS: MappedFile* file - a file opened with mapFile()
+//DESCRIPTION: unmaps or frees the file contents depending on how mapFile() got them
+//RETURNS: void
+void unmapFile(MappedFile* file) {
+    if (file->data == NULL) {
+        return;
+    }
+#ifndef _WIN32
+    if (file->isMapped) {
+        munmap((void*)file->data, file->size);
+        file->data = NULL;
+        return;
+    }
+#endif
+    free((void*)file->data);
+    file->data = NULL;
+}
+
+//FUNCTION: parseRecord()
+//PARAMETERS: const char* cursor, const char* end - start of the line to parse and end of the file, ParsedRecord* record - receives the fields,
+// int* valid - set to 1 if the line was a well formed "destination,weight,valuation" row
+//DESCRIPTION: the hand written scanner used by loadDataMapped(). memchr finds the end of the line and the comma after the destination, then the
+// weight digits are accumulated as an integer and the valuation is read straight into cents by parseCents(), so there is no locale handling
+// or strtof per field. a trailing '\r' is ignored so windows line endings work.
+//RETURNS: const char* - the start of the next line
+const char* parseRecord(const char* cursor, const char* end, ParsedRecord* record, int* valid) {
+    const char* lineEnd = (const char*)memchr(cursor, '\n', (size_t)(end - cursor));
+    const char* next = (lineEnd == NULL) ? end : lineEnd + 1;
+    if (lineEnd == NULL) {
+        lineEnd = end;
+    }
+    if (lineEnd > cursor && lineEnd[-1] == '\r') {
+        lineEnd--;
+    }
+    *valid = 0;
+    const char* comma = (const char*)memchr(cursor, ',', (size_t)(lineEnd - cursor));
+    if (comma == NULL || comma == cursor || comma - cursor > MAX_DESTINATION) {
+        return next;
+    }
+    record->destination = cursor;
+    record->destinationLength = (int)(comma - cursor);
+
+    const char* p = comma + 1;
+    const char* digitsStart = p;
+    unsigned int digit = 0;
+    int weight = 0;
+    while (p < lineEnd && (digit = (unsigned int)(*p - '0')) < 10 && p - digitsStart < 9) {
+        weight = weight * 10 + (int)digit;
+        p++;
+    }
+    if (p == digitsStart || p >= lineEnd || *p != ',') {
+        return next;
+    }
+    if (!parseCents(p + 1, lineEnd, &record->valuation)) {
+        return next;
+    }
+    record->weight = weight;
+    *valid = 1;
+    return next;
+}
+
+//FUNCTION: printLoadStats()
+//PARAMETERS: const char* loader, const LoadStats* stats - name of the loader that ran and its numbers
+//DESCRIPTION: prints how many rows were loaded and the throughput in MB/s and rows/s to the status stream
+//RETURNS: void
+void printLoadStats(const char* loader, const LoadStats* stats) {
+    double seconds = stats->seconds > 0.0 ? stats->seconds : 1e-9;
+    fprintf(statusOutput, "Loaded %d parcels (%d skipped) with the %s loader in %.3f ms: %.1f MB/s, %.0f rows/s\n",
+        stats->rowsLoaded, stats->rowsSkipped, loader, stats->seconds * 1000.0,
+        stats->bytesRead / (1024.0 * 1024.0) / seconds, stats->rowsLoaded / seconds);
+}
+
+//FUNCTION: nowSeconds()
+//PARAMETERS: void
+//DESCRIPTION: reads the monotonic clock, used to time the loaders
+//RETURNS: double - seconds since an arbitrary starting point
+double nowSeconds(void) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+/* Prints parcels info */
+//FUNCTION: printParcels()
+//PARAMETERS: BSTNode* root - root of a specific index of the hashtable
+//DESCRIPTION: prints the bst with in-order traversal. the argument sent to the parameter is actually the root of a specific index of the hash table
+// representing a specific country - so this function prints all the parcels of a country. this function is utilized by searchByCountry()
+//RETURNS: void
+void printParcels(BSTNode* root) {
+    WeightCursor cursor;
+    openTreeCursor(&cursor, root, CURSOR_IN_ORDER);
+    for (BSTNode* node = nextTreeCursor(&cursor); node != NULL; node = nextTreeCursor(&cursor)) {
+        writeParcel(node->parcel->countryId, node->parcel->weight, node->parcel->valuation);
+    }
+    closeTreeCursor(&cursor);
+}
+
+/* Search parcels by country */
+//FUNCTION: searchByCountry()
+//PARAMETERS: const char* country, HashTable* hashTable - the country to search and the entire hashtable holding all countries
+//DESCRIPTION: this function looks the country name up in the country index to find the hash node that contains the root of the country's bst.
+// then prints the bst of that root by calling the printParcels function, and flushes the rows it wrote
+//RETURNS: void
+void searchByCountry(const char* country, HashTable* hashTable) {
+    PROBE(PROBE_BY_COUNTRY);
+    HashNode* node = findCountryNode(country, hashTable);
+    BSTNode* root = (node == NULL) ? NULL : node->root;
+    if (root == NULL) {
+        printf("No country found for entered country: %s\n", country);
+        return;
+    }
+    printParcels(root);
+    flushAllOutput();
+}
+
+/* Tree cursors */
+//FUNCTION: openTreeCursor()
+//PARAMETERS: TreeCursor<Node>* cursor, Node* root, int order - the cursor to set up, a weight tree or valuation index, and CURSOR_IN_ORDER,
+// CURSOR_REVERSE or CURSOR_PRE_ORDER
+//DESCRIPTION: starts a walk over the whole tree. an in-order or reverse walk pushes the path down to the lowest or highest node, a pre-order
+// walk just the root
+//RETURNS: void
+template <typename Node> void openTreeCursor(TreeCursor<Node>* cursor, Node* root, int order) {
+    cursor->stack = cursor->local;
+    cursor->depth = 0;
+    cursor->capacity = MAX_TREE_HEIGHT;
+    cursor->order = order;
+    cursor->maxKey = HUGE_VAL;
+    if (order == CURSOR_PRE_ORDER) {
+        if (root != NULL) {
+            pushTreeCursor(cursor, root);
+        }
+        return;
+    }
+    for (Node* node = root; node != NULL; node = (order == CURSOR_REVERSE) ? node->right : node->left) {
+        pushTreeCursor(cursor, node);
+    }
+}
+
+//FUNCTION: seekTreeCursor()
+//PARAMETERS: TreeCursor<Node>* cursor, Node* root, double minKey, double maxKey - the cursor to set up, the tree and the inclusive range of
+// weights or valuations
+//DESCRIPTION: starts an in-order walk at the lowest node of at least minKey, the same way a binary search would. every node that is high
+// enough is pushed before going left, the lower ones are skipped along with their whole left subtree, so only one path is visited
+//RETURNS: void
+template <typename Node> void seekTreeCursor(TreeCursor<Node>* cursor, Node* root, double minKey, double maxKey) {
+    cursor->stack = cursor->local;
+    cursor->depth = 0;
+    cursor->capacity = MAX_TREE_HEIGHT;
+    cursor->order = CURSOR_IN_ORDER;
+    cursor->maxKey = maxKey;
+    while (root != NULL) {
+        if (cursorKey(root) >= minKey) {
+            pushTreeCursor(cursor, root);
+            root = root->left;
+        }
+        else {
+            COUNT_VISITS(1);
+            root = root->right;
+        }
+    }
+}
+
+//FUNCTION: nextTreeCursor()
+//PARAMETERS: TreeCursor<Node>* cursor - a cursor opened with openTreeCursor() or seekTreeCursor()
+//DESCRIPTION: pops the next node. in order it then pushes the left spine of the node's right subtree and reverse the right spine of its
+// left subtree, pre-order pushes its two children. an in-order cursor stops at the first node above maxKey, so a range costs the path down
+// plus the nodes it returns, not the size of the tree
+//RETURNS: Node* - the next node, NULL once the walk is done
+template <typename Node> inline Node* nextTreeCursor(TreeCursor<Node>* cursor) {
+    if (cursor->depth == 0) {
+        return NULL;
+    }
+    Node* node = cursor->stack[--cursor->depth];
+    if (cursor->order == CURSOR_IN_ORDER) {
+        if (cursorKey(node) > cursor->maxKey) {
+            cursor->depth = 0;
+            return NULL;
+        }
+        for (Node* child = node->right; child != NULL; child = child->left) {
+            pushTreeCursor(cursor, child);
+        }
+    }
+    else if (cursor->order == CURSOR_REVERSE) {
+        for (Node* child = node->left; child != NULL; child = child->right) {
+            pushTreeCursor(cursor, child);
+        }
+    }
+    else {
+        if (node->right != NULL) {
+            pushTreeCursor(cursor, node->right);
+        }
+        if (node->left != NULL) {
+            pushTreeCursor(cursor, node->left);
+        }
+    }
+    return node;
+}
+
+//FUNCTION: pushTreeCursor()
+//PARAMETERS: TreeCursor<Node>* cursor, Node* node - the cursor and a node still to be visited
+//DESCRIPTION: pushes the node, growing the stack first if it is full
+//RETURNS: void
+template <typename Node> inline void pushTreeCursor(TreeCursor<Node>* cursor, Node* node) {
+    COUNT_VISITS(1);
+    if (cursor->depth == cursor->capacity) {
+        growTreeCursor(cursor);
+    }
+    cursor->stack[cursor->depth++] = node;
+}
+
+//FUNCTION: growTreeCursor()
+//PARAMETERS: TreeCursor<Node>* cursor - a cursor whose stack is full
+//DESCRIPTION: doubles the stack. the first time, the stack moves from local to the heap, which only a tree that isn't an AVL tree can cause,
+// so this is kept out of pushTreeCursor()
+//RETURNS: void
+template <typename Node> void growTreeCursor(TreeCursor<Node>* cursor) {
+    Node** grown = (Node**)countedMalloc(2 * (size_t)cursor->capacity * sizeof(Node*));
+    if (grown == NULL) {
+        perror("Unable to allocate memory for tree cursor");
+        exit(1);
+    }
+    memcpy(grown, cursor->stack, cursor->depth * sizeof(Node*));
+    if (cursor->stack != cursor->local) {
+        free(cursor->stack);
+    }
+    cursor->stack = grown;
+    cursor->capacity *= 2;
+}
+
+//FUNCTION: closeTreeCursor()
+//PARAMETERS: TreeCursor<Node>* cursor - a cursor that is done with, whether or not it got to the end
+//DESCRIPTION: frees the stack if it had to move to the heap
+//RETURNS: void
+template <typename Node> void closeTreeCursor(TreeCursor<Node>* cursor) {
+    if (cursor->stack != cursor->local) {
+        free(cursor->stack);
+    }
+    cursor->stack = cursor->local;
+    cursor->depth = 0;
+}
+
+//FUNCTION: cursorKey()
+//PARAMETERS: const BSTNode* node or const PriceNode* node - a node of a weight tree or of a valuation index
+//DESCRIPTION: the key the tree is sorted by, for seekTreeCursor() and nextTreeCursor()
+//RETURNS: double - the node's weight or valuation
+double cursorKey(const BSTNode* node) {
+    return node->weight;
+}
+
+double cursorKey(const PriceNode* node) {
+    return node->valuation;
+}
+
+/* Weight range queries */
+//FUNCTION: openWeightCursor()
+//PARAMETERS: WeightCursor* cursor, BSTNode* root, int minWeight, int maxWeight - the cursor to set up, the country's tree and the inclusive range
+//DESCRIPTION: seekTreeCursor() for a weight range, the cursor returns the parcels from the lightest of at least minWeight up to the heaviest
+// of at most maxWeight
+//RETURNS: void
+void openWeightCursor(WeightCursor* cursor, BSTNode* root, int minWeight, int maxWeight) {
+    seekTreeCursor(cursor, root, minWeight, maxWeight);
+}
+
+//FUNCTION: nextWeightCursor()
+//PARAMETERS: WeightCursor* cursor - a cursor opened with openWeightCursor()
+//DESCRIPTION: nextTreeCursor() for a weight range
+//RETURNS: BSTNode* - the next node in the range, NULL once the range is used up
+BSTNode* nextWeightCursor(WeightCursor* cursor) {
+    return nextTreeCursor(cursor);
+}
+
+//FUNCTION: countWeightRange()
+//PARAMETERS: BSTNode* root, int minWeight, int maxWeight - a country's tree and the inclusive range
+//DESCRIPTION: counts the parcels in the range from the subtree counts, the same two paths as sumWeightRange() but only the weights and counts
+// kept in the nodes are read and the parcels are never loaded
+//RETURNS: int - the number of parcels in the range
+int countWeightRange(BSTNode* root, int minWeight, int maxWeight) {
+    while (root != NULL && (root->weight < minWeight || root->weight > maxWeight)) {
+        COUNT_VISITS(1);
+        root = (root->weight < minWeight) ? root->right : root->left;
+    }
+    if (root == NULL) {
+        return 0;
+    }
+    int count = 1;
+    for (BSTNode* node = root->left; node != NULL; ) {
+        COUNT_VISITS(1);
+        if (node->weight >= minWeight) {
+            count += 1 + ((node->right != NULL) ? node->right->subtree.count : 0);
+            node = node->left;
+        }
+        else {
+            node = node->right;
+        }
+    }
+    for (BSTNode* node = root->right; node != NULL; ) {
+        COUNT_VISITS(1);
+        if (node->weight <= maxWeight) {
+            count += 1 + ((node->left != NULL) ? node->left->subtree.count : 0);
+            node = node->right;
+        }
+        else {
+            node = node->left;
+        }
+    }
+    return count;
+}
+
+//FUNCTION: sumWeightRange()
+//PARAMETERS: BSTNode* root, int minWeight, int maxWeight, ParcelTotals* totals - a country's tree, the inclusive range and the totals the
+// parcels in the range are added to
+//DESCRIPTION: walks down to the first node inside the range, where the paths to the two ends of the range split. from there one walk goes down
+// the left side towards minWeight and adds every node in the range along with its right subtree's totals, and the other does the mirror
+// towards maxWeight. whole subtrees are taken from their stored totals, so this costs O(log n) however many parcels are in the range
+//RETURNS: void
+void sumWeightRange(BSTNode* root, int minWeight, int maxWeight, ParcelTotals* totals) {
+    while (root != NULL && (root->weight < minWeight || root->weight > maxWeight)) {
+        COUNT_VISITS(1);
+        root = (root->weight < minWeight) ? root->right : root->left;
+    }
+    if (root == NULL) {
+        return;
+    }
+    addParcelToTotals(totals, root->parcel);
+    for (BSTNode* node = root->left; node != NULL; ) {
+        COUNT_VISITS(1);
+        if (node->weight >= minWeight) {
+            addParcelToTotals(totals, node->parcel);
+            if (node->right != NULL) {
+                addTotals(totals, &node->right->subtree);
+            }
+            node = node->left;
+        }
+        else {
+            node = node->right;
+        }
+    }
+    for (BSTNode* node = root->right; node != NULL; ) {
+        COUNT_VISITS(1);
+        if (node->weight <= maxWeight) {
+            addParcelToTotals(totals, node->parcel);
+            if (node->left != NULL) {
+                addTotals(totals, &node->left->subtree);
+            }
+            node = node->right;
+        }
+        else {
+            node = node->left;
+        }
+    }
+}
+
+//FUNCTION: printWeightRange()
+//PARAMETERS: BSTNode* root, int minWeight, int maxWeight - a country's tree and the inclusive range
+//DESCRIPTION: prints the parcels in the range in weight order, in the same format as printParcels()
+//RETURNS: void
+void printWeightRange(BSTNode* root, int minWeight, int maxWeight) {
+    WeightCursor cursor;
+    openWeightCursor(&cursor, root, minWeight, maxWeight);
+    for (BSTNode* node = nextWeightCursor(&cursor); node != NULL; node = nextWeightCursor(&cursor)) {
+        writeParcel(node->parcel->countryId, node->parcel->weight, node->parcel->valuation);
+    }
+    closeTreeCursor(&cursor);
+    flushAllOutput();
+}
+
+/* Main function to search parcels by weight */
+//FUNCTION: searchByWeight()
+//PARAMETERS: const char* country, int weight, int higher, HashTable* hashTable
+//DESCRIPTION: finds the country in the country index to get the hash node, then prints either the parcels heavier than weight or the ones
+// lighter than it. higher is the menu option of 1 or 2, taken from user input in main. both are one sided weight ranges, so this is a
+// printWeightRange() call with the other end left open.
+//RETURNS: void
+void searchByWeight(const char* country, int weight, int higher, HashTable* hashTable) {
+    PROBE(PROBE_BY_WEIGHT);
+    HashNode* node = findCountryNode(country, hashTable);
+    if (node == NULL || node->root == NULL) {
+        printf("No parcels found for country %s\n", country);
+        return;
+    }
+    if (higher && weight < INT_MAX) {
+        printWeightRange(node->root, weight + 1, INT_MAX);
+    }
+    else if (!higher && weight > INT_MIN) {
+        printWeightRange(node->root, INT_MIN, weight - 1);
+    }
+}
+
+//FUNCTION: searchByWeightRange()
+//PARAMETERS: const char* country, int minWeight, int maxWeight, int countOnly, HashTable* hashTable - the country, the inclusive range of
+// weights, 1 to only print how many parcels match, and the hash table
+//DESCRIPTION: prints the country's parcels between the two weights, or just the count of them
+//RETURNS: void
+void searchByWeightRange(const char* country, int minWeight, int maxWeight, int countOnly, HashTable* hashTable) {
+    PROBE(PROBE_WEIGHT_RANGE);
+    HashNode* node = findCountryNode(country, hashTable);
+    if (node == NULL || node->root == NULL) {
+        printf("No parcels found for country %s\n", country);
+        return;
+    }
+    if (countOnly) {
+        printf("Parcels between %d and %d grams: %d\n", minWeight, maxWeight, countWeightRange(node->root, minWeight, maxWeight));
+    }
+    else {
+        printWeightRange(node->root, minWeight, maxWeight);
+    }
+}
+
+/* Weight range benchmark */
+//FUNCTION: countWeightRangeScan()
+//PARAMETERS: BSTNode* root, int minWeight, int maxWeight - a country's tree and the inclusive range
+//DESCRIPTION: counts the range the way searchByWeight() used to, by visiting every node and testing its parcel. only used by the benchmark
+//RETURNS: int - the number of parcels in the range
+int countWeightRangeScan(BSTNode* root, int minWeight, int maxWeight) {
+    WeightCursor cursor;
+    openTreeCursor(&cursor, root, CURSOR_PRE_ORDER);
+    int count = 0;
+    for (BSTNode* node = nextTreeCursor(&cursor); node != NULL; node = nextTreeCursor(&cursor)) {
+        count += (node->parcel->weight >= minWeight && node->parcel->weight <= maxWeight) ? 1 : 0;
+    }
+    closeTreeCursor(&cursor);
+    return count;
+}
+
+//FUNCTION: benchmarkWeightRange()
+//PARAMETERS: HashTable* hashTable - the loaded table
+//DESCRIPTION: runs RANGE_BENCH_QUERIES count queries for random countries and random 1% wide weight ranges, once with the cursor and once with
+// the full walk, and checks both give the same counts
+//RETURNS: void
+void benchmarkWeightRange(HashTable* hashTable) {
+    int countries = countryDictionary.count;
+    if (countries == 0) {
+        return;
+    }
+    int span = (MAX_WEIGHT - MIN_WEIGHT) / 100;
+    double seconds[2];
+    long long matches[2];
+    for (int pass = 0; pass < 2; ++pass) {
+        unsigned long long seed = 88172645463325252ULL;
+        matches[pass] = 0;
+        double start = nowSeconds();
+        for (int query = 0; query < RANGE_BENCH_QUERIES; ++query) {
+            BSTNode* root = countryNode(hashTable, (int)(nextRandom(&seed) % countries))->root;
+            int minWeight = MIN_WEIGHT + (int)(nextRandom(&seed) % (MAX_WEIGHT - MIN_WEIGHT - span));
+            matches[pass] += (pass == 0) ? countWeightRange(root, minWeight, minWeight + span) :
+                countWeightRangeScan(root, minWeight, minWeight + span);
+        }
+        seconds[pass] = nowSeconds() - start;
+    }
+    printf("%d range counts over %d countries, %lld/%lld parcels matched\n", RANGE_BENCH_QUERIES, countries, matches[0], matches[1]);
+    printf("cursor %.3f ms (%.0f queries/s), full walk %.3f ms (%.0f queries/s)\n",
+        seconds[0] * 1000.0, RANGE_BENCH_QUERIES / seconds[0], seconds[1] * 1000.0, RANGE_BENCH_QUERIES / seconds[1]);
+}
+
+/* Calculate total parcel load and valuation for a country */
+//FUNCTION: calculateTotalLoadAndValuation()
+//PARAMETERS: const char* country, HashTable* hashTable - country being calculated and hashtable to get the country info from
+//DESCRIPTION: takes the country being searched for and finds it in the country index to access the hash node which contains the bst for the country.
+// it then traverses through the bst to find the total weight and valuation, and finally prints the total two values.
+//RETURNS: void
+void calculateTotalLoadAndValuation(const char* country, HashTable* hashTable) {
+    PROBE(PROBE_TOTALS);
+    HashNode* node = findCountryNode(country, hashTable);
+    if (node == NULL || node->root == NULL) {
+        printf("No parcels found for country %s\n", country);
+        return;
+    }
+    // the root's subtree totals cover the whole country
+    ParcelTotals* totals = &node->root->subtree;
+
+    printf("Total Load: %lld grams, Total Valuation: $" CENTS "\n", totals->weight, DOLLARS(totals->valuation));
+}
+
+//FUNCTION: calculateWeightRangeTotals()
+//PARAMETERS: const char* country, int minWeight, int maxWeight, HashTable* hashTable - the country, the inclusive range of weights and the
+// hash table
+//DESCRIPTION: adds up the country's parcels between the two weights with sumWeightRange() and prints the totals
+//RETURNS: void
+void calculateWeightRangeTotals(const char* country, int minWeight, int maxWeight, HashTable* hashTable) {
+    PROBE(PROBE_RANGE_TOTALS);
+    HashNode* node = findCountryNode(country, hashTable);
+    if (node == NULL || node->root == NULL) {
+        printf("No parcels found for country %s\n", country);
+        return;
+    }
+    ParcelTotals totals;
+    clearTotals(&totals);
+    sumWeightRange(node->root, minWeight, maxWeight, &totals);
+    printRangeTotals(minWeight, maxWeight, &totals);
+}
+
+//FUNCTION: printRangeTotals()
+//PARAMETERS: int minWeight, int maxWeight, const ParcelTotals* totals - the range and the totals of the parcels in it
+//DESCRIPTION: prints the count, load and valuation of the parcels in a weight range, and their price range when there are any
+//RETURNS: void
+void printRangeTotals(int minWeight, int maxWeight, const ParcelTotals* totals) {
+    printf("Parcels between %d and %d grams: %d, Total Load: %lld grams, Total Valuation: $" CENTS "\n",
+        minWeight, maxWeight, totals->count, totals->weight, DOLLARS(totals->valuation));
+    if (totals->count > 0) {
+        printf("Valuations from $" CENTS " to $" CENTS "\n", DOLLARS(totals->minValuation), DOLLARS(totals->maxValuation));
+    }
+}
+
+/* Display the cheapest and most expensive parcels */
+//FUNCTION: displayCheapestAndMostExpensive()
+//PARAMETERS: const char* country, HashTable* hashTable - country being calculated and hashtable to get the country info from
+//DESCRIPTION: takes the country being searched for and finds it in the country index to access the hash node, finds the two parcels with
+// priceExtremes() and prints the information of the two parcels.
+//RETURNS: void
+void displayCheapestAndMostExpensive(const char* country, HashTable* hashTable) {
+    PROBE(PROBE_PRICE_EXTREMES);
+    HashNode* node = findCountryNode(country, hashTable);
+    if (node == NULL || node->root == NULL) {
+        printf("No parcels found for country %s\n", country);
+        return;
+    }
+    Parcel* cheapest = NULL;
+    Parcel* mostExpensive = NULL;
+    priceExtremes(node, &cheapest, &mostExpensive);
+
+    printf("Cheapest Parcel - Destination: %s, Weight: %d, Valuation: " CENTS "\n",
+        countryName(cheapest->countryId), cheapest->weight, DOLLARS(cheapest->valuation));
+    printf("Most Expensive Parcel - Destination: %s, Weight: %d, Valuation: " CENTS "\n",
+        countryName(mostExpensive->countryId), mostExpensive->weight, DOLLARS(mostExpensive->valuation));
+}
+
+//FUNCTION: priceExtremes()
+//PARAMETERS: HashNode* node, Parcel** cheapest, Parcel** mostExpensive - a country with parcels and where its cheapest and most expensive
+// parcels go
+//DESCRIPTION: if the country's valuation index has been built, the cheapest parcel is its leftmost node and the most expensive its
+// rightmost, so each is one walk down the tree. otherwise findPriceRange() finds them in a single pass over the weight tree, which breaks
+// ties the same way. it only reads the trees
+//RETURNS: void
+void priceExtremes(HashNode* node, Parcel** cheapest, Parcel** mostExpensive) {
+    if (node->priceRoot != NULL) {
+        PriceNode* lowest = node->priceRoot;
+        PriceNode* highest = node->priceRoot;
+        while (lowest->left != NULL) {
+            COUNT_VISITS(1);
+            lowest = lowest->left;
+        }
+        while (highest->right != NULL) {
+            COUNT_VISITS(1);
+            highest = highest->right;
+        }
+        *cheapest = lowest->parcel;
+        *mostExpensive = highest->parcel;
+        return;
+    }
+    *cheapest = node->root->parcel;
+    *mostExpensive = node->root->parcel;
+    findPriceRange(node->root, cheapest, mostExpensive);
+}
+
+//FUNCTION: findPriceRange()
+//PARAMETERS: BSTNode* root, Parcel** cheapestParcel, Parcel** expensiveParcel - the bst tree to search and two pointers that will point to
+// the cheapest and most expensive parcel, both start at a parcel of the tree
+//DESCRIPTION: the function uses in-order traversal, so it sees the parcels in weight order. both pointers are moved to the first parcel,
+// then to any later parcel that is cheaper than the cheapestParcel, or at least as expensive as the expensiveParcel. so of equal prices it
+// keeps the first cheapest and the last most expensive in weight order, the same two parcels as the ends of the valuation index and of the
+// column store's price order. this finds both prices in one pass over the weight tree without using the valuation index, and is what
+// --verify-load checks the index against.
+//RETURNS: void - the pointers do not need to be returned since they're being passed by reference.
+void findPriceRange(BSTNode* root, Parcel** cheapestParcel, Parcel** expensiveParcel) {
+    WeightCursor cursor;
+    openTreeCursor(&cursor, root, CURSOR_IN_ORDER);
+    BSTNode* node = nextTreeCursor(&cursor);
+    if (node != NULL) {
+        *cheapestParcel = node->parcel;
+        *expensiveParcel = node->parcel;
+    }
+    for (; node != NULL; node = nextTreeCursor(&cursor)) { //traverse through the whole bst
+        if (node->parcel->valuation < (*cheapestParcel)->valuation) {
+            *cheapestParcel = node->parcel;
+        }
+        if (node->parcel->valuation >= (*expensiveParcel)->valuation) {
+            *expensiveParcel = node->parcel;
+        }
+    }
+    closeTreeCursor(&cursor);
+}
+
+//FUNCTION: printCheapest()
+//PARAMETERS: PriceNode* root, int remaining - a valuation index and how many parcels are to be printed
+//DESCRIPTION: in-order traversal of the valuation index that prints parcels cheapest first and stops once remaining reaches 0, so only the
+// path down to the cheapest parcel and the K parcels printed are visited
+//RETURNS: int - how many parcels were left to print when the index ran out, 0 if it had enough
+int printCheapest(PriceNode* root, int remaining) {
+    PriceCursor cursor;
+    openTreeCursor(&cursor, root, CURSOR_IN_ORDER);
+    for (PriceNode* node = NULL; remaining > 0 && (node = nextTreeCursor(&cursor)) != NULL; --remaining) {
+        writeParcel(node->parcel->countryId, node->parcel->weight, node->parcel->valuation);
+    }
+    closeTreeCursor(&cursor);
+    return remaining;
+}
+
+//FUNCTION: printMostExpensive()
+//PARAMETERS: PriceNode* root, int remaining - a valuation index and how many parcels are to be printed
+//DESCRIPTION: the mirror of printCheapest(), walks the index in reverse so the parcels come out most expensive first
+//RETURNS: int - how many parcels were left to print when the index ran out, 0 if it had enough
+int printMostExpensive(PriceNode* root, int remaining) {
+    PriceCursor cursor;
+    openTreeCursor(&cursor, root, CURSOR_REVERSE);
+    for (PriceNode* node = NULL; remaining > 0 && (node = nextTreeCursor(&cursor)) != NULL; --remaining) {
+        writeParcel(node->parcel->countryId, node->parcel->weight, node->parcel->valuation);
+    }
+    closeTreeCursor(&cursor);
+    return remaining;
+}
+
+//FUNCTION: printPriceRange()
+//PARAMETERS: PriceNode* root, int minValuation, int maxValuation - a valuation index and the inclusive range of valuations
+//DESCRIPTION: seeks a cursor to the cheapest parcel of at least minValuation and prints from there until the first one above maxValuation,
+// so subtrees entirely outside the range are skipped
+//RETURNS: void
+void printPriceRange(PriceNode* root, int minValuation, int maxValuation) {
+    PriceCursor cursor;
+    seekTreeCursor(&cursor, root, minValuation, maxValuation);
+    for (PriceNode* node = nextTreeCursor(&cursor); node != NULL; node = nextTreeCursor(&cursor)) {
+        writeParcel(node->parcel->countryId, node->parcel->weight, node->parcel->valuation);
+    }
+    closeTreeCursor(&cursor);
+}
+
+//FUNCTION: displayTopPrices()
+//PARAMETERS: const char* country, int count, int cheapestFirst, HashTable* hashTable - the country, K, 1 for the K cheapest parcels or 0 for
+// the K most expensive, and the hash table
+//DESCRIPTION: finds the country and prints its K cheapest or most expensive parcels from the valuation index, building the index first if
+// this is the first query that needs it
+//RETURNS: void
+void displayTopPrices(const char* country, int count, int cheapestFirst, HashTable* hashTable) {
+    PROBE(PROBE_TOP_PRICES);
+    HashNode* node = findCountryNode(country, hashTable);
+    if (node == NULL || node->root == NULL) {
+        printf("No parcels found for country %s\n", country);
+        return;
+    }
+    buildPriceIndex(node);
+    if (cheapestFirst) {
+        printCheapest(node->priceRoot, count);
+    }
+    else {
+        printMostExpensive(node->priceRoot, count);
+    }
+    flushAllOutput();
+}
+
+//FUNCTION: searchByPrice()
+//PARAMETERS: const char* country, int minValuation, int maxValuation, HashTable* hashTable - the country, the inclusive range of
+// valuations in cents and the hash table
+//DESCRIPTION: finds the country and prints its parcels valued between the two prices, cheapest first, building the valuation index first
+// if this is the first query that needs it
+//RETURNS: void
+void searchByPrice(const char* country, int minValuation, int maxValuation, HashTable* hashTable) {
+    PROBE(PROBE_PRICE_RANGE);
+    HashNode* node = findCountryNode(country, hashTable);
+    if (node == NULL || node->root == NULL) {
+        printf("No parcels found for country %s\n", country);
+        return;
+    }
+    buildPriceIndex(node);
+    printPriceRange(node->priceRoot, minValuation, maxValuation);
+    flushAllOutput();
+}
+
+/* Display the lightest and heaviest parcels */
+//FUNCTION: displayLightestAndHeaviest()
+//PARAMETERS: const char* country, HashTable* hashTable - country being calculated and hashtable to get the country info from
+//DESCRIPTION: finds the country's root in the hash table through the country index, finds the lowest and highest weighted parcels with
+// weightExtremes() and prints the information of the parcel for these lowest and highest parcels.
+//RETURNS: void
+void displayLightestAndHeaviest(const char* country, HashTable* hashTable) {
+    PROBE(PROBE_WEIGHT_EXTREMES);
+    HashNode* node = findCountryNode(country, hashTable);
+    BSTNode* root = (node == NULL) ? NULL : node->root;
+    if (root == NULL) {
+        printf("No parcels found for country %s\n", country);
+        return;
+    }
+    Parcel* lightest = NULL;
+    Parcel* heaviest = NULL;
+    weightExtremes(root, &lightest, &heaviest);
+    printf("Lightest Parcel - Destination: %s, Weight: %d, Valuation: " CENTS "\n",
+        countryName(lightest->countryId), lightest->weight, DOLLARS(lightest->valuation));
+
+    printf("Heaviest Parcel - Destination: %s, Weight: %d, Valuation: " CENTS "\n",
+        countryName(heaviest->countryId), heaviest->weight, DOLLARS(heaviest->valuation));
+}
+
+//FUNCTION: weightExtremes()
+//PARAMETERS: BSTNode* root, Parcel** lightest, Parcel** heaviest - a tree with at least one parcel and where its lightest and heaviest
+// parcels go
+//DESCRIPTION: visits the leftmost side of the bst for the lowest weighted parcel and the rightmost side for the heaviest
+//RETURNS: void
+void weightExtremes(BSTNode* root, Parcel** lightest, Parcel** heaviest) {
+    BSTNode* node = root;
+    while (node->left != NULL) {
+        COUNT_VISITS(1);
+        node = node->left;
+    }
+    *lightest = node->parcel;
+    node = root;
+    while (node->right != NULL) {
+        COUNT_VISITS(1);
+        node = node->right;
+    }
+    *heaviest = node->parcel;
+}
+
+/* Deliveries and updates */
+//FUNCTION: deliverParcel()
+//PARAMETERS: const char* country, int weight, int valuation, HashTable* hashTable - the parcel as the queries print it and the table
+//DESCRIPTION: removes a delivered or cancelled parcel with removeParcel() and says which one went
+//RETURNS: void
+void deliverParcel(const char* country, int weight, int valuation, HashTable* hashTable) {
+    HashNode* node = findCountryNode(country, hashTable);
+    if (node == NULL || removeParcel(node, weight, valuation) == ERROR) {
+        printf("No parcel found for country %s with weight %d and valuation " CENTS "\n", country, weight, DOLLARS(valuation));
+        return;
+    }
+    printf("Removed Parcel - Destination: %s, Weight: %d, Valuation: " CENTS "\n", country, weight, DOLLARS(valuation));
+}
+
+//FUNCTION: updateParcel()
+//PARAMETERS: const char* country, int weight, int valuation, int newWeight, int newValuation, HashTable* hashTable - the parcel as the
+// queries print it, what it should become and the table
+//DESCRIPTION: changes the parcel with changeParcel() and prints it as it is now
+//RETURNS: void
+void updateParcel(const char* country, int weight, int valuation, int newWeight, int newValuation, HashTable* hashTable) {
+    if (!isValidParcel(newWeight, newValuation)) {
+        printf("Weight must be between %d and %d and valuation between %d and %d\n", parcelLimits.minWeight, parcelLimits.maxWeight,
+            parcelLimits.minValuation / 100, parcelLimits.maxValuation / 100);
+        return;
+    }
+    HashNode* node = findCountryNode(country, hashTable);
+    if (node == NULL || changeParcel(node, weight, valuation, newWeight, newValuation) == ERROR) {
+        printf("No parcel found for country %s with weight %d and valuation " CENTS "\n", country, weight, DOLLARS(valuation));
+        return;
+    }
+    printf("Updated Parcel - Destination: %s, Weight: %d, Valuation: " CENTS "\n", country, newWeight, DOLLARS(newValuation));
+}
+
+//FUNCTION: removeParcel()
+//PARAMETERS: HashNode* node, int weight, int valuation - a country's hash node and the weight and valuation of the parcel to remove
+//DESCRIPTION: a parcel is known by its country, weight and valuation, which is all the queries show of it. when several parcels have the
+// same three, the one loaded first goes, since nothing can tell them apart. it comes out of the weight tree with removeBST() and out of the
+// valuation index with removePrice() if that has been built, and its memory goes back to the country's arena for the next parcel. the
+// trees must not be published, so this can't run while --follow is
+//RETURNS: int - SUCCESS, or ERROR if the country has no such parcel
+int removeParcel(HashNode* node, int weight, int valuation) {
+    Parcel* parcel = NULL;
+    node->root = removeBST(&node->arena, node->root, weight, valuation, &parcel);
+    if (parcel == NULL) {
+        return ERROR;
+    }
+    if (node->priceRoot != NULL) {
+        int found = 0;
+        node->priceRoot = removePrice(&node->arena, node->priceRoot, parcel, valuation, &found);
+    }
+    arenaFree(&node->arena, parcel, sizeof(Parcel));
+    return SUCCESS;
+}
+
+//FUNCTION: changeParcel()
+//PARAMETERS: HashNode* node, int weight, int valuation, int newWeight, int newValuation - a country's hash node, the parcel as
+// removeParcel() finds it and the weight and valuation it should have. the new values must pass isValidParcel()
+//DESCRIPTION: when only the valuation changes the parcel keeps its place in the weight tree and revalueBST() fixes the totals above it, the
+// valuation index moves it with removePrice() and insertPrice(). a new weight takes it out of both trees and adds it again with addParcel(),
+// after any parcels that already had that weight. the parcel itself is kept, so only tree nodes go through the arena's free lists
+//RETURNS: int - SUCCESS, or ERROR if the country has no such parcel
+int changeParcel(HashNode* node, int weight, int valuation, int newWeight, int newValuation) {
+    Parcel* parcel = NULL;
+    if (newWeight == weight) {
+        node->root = revalueBST(node->root, weight, valuation, newValuation, &parcel);
+    }
+    else {
+        node->root = removeBST(&node->arena, node->root, weight, valuation, &parcel);
+    }
+    if (parcel == NULL) {
+        return ERROR;
+    }
+    if (node->priceRoot != NULL) {
+        int found = 0;
+        node->priceRoot = removePrice(&node->arena, node->priceRoot, parcel, valuation, &found);
+    }
+    parcel->valuation = newValuation;
+    if (newWeight == weight) {
+        if (node->priceRoot != NULL) {
+            node->priceRoot = insertPrice(&node->arena, node->priceRoot, parcel, NULL);
+        }
+    }
+    else {
+        parcel->weight = newWeight;
+        addParcel(node, parcel);
+    }
+    return SUCCESS;
+}
+
+//FUNCTION: removeBST()
+//PARAMETERS: Arena* arena, BSTNode* node, int weight, int valuation, Parcel** removed - the country's arena, the root of a subtree, the
+// parcel to remove and where to put it, which must be NULL to start with
+//DESCRIPTION: searches down by weight like insertBST(). parcels of the same weight can be on both sides of a node after rotations, so on a
+// match the left subtree is searched first, then the node, then the right, which finds the first loaded of equal parcels. the node that
+// held it is unlinked with unlinkBST(), then every node on the way back up gets its height and totals updated and is rebalanced, since a
+// removal can shorten a subtree anywhere on the path. the recursion is only as deep as the AVL tree. the parcel itself isn't freed
+//RETURNS: BSTNode* - the new root of the subtree, *removed is left NULL if the parcel isn't in it
+BSTNode* removeBST(Arena* arena, BSTNode* node, int weight, int valuation, Parcel** removed) {
+    if (node == NULL) {
+        return NULL;
+    }
+    if (weight < node->weight) {
+        node->left = removeBST(arena, node->left, weight, valuation, removed);
+    }
+    else if (weight > node->weight) {
+        node->right = removeBST(arena, node->right, weight, valuation, removed);
+    }
+    else {
+        node->left = removeBST(arena, node->left, weight, valuation, removed);
+        if (*removed == NULL && node->parcel->valuation == valuation) {
+            *removed = node->parcel;
+            return unlinkBST(arena, node);
+        }
+        if (*removed == NULL) {
+            node->right = removeBST(arena, node->right, weight, valuation, removed);
+        }
+    }
+    if (*removed == NULL) {
+        return node;
+    }
+    updateNode(node);
+    return rebalanceBST(node);
+}
+
+//FUNCTION: revalueBST()
+//PARAMETERS: BSTNode* node, int weight, int valuation, int newValuation, Parcel** changed - the root of a subtree, the parcel to change,
+// its new valuation and where to put it, which must be NULL to start with
+//DESCRIPTION: finds the parcel the same way removeBST() does and sets its new valuation, then updates the totals of every node on the way
+// back up. the weight order doesn't change so nothing is rotated
+//RETURNS: BSTNode* - the root of the subtree, *changed is left NULL if the parcel isn't in it
+BSTNode* revalueBST(BSTNode* node, int weight, int valuation, int newValuation, Parcel** changed) {
+    if (node == NULL) {
+        return NULL;
+    }
+    if (weight < node->weight) {
+        revalueBST(node->left, weight, valuation, newValuation, changed);
+    }
+    else if (weight > node->weight) {
+        revalueBST(node->right, weight, valuation, newValuation, changed);
+    }
+    else {
+        revalueBST(node->left, weight, valuation, newValuation, changed);
+        if (*changed == NULL && node->parcel->valuation == valuation) {
+            *changed = node->parcel;
+            node->parcel->valuation = newValuation;
+        }
+        if (*changed == NULL) {
+            revalueBST(node->right, weight, valuation, newValuation, changed);
+        }
+    }
+    if (*changed != NULL) {
+        updateNode(node);
+    }
+    return node;
+}
+
+//FUNCTION: unlinkBST()
+//PARAMETERS: Arena* arena, BSTNode* node - the country's arena and the node to take out of the tree
+//DESCRIPTION: a node with one child or none is replaced by that child. otherwise the lightest node of its right subtree, the next one in
+// weight order, takes its place so parcels of equal weight keep their order. the node's memory goes back to the arena
+//RETURNS: BSTNode* - the root of what is left of the node's subtree
+BSTNode* unlinkBST(Arena* arena, BSTNode* node) {
+    BSTNode* replacement = node->right;
+    if (node->left == NULL) {
+        replacement = node->right;
+    }
+    else if (node->right == NULL) {
+        replacement = node->left;
+    }
+    else {
+        BSTNode* right = removeLightest(node->right, &replacement);
+        replacement->left = node->left;
+        replacement->right = right;
+        updateNode(replacement);
+        replacement = rebalanceBST(replacement);
+    }
+    arenaFree(arena, node, sizeof(BSTNode));
+    return replacement;
+}
+
+//FUNCTION: removeLightest()
+//PARAMETERS: BSTNode* node, BSTNode** lightest - the root of a subtree and where to put its leftmost node
+//DESCRIPTION: detaches the leftmost node, rebalancing on the way back up, without freeing it
+//RETURNS: BSTNode* - the new root of the subtree
+BSTNode* removeLightest(BSTNode* node, BSTNode** lightest) {
+    if (node->left == NULL) {
+        *lightest = node;
+        return node->right;
+    }
+    node->left = removeLightest(node->left, lightest);
+    updateNode(node);
+    return rebalanceBST(node);
+}
+
+//FUNCTION: removePrice()
+//PARAMETERS: Arena* arena, PriceNode* node, Parcel* parcel, int valuation, int* found - the country's arena, the root of a subtree of its
+// valuation index, the parcel to take out, the valuation it is indexed under and a flag set once it is removed, which must be 0 to start with
+//DESCRIPTION: removeBST() for the valuation index. the parcel is already known, so among equal valuations it is matched by address
+//RETURNS: PriceNode* - the new root of the subtree
+PriceNode* removePrice(Arena* arena, PriceNode* node, Parcel* parcel, int valuation, int* found) {
+    if (node == NULL) {
+        return NULL;
+    }
+    if (valuation < node->valuation) {
+        node->left = removePrice(arena, node->left, parcel, valuation, found);
+    }
+    else if (valuation > node->valuation) {
+        node->right = removePrice(arena, node->right, parcel, valuation, found);
+    }
+    else if (node->parcel == parcel) {
+        *found = 1;
+        return unlinkPrice(arena, node);
+    }
+    else {
+        node->left = removePrice(arena, node->left, parcel, valuation, found);
+        if (!*found) {
+            node->right = removePrice(arena, node->right, parcel, valuation, found);
+        }
+    }
+    if (!*found) {
+        return node;
+    }
+    updatePriceHeight(node);
+    return rebalancePrice(node);
+}
+
+//FUNCTION: unlinkPrice()
+//PARAMETERS: Arena* arena, PriceNode* node - the country's arena and the node to take out of the valuation index
+//DESCRIPTION: unlinkBST() for the valuation index
+//RETURNS: PriceNode* - the root of what is left of the node's subtree
+PriceNode* unlinkPrice(Arena* arena, PriceNode* node) {
+    PriceNode* replacement = node->right;
+    if (node->left == NULL) {
+        replacement = node->right;
+    }
+    else if (node->right == NULL) {
+        replacement = node->left;
+    }
+    else {
+        PriceNode* right = removeCheapest(node->right, &replacement);
+        replacement->left = node->left;
+        replacement->right = right;
+        updatePriceHeight(replacement);
+        replacement = rebalancePrice(replacement);
+    }
+    arenaFree(arena, node, sizeof(PriceNode));
+    return replacement;
+}
+
+//FUNCTION: removeCheapest()
+//PARAMETERS: PriceNode* node, PriceNode** cheapest - the root of a subtree of a valuation index and where to put its leftmost node
+//DESCRIPTION: removeLightest() for the valuation index
+//RETURNS: PriceNode* - the new root of the subtree
+PriceNode* removeCheapest(PriceNode* node, PriceNode** cheapest) {
+    if (node->left == NULL) {
+        *cheapest = node;
+        return node->right;
+    }
+    node->left = removeCheapest(node->left, cheapest);
+    updatePriceHeight(node);
+    return rebalancePrice(node);
+}
+
+/* Churn benchmark */
+//FUNCTION: selectBST()
+//PARAMETERS: BSTNode* root, int rank - a tree and a position in weight order, from 0 to one less than the tree's count
+//DESCRIPTION: walks down using the subtree counts, so any position is found in one descent
+//RETURNS: BSTNode* - the node at that position
+BSTNode* selectBST(BSTNode* root, int rank) {
+    BSTNode* node = root;
+    while (node != NULL) {
+        int left = (node->left == NULL) ? 0 : node->left->subtree.count;
+        if (rank < left) {
+            node = node->left;
+        }
+        else if (rank == left) {
+            return node;
+        }
+        else {
+            rank -= left + 1;
+            node = node->right;
+        }
+    }
+    return NULL;
+}
+
+//FUNCTION: benchmarkChurn()
+//PARAMETERS: HashTable* hashTable - the loaded table
+//DESCRIPTION: builds every valuation index so both trees are kept up to date, then runs CHURN_BENCH_HOURS simulated hours of
+// CHURN_BENCH_OPERATIONS operations each on random destinations: 80% are a new parcel while there are no more parcels than were loaded and
+// a delivery of a random existing one while there are, so the count stays about the same, 10% are new valuations and 10% new weights. after each hour it prints the parcel count, the memory the arenas have reserved and are using, and the
+// latency of the hour's operations. at the end it checks the trees, totals and valuation indexes and that the count is right
+//RETURNS: int - SUCCESS, or ERROR if a check failed
+int benchmarkChurn(HashTable* hashTable) {
+    buildAllPriceIndexes(hashTable);
+    double* seconds = (double*)countedMalloc(CHURN_BENCH_OPERATIONS * sizeof(double));
+    if (seconds == NULL) {
+        perror("Unable to allocate memory for churn benchmark");
+        exit(1);
+    }
+    long long loaded = 0;
+    for (int id = 0; id < countryDictionary.count; ++id) {
+        BSTNode* root = countryNode(hashTable, id)->root;
+        loaded += (root == NULL) ? 0 : root->subtree.count;
+    }
+    long long parcels = loaded;
+    unsigned long long seed = 0x2545F4914F6CDD1DULL;
+    int missing = 0;
+    size_t firstReserved = 0;
+    size_t reserved = 0;
+    printf("%d simulated hours of %d operations: 80%% new parcels or deliveries keeping about %lld parcels, 10%% new valuations, 10%% new "
+        "weights\n", CHURN_BENCH_HOURS, CHURN_BENCH_OPERATIONS, loaded);
+    for (int hour = 1; hour <= CHURN_BENCH_HOURS; ++hour) {
+        for (int i = 0; i < CHURN_BENCH_OPERATIONS; ++i) {
+            int id = (int)(nextRandom(&seed) % countryDictionary.count);
+            HashNode* node = countryNode(hashTable, id);
+            int kind = (int)(nextRandom(&seed) % 10);
+            int newWeight = MIN_WEIGHT + (int)(nextRandom(&seed) % (MAX_WEIGHT - MIN_WEIGHT + 1));
+            int newValuation = MIN_PRICE * 100 + (int)(nextRandom(&seed) % ((MAX_PRICE - MIN_PRICE) * 100 + 1));
+            BSTNode* target = NULL;
+            if (kind < 8) {
+                kind = (parcels > loaded) ? 4 : 0;
+            }
+            if (kind >= 4 && node->root != NULL) {
+                target = selectBST(node->root, (int)(nextRandom(&seed) % node->root->subtree.count));
+            }
+            int weight = (target == NULL) ? 0 : target->weight;
+            int valuation = (target == NULL) ? 0 : target->parcel->valuation;
+            double start = nowSeconds();
+            if (target == NULL) {
+                addParcel(node, createParcel(&node->arena, id, newWeight, newValuation));
+                parcels++;
+            }
+            else if (kind == 4) {
+                missing += removeParcel(node, weight, valuation) == ERROR;
+                parcels--;
+            }
+            else if (kind == 8) {
+                missing += changeParcel(node, weight, valuation, weight, newValuation) == ERROR;
+            }
+            else {
+                missing += changeParcel(node, weight, valuation, newWeight, valuation) == ERROR;
+            }
+            seconds[i] = nowSeconds() - start;
+        }
+        reserved = 0;
+        size_t used = 0;
+        for (int id = 0; id < countryDictionary.count; ++id) {
+            reserved += hashTable->nodes[id].arena.bytesReserved;
+            used += hashTable->nodes[id].arena.bytesUsed;
+        }
+        if (hour == 1) {
+            firstReserved = reserved;
+        }
+        char label[128];
+        snprintf(label, sizeof(label), "hour %2d: %8lld parcels, %7.2f MB reserved, %7.2f MB in use, latency", hour, parcels,
+            reserved / (1024.0 * 1024.0), used / (1024.0 * 1024.0));
+        printPercentiles(stdout, label, seconds, CHURN_BENCH_OPERATIONS);
+    }
+    free(seconds);
+
+    int broken = 0;
+    long long total = 0;
+    for (int id = 0; id < countryDictionary.count; ++id) {
+        HashNode* node = countryNode(hashTable, id);
+        total += (node->root == NULL) ? 0 : node->root->subtree.count;
+        // a country that was emptied lost its valuation index and only gets a new one when a query needs it
+        buildPriceIndex(node);
+        if (!checkSubtreeTotals(node->root) || !checkPriceIndex(node)) {
+            broken++;
+        }
+    }
+    int passed = missing == 0 && broken == 0 && total == parcels;
+    printf("arenas grew %.1f%% after hour 1, %d parcels not found, %d countries failed their checks, %lld of %lld parcels in the table: %s\n",
+        (firstReserved == 0) ? 0.0 : 100.0 * ((double)reserved - (double)firstReserved) / (double)firstReserved, missing, broken, total,
+        parcels, passed ? "passed" : "FAILED");
+    return passed ? SUCCESS : ERROR;
+}
+
+/* Traversal benchmark */
+//FUNCTION: benchmarkTraversal()
+//PARAMETERS: HashTable* hashTable - the loaded table
+//DESCRIPTION: runs checkDegenerateTree() on a left and a right leaning tree, then times three walks over every country of the loaded table,
+// each with the recursive version the program used to have and with its cursor: the in-order totals of traverseAndAddBST(), the pre-order
+// price range of findPriceRange() and countBST(). each walk is repeated until about TRAVERSAL_BENCH_VISITS nodes have been visited and
+// prints millions of nodes a second for both versions, which must give the same answers
+//RETURNS: int - SUCCESS, or ERROR if a check failed
+int benchmarkTraversal(HashTable* hashTable) {
+    int leftPassed = checkDegenerateTree(1);
+    int rightPassed = checkDegenerateTree(0);
+    long long parcels = 0;
+    for (int id = 0; id < countryDictionary.count; ++id) {
+        BSTNode* root = countryNode(hashTable, id)->root;
+        parcels += (root == NULL) ? 0 : root->subtree.count;
+    }
+    if (parcels == 0) {
+        printf("No parcels loaded\n");
+        return (leftPassed && rightPassed) ? SUCCESS : ERROR;
+    }
+    int rounds = (int)(TRAVERSAL_BENCH_VISITS / parcels) + 1;
+    const char* walks[] = { "in-order totals", "pre-order price range", "node count" };
+    int mismatches = 0;
+    printf("%d rounds over %lld parcels, millions of nodes/s:\n", rounds, parcels);
+    printf("  %-22s %10s %10s\n", "walk", "recursive", "cursor");
+    for (int walk = 0; walk < 3; ++walk) {
+        double seconds[2];
+        double checksum[2];
+        for (int version = 0; version < 2; ++version) {
+            checksum[version] = 0.0;
+            double start = nowSeconds();
+            for (int round = 0; round < rounds; ++round) {
+                for (int id = 0; id < countryDictionary.count; ++id) {
+                    BSTNode* root = countryNode(hashTable, id)->root;
+                    if (root == NULL) {
+                        continue;
+                    }
+                    if (walk == 0) {
+                        long long weight = 0;
+                        long long valuation = 0;
+                        if (version == 0) {
+                            traverseAndAddRecursive(root, weight, valuation);
+                        }
+                        else {
+                            traverseAndAddBST(root, weight, valuation);
+                        }
+                        checksum[version] += weight + valuation;
+                    }
+                    else if (walk == 1) {
+                        Parcel* lowest = root->parcel;
+                        Parcel* highest = root->parcel;
+                        if (version == 0) {
+                            findPriceRangeRecursive(root, &lowest, &highest);
+                        }
+                        else {
+                            findPriceRange(root, &lowest, &highest);
+                        }
+                        checksum[version] += lowest->valuation + highest->valuation;
+                    }
+                    else {
+                        checksum[version] += (version == 0) ? countBSTRecursive(root) : countBST(root);
+                    }
+                }
+            }
+            seconds[version] = nowSeconds() - start;
+        }
+        mismatches += checksum[0] != checksum[1];
+        printf("  %-22s %10.1f %10.1f\n", walks[walk], (double)rounds * parcels / seconds[0] / 1e6, (double)rounds * parcels / seconds[1] / 1e6);
+    }
+    int passed = leftPassed && rightPassed && mismatches == 0;
+    printf("%d walks gave different answers to the recursive ones: %s\n", mismatches, passed ? "passed" : "FAILED");
+    return passed ? SUCCESS : ERROR;
+}
+
+//FUNCTION: checkDegenerateTree()
+//PARAMETERS: int leftLeaning - 1 for a tree where every node is the left child of the one above, 0 for right children
+//DESCRIPTION: links DEGENERATE_TREE_NODES parcels into a weight tree and a valuation index that are one long path, the shape a plain BST
+// gets from a sorted file and the deepest any tree can be, which the recursive walks would have needed a million stack frames for. then
+// checks every walk over it gives the right answer: the count, totals, depths, subtree totals, price range, weight order, a weight range,
+// the columns, comparing the tree to itself, and the valuation index in both directions
+//RETURNS: int - 1 if every check passed, 0 if not
+int checkDegenerateTree(int leftLeaning) {
+    int count = DEGENERATE_TREE_NODES;
+    BSTNode* nodes = (BSTNode*)countedMalloc(count * sizeof(BSTNode));
+    PriceNode* prices = (PriceNode*)countedMalloc(count * sizeof(PriceNode));
+    Parcel* parcels = (Parcel*)countedMalloc(count * sizeof(Parcel));
+    PricedParcel* listed = (PricedParcel*)countedMalloc(count * sizeof(PricedParcel));
+    ColumnStore store;
+    store.weights = (int*)countedMalloc(count * sizeof(int));
+    store.valuations = (int*)countedMalloc(count * sizeof(int));
+    store.countryIds = (int*)countedMalloc(count * sizeof(int));
+    if (nodes == NULL || prices == NULL || parcels == NULL || listed == NULL || store.weights == NULL || store.valuations == NULL ||
+        store.countryIds == NULL) {
+        perror("Unable to allocate memory for degenerate tree");
+        exit(1);
+    }
+    linkDegenerateTree(nodes, prices, parcels, count, leftLeaning);
+    BSTNode* root = &nodes[0];
+    PriceNode* priceRoot = &prices[0];
+    long long expectedWeight = 0;
+    long long expectedValuation = 0;
+    for (int i = 0; i < count; ++i) {
+        expectedWeight += parcels[i].weight;
+        expectedValuation += parcels[i].valuation;
+    }
+    double start = nowSeconds();
+    int failed = 0;
+    failed += countBST(root) != count;
+    long long weight = 0;
+    long long valuation = 0;
+    traverseAndAddBST(root, weight, valuation);
+    failed += weight != expectedWeight || valuation != expectedValuation;
+    failed += sumDepths(root) != (long long)count * (count + 1) / 2;
+    failed += !checkSubtreeTotals(root);
+    Parcel* lowest = root->parcel;
+    Parcel* highest = root->parcel;
+    findPriceRange(root, &lowest, &highest);
+    failed += lowest->valuation != parcels[0].valuation || highest->valuation != parcels[count - 1].valuation;
+    int next = 0;
+    collectParcels(root, listed, next);
+    int ordered = next == count;
+    for (int i = 0; i < next && ordered; ++i) {
+        ordered = listed[i].parcel == &parcels[i];
+    }
+    failed += !ordered;
+    int minWeight = parcels[count / 4].weight;
+    int maxWeight = parcels[3 * count / 4].weight;
+    WeightCursor cursor;
+    openWeightCursor(&cursor, root, minWeight, maxWeight);
+    int walked = 0;
+    while (nextWeightCursor(&cursor) != NULL) {
+        walked++;
+    }
+    closeTreeCursor(&cursor);
+    failed += walked != countWeightRange(root, minWeight, maxWeight) || walked != countWeightRangeScan(root, minWeight, maxWeight);
+    int row = 0;
+    fillColumns(root, &store, row);
+    ordered = row == count;
+    for (int i = 0; i < row && ordered; ++i) {
+        ordered = store.weights[i] == parcels[i].weight && store.valuations[i] == parcels[i].valuation;
+    }
+    failed += !ordered;
+    failed += !compareBST(root, root);
+    int previous = INT_MIN;
+    int priced = 0;
+    failed += !checkPriceOrder(priceRoot, &previous, &priced) || priced != count;
+    PriceCursor reverse;
+    openTreeCursor(&reverse, priceRoot, CURSOR_REVERSE);
+    int remaining = count;
+    ordered = 1;
+    for (PriceNode* node = nextTreeCursor(&reverse); node != NULL && ordered; node = nextTreeCursor(&reverse)) {
+        ordered = remaining > 0 && node->parcel == &parcels[--remaining];
+    }
+    closeTreeCursor(&reverse);
+    failed += !ordered || remaining != 0;
+    printf("%s tree of %d nodes, %d deep: %d checks failed in %.3f ms: %s\n", leftLeaning ? "left leaning" : "right leaning", count,
+        nodeHeight(root), failed, (nowSeconds() - start) * 1000.0, (failed == 0) ? "passed" : "FAILED");
+    free(store.countryIds);
+    free(store.valuations);
+    free(store.weights);
+    free(listed);
+    free(parcels);
+    free(prices);
+    free(nodes);
+    return failed == 0;
+}
+
+//FUNCTION: linkDegenerateTree()
+//PARAMETERS: BSTNode* nodes, PriceNode* prices, Parcel* parcels, int count, int leftLeaning - room for count nodes of each tree and count
+// parcels, and which side the path goes down
+//DESCRIPTION: fills in the parcels so parcels[i] is the i-th lightest and cheapest, weights going up by 1 every 1000 parcels and prices by
+// 0.01 every 10, then links nodes[0] and prices[0] as the roots of two paths that hold them in that order. the nodes are linked from the
+// bottom up so updateNode() can set each one's totals from its child's
+//RETURNS: void
+void linkDegenerateTree(BSTNode* nodes, PriceNode* prices, Parcel* parcels, int count, int leftLeaning) {
+    for (int k = count - 1; k >= 0; --k) {
+        int position = leftLeaning ? count - 1 - k : k;
+        Parcel* parcel = &parcels[position];
+        parcel->countryId = 0;
+        parcel->weight = 1 + position / 1000;
+        parcel->valuation = position / 10;
+        BSTNode* node = &nodes[k];
+        node->parcel = parcel;
+        node->weight = parcel->weight;
+        node->left = (leftLeaning && k + 1 < count) ? &nodes[k + 1] : NULL;
+        node->right = (!leftLeaning && k + 1 < count) ? &nodes[k + 1] : NULL;
+        updateNode(node);
+        PriceNode* price = &prices[k];
+        price->parcel = parcel;
+        price->valuation = parcel->valuation;
+        price->left = (leftLeaning && k + 1 < count) ? &prices[k + 1] : NULL;
+        price->right = (!leftLeaning && k + 1 < count) ? &prices[k + 1] : NULL;
+        updatePriceHeight(price);
+    }
+}
+
+//FUNCTION: traverseAndAddRecursive()
+//PARAMETERS: BSTNode* node, long long& totalWeight, long long& totalValuation - same as traverseAndAddBST()
+//DESCRIPTION: the recursive traverseAndAddBST() the cursor replaced, kept for --bench-traversal to time against
+//RETURNS: void - variables are passed by reference and directly altered
+void traverseAndAddRecursive(BSTNode* node, long long& totalWeight, long long& totalValuation) {
+    if (node == NULL) {
+        return;
+    }
+    traverseAndAddRecursive(node->left, totalWeight, totalValuation);
+    totalWeight += node->parcel->weight;
+    totalValuation += node->parcel->valuation;
+    traverseAndAddRecursive(node->right, totalWeight, totalValuation);
+}
+
+//FUNCTION: findPriceRangeRecursive()
+//PARAMETERS: BSTNode* root, Parcel** cheapestParcel, Parcel** expensiveParcel - same as findPriceRange()
+//DESCRIPTION: the recursive findPriceRange() the cursor replaced, kept for --bench-traversal to time against
+//RETURNS: void - the pointers are passed by reference
+void findPriceRangeRecursive(BSTNode* root, Parcel** cheapestParcel, Parcel** expensiveParcel) {
     if (root == NULL) {
         return;
     }
-    //check if the current node's price is lower than the price from the previous root
-    if (root->parcel->valuation > (*expensiveParcel)->valuation) {
-        *expensiveParcel = root->parcel;
+    if (root->parcel->valuation < (*cheapestParcel)->valuation) {
+        *cheapestParcel = root->parcel;
+    }
+    if (root->parcel->valuation > (*expensiveParcel)->valuation) {
+        *expensiveParcel = root->parcel;
+    }
+    findPriceRangeRecursive(root->left, cheapestParcel, expensiveParcel);
+    findPriceRangeRecursive(root->right, cheapestParcel, expensiveParcel);
+}
+
+//FUNCTION: countBSTRecursive()
+//PARAMETERS: BSTNode* root - a tree
+//DESCRIPTION: the recursive countBST() the cursor replaced, kept for --bench-traversal to time against
+//RETURNS: int - the number of parcels
+int countBSTRecursive(BSTNode* root) {
+    if (root == NULL) {
+        return 0;
+    }
+    return countBSTRecursive(root->left) + 1 + countBSTRecursive(root->right);
+}
+
+/* Benchmark suite */
+//FUNCTION: countedMalloc()
+//PARAMETERS: size_t size - how many bytes to allocate
+//DESCRIPTION: malloc() that a -DPARCEL_STATS build counts with countAllocation()
+//RETURNS: void* - the memory, or NULL if it couldn't be allocated
+void* countedMalloc(size_t size) {
+    COUNT_ALLOCATION(size);
+    return malloc(size);
+}
+
+//FUNCTION: countedCalloc()
+//PARAMETERS: size_t count, size_t size - how many elements to allocate and the size of each
+//DESCRIPTION: calloc() that a -DPARCEL_STATS build counts with countAllocation()
+//RETURNS: void* - the zeroed memory, or NULL if it couldn't be allocated
+void* countedCalloc(size_t count, size_t size) {
+    COUNT_ALLOCATION(count * size);
+    return calloc(count, size);
+}
+
+//FUNCTION: countedRealloc()
+//PARAMETERS: void* memory, size_t size - the memory to resize, or NULL, and its new size in bytes
+//DESCRIPTION: realloc() that a -DPARCEL_STATS build counts with countAllocation()
+//RETURNS: void* - the resized memory, or NULL if it couldn't be resized, which leaves memory as it was
+void* countedRealloc(void* memory, size_t size) {
+    COUNT_ALLOCATION(size);
+    return realloc(memory, size);
+}
+
+//FUNCTION: countAllocation()
+//PARAMETERS: size_t size - how many bytes a heap call asked for
+//DESCRIPTION: counts the call and its bytes for --bench-suite. only -DPARCEL_STATS builds call it, so other builds don't pay for the
+// atomic adds. heap calls made inside the C library, like the buffer fopen() allocates, aren't counted
+//RETURNS: void
+void countAllocation(size_t size) {
+    heapAllocations.fetch_add(1, std::memory_order_relaxed);
+    heapBytes.fetch_add((long long)size, std::memory_order_relaxed);
+}
+
+#ifdef PARCEL_STATS
+//FUNCTION: operator new()
+//PARAMETERS: size_t size - how many bytes to allocate
+//DESCRIPTION: replaces the global operator new so the allocations std::thread and the standard containers make are counted as well.
+// the array and nothrow forms call this one
+//RETURNS: void* - the memory. throws std::bad_alloc if it couldn't be allocated
+void* operator new(size_t size) {
+    void* memory = countedMalloc((size > 0) ? size : 1);
+    if (memory == NULL) {
+        throw std::bad_alloc();
+    }
+    return memory;
+}
+
+//FUNCTION: operator delete()
+//PARAMETERS: void* memory - memory from operator new, or NULL
+//DESCRIPTION: frees what the replaced operator new allocated
+//RETURNS: void
+void operator delete(void* memory) noexcept {
+    free(memory);
+}
+
+//FUNCTION: operator delete()
+//PARAMETERS: void* memory, size_t size - memory from operator new, or NULL, and its size, which isn't needed
+//DESCRIPTION: the sized form, which has to be replaced with the unsized one
+//RETURNS: void
+void operator delete(void* memory, size_t size) noexcept {
+    (void)size;
+    free(memory);
+}
+#endif
+
+//FUNCTION: writeSuiteManifest()
+//PARAMETERS: const char* path, const Options* options - the file to write and the options, for the rows, destinations, skew and order
+//DESCRIPTION: writes a synthetic manifest in the courier.txt format. destination k (from 1) is picked with probability proportional to
+// 1 / k^skew by a binary search of the cumulative distribution, so a skew of 0 is uniform and 1 is the usual Zipf. weights and valuations
+// are uniform over the valid ranges, and with sorted order the weights are sorted first so the file goes from lightest to heaviest
+//RETURNS: int - SUCCESS, or ERROR if the file couldn't be written
+int writeSuiteManifest(const char* path, const Options* options) {
+    FILE* file = fopen(path, "wb");
+    if (file == NULL) {
+        perror("Unable to create suite manifest");
+        return ERROR;
+    }
+    double* cumulative = (double*)countedMalloc(options->suiteCountries * sizeof(double));
+    int* weights = (int*)countedMalloc((size_t)options->suiteRows * sizeof(int));
+    char* buffer = (char*)countedMalloc(OUTPUT_BUFFER_SIZE);
+    if (cumulative == NULL || weights == NULL || buffer == NULL) {
+        perror("Unable to allocate memory for suite manifest");
+        exit(1);
+    }
+    double sum = 0.0;
+    for (int k = 0; k < options->suiteCountries; ++k) {
+        sum += 1.0 / pow((double)(k + 1), options->suiteSkew);
+        cumulative[k] = sum;
+    }
+    unsigned long long seed = 0x9E3779B97F4A7C15ULL;
+    for (int i = 0; i < options->suiteRows; ++i) {
+        weights[i] = MIN_WEIGHT + (int)(nextRandom(&seed) % (MAX_WEIGHT - MIN_WEIGHT + 1));
+    }
+    if (options->suiteSorted) {
+        qsort(weights, options->suiteRows, sizeof(int), compareInts);
+    }
+    size_t used = 0;
+    for (int i = 0; i < options->suiteRows; ++i) {
+        double pick = (double)(nextRandom(&seed) >> 11) / 9007199254740992.0 * sum;
+        int low = 0;
+        int high = options->suiteCountries - 1;
+        while (low < high) {
+            int middle = (low + high) / 2;
+            if (cumulative[middle] <= pick) {
+                low = middle + 1;
+            }
+            else {
+                high = middle;
+            }
+        }
+        if (used + MAX_ROW_LENGTH > OUTPUT_BUFFER_SIZE) {
+            fwrite(buffer, 1, used, file);
+            used = 0;
+        }
+        char* out = buffer + used;
+        memcpy(out, "Country", 7);
+        out = formatInt(out + 7, low + 1);
+        *out++ = ',';
+        out = formatInt(out, weights[i]);
+        *out++ = ',';
+        out = formatValuation(out, MIN_PRICE * 100 + (int)(nextRandom(&seed) % ((MAX_PRICE - MIN_PRICE) * 100 + 1)));
+        *out++ = '\n';
+        used = (size_t)(out - buffer);
+    }
+    fwrite(buffer, 1, used, file);
+    int result = (fclose(file) == 0) ? SUCCESS : ERROR;
+    free(cumulative);
+    free(weights);
+    free(buffer);
+    return result;
+}
+
+//FUNCTION: benchmarkSuite()
+//PARAMETERS: const Options* options - the options, for the manifest settings, the loader and the loaded file's name
+//DESCRIPTION: writes a synthetic manifest next to the loaded file with writeSuiteManifest(), then SUITE_RUNS times loads it with the
+// loader the options pick, runs each of the five menu queries SUITE_QUERIES times on random destinations and weights, and frees it all
+// with cleanup() and releaseDictionary(). the queries print into the null device, and each one is timed until its output has been written. it prints the
+// percentiles of every phase, with the heap calls and bytes per run in -DPARCEL_STATS builds, then deletes the manifest
+//RETURNS: int - SUCCESS, or ERROR if the manifest couldn't be written or loaded
+int benchmarkSuite(const Options* options) {
+    const char* phases[SUITE_PHASES] = { "load", "1. by country", "2. by weight", "3. totals", "4. cheapest", "5. lightest", "cleanup" };
+    size_t pathLength = strlen(options->filename) + 8;
+    char* path = (char*)countedMalloc(pathLength);
+    double* seconds[SUITE_PHASES];
+    for (int phase = 0; phase < SUITE_PHASES; ++phase) {
+        seconds[phase] = (double*)countedMalloc(SUITE_RUNS * SUITE_QUERIES * sizeof(double));
+        if (seconds[phase] == NULL) {
+            perror("Unable to allocate memory for benchmark suite");
+            exit(1);
+        }
+    }
+    if (path == NULL) {
+        perror("Unable to allocate memory for suite manifest name");
+        exit(1);
+    }
+    snprintf(path, pathLength, "%s.suite", options->filename);
+    double start = nowSeconds();
+    if (writeSuiteManifest(path, options) == ERROR) {
+        for (int phase = 0; phase < SUITE_PHASES; ++phase) {
+            free(seconds[phase]);
+        }
+        free(path);
+        return ERROR;
+    }
+    const char* loaderName = options->useScanfLoader ? "fscanf" : (options->threads > 1) ? "parallel mmap" : "mmap";
+    printf("Wrote %s in %.3f ms: %d rows, %d destinations, Zipf skew %.2f, %s weights. %d runs with the %s loader\n", path,
+        (nowSeconds() - start) * 1000.0, options->suiteRows, options->suiteCountries, options->suiteSkew,
+        options->suiteSorted ? "sorted" : "random", SUITE_RUNS, loaderName);
+
+    long long allocations[SUITE_PHASES] = { 0 };
+    long long bytes[SUITE_PHASES] = { 0 };
+    int result = SUCCESS;
+    unsigned long long seed = 0xD1B54A32D192ED03ULL;
+    initializeDictionary(&countryDictionary);
+    for (int run = 0; run < SUITE_RUNS && result == SUCCESS; ++run) {
+        long long firstCall = heapAllocations.load();
+        long long firstByte = heapBytes.load();
+        start = nowSeconds();
+        HashTable* hashTable = initializeHashTable();
+        LoadStats stats;
+        if (options->useScanfLoader) {
+            result = loadData(path, hashTable, NO_ROW_CAP, &stats);
+        }
+        else if (options->threads > 1) {
+            result = loadDataParallel(path, hashTable, NO_ROW_CAP, options->threads, &stats);
+        }
+        else {
+            result = loadDataMapped(path, hashTable, NO_ROW_CAP, &stats);
+        }
+        seconds[0][run] = nowSeconds() - start;
+        allocations[0] += heapAllocations.load() - firstCall;
+        bytes[0] += heapBytes.load() - firstByte;
+
+        flushOutput(&output);
+        fflush(stdout);
+        int savedStdout = dup(fileno(stdout));
+        FILE* nullDevice = fopen(NULL_DEVICE, "w");
+        if (savedStdout < 0 || nullDevice == NULL) {
+            perror("Unable to open the null device");
+            exit(1);
+        }
+        dup2(fileno(nullDevice), fileno(stdout));
+        for (int query = 1; query <= 5 && result == SUCCESS; ++query) {
+            firstCall = heapAllocations.load();
+            firstByte = heapBytes.load();
+            for (int i = 0; i < SUITE_QUERIES; ++i) {
+                const char* country = countryDictionary.names[nextRandom(&seed) % countryDictionary.count];
+                int weight = MIN_WEIGHT + (int)(nextRandom(&seed) % (MAX_WEIGHT - MIN_WEIGHT + 1));
+                start = nowSeconds();
+                runSuiteQuery(query, country, weight, hashTable);
+                flushOutput(&output);
+                fflush(stdout);
+                seconds[query][run * SUITE_QUERIES + i] = nowSeconds() - start;
+            }
+            allocations[query] += heapAllocations.load() - firstCall;
+            bytes[query] += heapBytes.load() - firstByte;
+        }
+        dup2(savedStdout, fileno(stdout));
+        close(savedStdout);
+        fclose(nullDevice);
+
+        firstCall = heapAllocations.load();
+        firstByte = heapBytes.load();
+        start = nowSeconds();
+        cleanup(hashTable);
+        free(hashTable);
+        releaseDictionary(&countryDictionary);
+        seconds[SUITE_PHASES - 1][run] = nowSeconds() - start;
+        allocations[SUITE_PHASES - 1] += heapAllocations.load() - firstCall;
+        bytes[SUITE_PHASES - 1] += heapBytes.load() - firstByte;
+    }
+    remove(path);
+    free(path);
+    if (result == ERROR) {
+        printf("The suite manifest has fewer than %d rows\n", minimumRows);
+    }
+    else {
+        for (int phase = 0; phase < SUITE_PHASES; ++phase) {
+            int count = (phase == 0 || phase == SUITE_PHASES - 1) ? SUITE_RUNS : SUITE_RUNS * SUITE_QUERIES;
+            printSuitePhase(phases[phase], seconds[phase], count, allocations[phase] / SUITE_RUNS, bytes[phase] / SUITE_RUNS);
+        }
+    }
+    for (int phase = 0; phase < SUITE_PHASES; ++phase) {
+        free(seconds[phase]);
+    }
+    return result;
+}
+
+//FUNCTION: runSuiteQuery()
+//PARAMETERS: int query, const char* country, int weight, HashTable* hashTable - the menu choice from 1 to 5, its country and weight, and
+// the table
+//DESCRIPTION: runs the same function the menu runs for that choice. choice 2 alternates between higher and lower than the weight
+//RETURNS: void
+void runSuiteQuery(int query, const char* country, int weight, HashTable* hashTable) {
+    switch (query) {
+    case 1:
+        searchByCountry(country, hashTable);
+        break;
+    case 2:
+        searchByWeight(country, weight, (weight & 1) ? SEARCH_HIGH : SEARCH_LOW, hashTable);
+        break;
+    case 3:
+        calculateTotalLoadAndValuation(country, hashTable);
+        break;
+    case 4:
+        displayCheapestAndMostExpensive(country, hashTable);
+        break;
+    default:
+        displayLightestAndHeaviest(country, hashTable);
+        break;
+    }
+}
+
+//FUNCTION: printSuitePhase()
+//PARAMETERS: const char* phase, double* seconds, int count, long long allocations, long long bytes - the phase, its times, which get sorted,
+// and its heap calls and bytes per run, which only -DPARCEL_STATS builds print
+//DESCRIPTION: prints one line of the --bench-suite report, in a fixed layout so runs from different builds can be compared line by line
+//RETURNS: void
+void printSuitePhase(const char* phase, double* seconds, int count, long long allocations, long long bytes) {
+    qsort(seconds, count, sizeof(double), compareDoubles);
+#ifdef PARCEL_STATS
+    printf("%-16s p50 %12.1f us  p99 %12.1f us  max %12.1f us  %9lld allocations %12lld bytes per run  (%d samples)\n", phase,
+        percentile(seconds, count, 0.50) * 1e6, percentile(seconds, count, 0.99) * 1e6, percentile(seconds, count, 1.0) * 1e6, allocations,
+        bytes, count);
+#else
+    (void)allocations;
+    (void)bytes;
+    printf("%-16s p50 %12.1f us  p99 %12.1f us  max %12.1f us  (%d samples)\n", phase, percentile(seconds, count, 0.50) * 1e6,
+        percentile(seconds, count, 0.99) * 1e6, percentile(seconds, count, 1.0) * 1e6, count);
+#endif
+}
+
+#ifdef PARCEL_STATS
+/* Instrumentation */
+//FUNCTION: ProbeScope()
+//PARAMETERS: int probe - the PROBE_ number of the function being timed
+//DESCRIPTION: notes the time and this thread's visited node count when the scope starts
+ProbeScope::ProbeScope(int probe) : probe(probe), start(probeClock()), visits(nodesVisited) {
+}
+
+//FUNCTION: ~ProbeScope()
+//PARAMETERS: none
+//DESCRIPTION: records how long the scope took and how many nodes it visited in the probe's two histograms, whichever way it returned
+ProbeScope::~ProbeScope() {
+    recordValue(&probes[probe].nanoseconds, probeClock() - start);
+    recordValue(&probes[probe].visits, nodesVisited - visits);
+}
+
+//FUNCTION: probeClock()
+//PARAMETERS: none
+//DESCRIPTION: monotonic clock for the probes
+//RETURNS: long long - nanoseconds since some fixed point
+long long probeClock(void) {
+    return (long long)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+//FUNCTION: recordValue()
+//PARAMETERS: Histogram* histogram, long long value - the histogram and a value of 0 or more to count in it
+//DESCRIPTION: values below 16 have a bucket each. above that the bucket is picked by the value's highest set bit and the HISTOGRAM_SUB_BITS
+// bits below it, so every power of two gets the same number of buckets and the error stays a fixed fraction of the value
+//RETURNS: void
+void recordValue(Histogram* histogram, long long value) {
+    unsigned long long magnitude = (value < 0) ? 0 : (unsigned long long)value;
+    int bucket = (int)magnitude;
+    if (magnitude >= (1ULL << HISTOGRAM_SUB_BITS)) {
+        int highest = 63;
+        while (!(magnitude >> highest)) {
+            highest--;
+        }
+        int shift = highest - HISTOGRAM_SUB_BITS;
+        bucket = ((shift + 1) << HISTOGRAM_SUB_BITS) + (int)(magnitude >> shift) - (1 << HISTOGRAM_SUB_BITS);
+    }
+    histogram->counts[bucket].fetch_add(1, std::memory_order_relaxed);
+    histogram->total.fetch_add(1, std::memory_order_relaxed);
+    histogram->sum.fetch_add((long long)magnitude, std::memory_order_relaxed);
+    long long max = histogram->max.load(std::memory_order_relaxed);
+    while ((long long)magnitude > max && !histogram->max.compare_exchange_weak(max, (long long)magnitude, std::memory_order_relaxed)) {
+    }
+}
+
+//FUNCTION: histogramPercentile()
+//PARAMETERS: const Histogram* histogram, double fraction - the histogram and the percentile wanted as a fraction
+//DESCRIPTION: finds the bucket holding the nearest rank value and returns the middle of its range, or the largest value recorded if that
+// is smaller
+//RETURNS: long long - the value, 0 if nothing was recorded
+long long histogramPercentile(const Histogram* histogram, double fraction) {
+    long long total = histogram->total.load(std::memory_order_relaxed);
+    long long rank = (long long)ceil(fraction * total);
+    long long seen = 0;
+    for (int bucket = 0; bucket < HISTOGRAM_BUCKETS && total > 0; ++bucket) {
+        seen += histogram->counts[bucket].load(std::memory_order_relaxed);
+        if (seen >= rank) {
+            if (bucket < (1 << HISTOGRAM_SUB_BITS)) {
+                return bucket;
+            }
+            int shift = (bucket >> HISTOGRAM_SUB_BITS) - 1;
+            long long low = (long long)((bucket & ((1 << HISTOGRAM_SUB_BITS) - 1)) + (1 << HISTOGRAM_SUB_BITS)) << shift;
+            long long middle = low + ((1LL << shift) >> 1);
+            long long max = histogram->max.load(std::memory_order_relaxed);
+            return (middle < max) ? middle : max;
+        }
+    }
+    return 0;
+}
+
+//FUNCTION: recordDepth()
+//PARAMETERS: int countryId, int depth - the country a node was inserted into and its level, 1 for the root
+//DESCRIPTION: keeps the deepest level insertBST() has reached in each country
+//RETURNS: void
+void recordDepth(int countryId, int depth) {
+    std::atomic<int>* deepest = &deepestInsert[(countryId < MAX_DEPTH_COUNTRIES) ? countryId : MAX_DEPTH_COUNTRIES - 1];
+    int current = deepest->load(std::memory_order_relaxed);
+    while (depth > current && !deepest->compare_exchange_weak(current, depth, std::memory_order_relaxed)) {
+    }
+}
+
+//FUNCTION: dumpStats()
+//PARAMETERS: FILE* file - where to print
+//DESCRIPTION: prints the calls, mean, percentiles and worst latency of every instrumented function that has run, with the nodes each call
+// visited, then the deepest insert of every country. it only reads atomics and the published dictionary, so the menu, the exit and a
+// SIGUSR1 from outside can all call it while queries or --follow are running
+//RETURNS: void
+void dumpStats(FILE* file) {
+    int reader = registerReader();
+    if (reader >= 0) {
+        beginRead(NULL, reader);
+    }
+    fprintf(file, "%-32s %10s %10s %10s %10s %10s %12s %8s %8s %8s\n", "Instrumented function", "calls", "mean ns", "p50 ns", "p99 ns",
+        "p99.9 ns", "max ns", "nodes50", "nodes99", "nodesmax");
+    for (int probe = 0; probe < PROBE_COUNT; ++probe) {
+        const Probe* stats = &probes[probe];
+        long long calls = stats->nanoseconds.total.load(std::memory_order_relaxed);
+        if (calls == 0) {
+            continue;
+        }
+        fprintf(file, "%-32s %10lld %10lld %10lld %10lld %10lld %12lld %8lld %8lld %8lld\n", probeNames[probe], calls,
+            stats->nanoseconds.sum.load(std::memory_order_relaxed) / calls, histogramPercentile(&stats->nanoseconds, 0.50),
+            histogramPercentile(&stats->nanoseconds, 0.99), histogramPercentile(&stats->nanoseconds, 0.999),
+            stats->nanoseconds.max.load(std::memory_order_relaxed), histogramPercentile(&stats->visits, 0.50),
+            histogramPercentile(&stats->visits, 0.99), stats->visits.max.load(std::memory_order_relaxed));
+    }
+    const CountryDictionary* dictionary = readDictionary();
+    fprintf(file, "Deepest insert per country, the root is 1:\n");
+    int printed = 0;
+    for (int id = 0; id < dictionary->count && id < MAX_DEPTH_COUNTRIES; ++id) {
+        int depth = deepestInsert[id].load(std::memory_order_relaxed);
+        if (depth > 0) {
+            fprintf(file, "  %-22s %3d%s", dictionary->names[id], depth, (++printed % 4 == 0) ? "\n" : "");
+        }
+    }
+    fprintf(file, (printed % 4 == 0) ? "" : "\n");
+    fflush(file);
+    if (reader >= 0) {
+        endRead(reader);
+        releaseReader(reader);
+    }
+}
+
+//FUNCTION: blockDumpSignal()
+//PARAMETERS: none
+//DESCRIPTION: blocks SIGUSR1 in the main thread before any other thread starts, so every thread inherits the mask and the signal waits
+// for the stats thread instead of killing the program. nothing to do on Windows, which has no SIGUSR1
+//RETURNS: void
+void blockDumpSignal(void) {
+#ifndef _WIN32
+    sigset_t signals;
+    sigemptyset(&signals);
+    sigaddset(&signals, SIGUSR1);
+    pthread_sigmask(SIG_BLOCK, &signals, NULL);
+#endif
+}
+
+//FUNCTION: startStatsThread()
+//PARAMETERS: none
+//DESCRIPTION: starts the thread that dumps the instrumentation to stderr whenever the program gets SIGUSR1
+//RETURNS: void
+void startStatsThread(void) {
+#ifndef _WIN32
+    statsStop.store(0);
+    statsThread = std::thread(waitForDumpSignal);
+#endif
+}
+
+//FUNCTION: stopStatsThread()
+//PARAMETERS: none
+//DESCRIPTION: wakes the stats thread with its own signal after telling it to stop, and joins it
+//RETURNS: void
+void stopStatsThread(void) {
+#ifndef _WIN32
+    statsStop.store(1);
+    pthread_kill(statsThread.native_handle(), SIGUSR1);
+    statsThread.join();
+#endif
+}
+
+//FUNCTION: waitForDumpSignal()
+//PARAMETERS: none
+//DESCRIPTION: the stats thread. waits for SIGUSR1 with sigwait(), which runs nothing in a signal handler, and dumps the instrumentation
+// each time until told to stop
+//RETURNS: void
+void waitForDumpSignal(void) {
+#ifndef _WIN32
+    sigset_t signals;
+    sigemptyset(&signals);
+    sigaddset(&signals, SIGUSR1);
+    int signal = 0;
+    while (sigwait(&signals, &signal) == 0 && !statsStop.load()) {
+        dumpStats(stderr);
+    }
+#endif
+}
+#endif
+
+/* Cleanup memory */
+//FUNCTION: cleanup()
+//PARAMETERS: HashTable* hashTable
+//DESCRIPTION: frees the dynamically allocated space from the hash table. every parcel and node of a country was allocated from the country's
+// arena, so releasing the arena's slabs frees the whole bst at once without visiting each node. the hash nodes themselves are freed last
+//RETURNS: void
+void cleanup(HashTable* hashTable) {
+    for (int i = 0; i < hashTable->capacity; ++i) {
+        arenaRelease(&hashTable->nodes[i].arena);
+    }
+    free(hashTable->nodes);
+    hashTable->nodes = NULL;
+    hashTable->capacity = 0;
+}
+
+
+//FUNCTION: traverseAndAddBST()
+//PARAMETERS: BSTNode* node, long long& totalWeight, long long& totalValuation - the root of the bst being searched, a variable for total weight
+// and valuation in cents
+//DESCRIPTION: searches the tree with in-order traversal. it visits every node of the bst, accesses the parcel node, and adds the value of the weight
+// and valuation of that parcel to the total variables. used by the calculateTotalLoadAndValuation() function
+//RETURNS: void - variables are passed by reference and directly altered
+void traverseAndAddBST(BSTNode* node, long long& totalWeight, long long& totalValuation) {
+    WeightCursor cursor;
+    openTreeCursor(&cursor, node, CURSOR_IN_ORDER);
+    for (BSTNode* next = nextTreeCursor(&cursor); next != NULL; next = nextTreeCursor(&cursor)) {
+        totalWeight += next->parcel->weight;
+        totalValuation += next->parcel->valuation;
+    }
+    closeTreeCursor(&cursor);
+}
+
+/* Column store engine */
+//FUNCTION: buildColumnStore()
+//PARAMETERS: HashTable* hashTable - the loaded table
+//DESCRIPTION: counts each country's parcels to lay out the offsets, then copies every tree into the columns with an in-order traversal so each
+// country's rows come out sorted by weight, in the same order printParcels() prints them. the price order is sorted from the columns last.
+// the store is a read-only copy for query heavy use, the trees are left as they are
+//RETURNS: ColumnStore* - the new column store
+ColumnStore* buildColumnStore(HashTable* hashTable) {
+    ColumnStore* store = (ColumnStore*)countedMalloc(sizeof(ColumnStore));
+    int countries = countryDictionary.count;
+    if (store == NULL) {
+        perror("Unable to allocate memory for column store");
+        exit(1);
+    }
+    store->countryCount = countries;
+    store->offsets = (int*)countedMalloc((countries + 1) * sizeof(int));
+    if (store->offsets == NULL) {
+        perror("Unable to allocate memory for column store");
+        exit(1);
+    }
+    store->offsets[0] = 0;
+    for (int id = 0; id < countries; ++id) {
+        store->offsets[id + 1] = store->offsets[id] + countBST(countryNode(hashTable, id)->root);
+    }
+    store->parcelCount = store->offsets[countries];
+    size_t rows = (store->parcelCount > 0) ? (size_t)store->parcelCount : 1;
+    store->weights = (int*)countedMalloc(rows * sizeof(int));
+    store->valuations = (int*)countedMalloc(rows * sizeof(int));
+    store->countryIds = (int*)countedMalloc(rows * sizeof(int));
+    store->priceOrder = (int*)countedMalloc(rows * sizeof(int));
+    store->isMapped = 0;
+    if (store->weights == NULL || store->valuations == NULL || store->countryIds == NULL || store->priceOrder == NULL) {
+        perror("Unable to allocate memory for column store");
+        exit(1);
+    }
+    for (int id = 0; id < countries; ++id) {
+        int row = store->offsets[id];
+        fillColumns(countryNode(hashTable, id)->root, store, row);
+    }
+    buildPriceOrder(store);
+    return store;
+}
+
+//FUNCTION: buildPriceOrder()
+//PARAMETERS: ColumnStore* store - a store whose columns are filled in
+//DESCRIPTION: sorts each country's rows by valuation into the price order, the column store's version of a valuation index. rows of equal
+// valuation stay in weight order, the same as buildPriceIndex()
+//RETURNS: void
+void buildPriceOrder(ColumnStore* store) {
+    size_t rows = (store->parcelCount > 0) ? (size_t)store->parcelCount : 1;
+    PricedRow* priced = (PricedRow*)countedMalloc(rows * sizeof(PricedRow));
+    if (priced == NULL) {
+        perror("Unable to allocate memory for column store");
+        exit(1);
+    }
+    for (int row = 0; row < store->parcelCount; ++row) {
+        priced[row].valuation = store->valuations[row];
+        priced[row].row = row;
+    }
+    for (int id = 0; id < store->countryCount; ++id) {
+        int begin = store->offsets[id];
+        qsort(priced + begin, store->offsets[id + 1] - begin, sizeof(PricedRow), comparePricedRows);
+    }
+    for (int row = 0; row < store->parcelCount; ++row) {
+        store->priceOrder[row] = priced[row].row;
+    }
+    free(priced);
+}
+
+//FUNCTION: comparePricedRows()
+//PARAMETERS: const void* first, const void* second - two PricedRows
+//DESCRIPTION: qsort() comparison by valuation, then by row
+//RETURNS: int - negative, zero or positive like strcmp()
+int comparePricedRows(const void* first, const void* second) {
+    const PricedRow* a = (const PricedRow*)first;
+    const PricedRow* b = (const PricedRow*)second;
+    if (a->valuation != b->valuation) {
+        return (a->valuation < b->valuation) ? -1 : 1;
+    }
+    return a->row - b->row;
+}
+
+//FUNCTION: fillColumns()
+//PARAMETERS: BSTNode* root, ColumnStore* store, int& row - the tree to copy, the store and the next row to write
+//DESCRIPTION: in-order traversal that writes each parcel into the next row of the columns
+//RETURNS: void - row is passed by reference and ends one past the last row written
+void fillColumns(BSTNode* root, ColumnStore* store, int& row) {
+    WeightCursor cursor;
+    openTreeCursor(&cursor, root, CURSOR_IN_ORDER);
+    for (BSTNode* node = nextTreeCursor(&cursor); node != NULL; node = nextTreeCursor(&cursor)) {
+        store->weights[row] = node->parcel->weight;
+        store->valuations[row] = node->parcel->valuation;
+        store->countryIds[row] = node->parcel->countryId;
+        row++;
+    }
+    closeTreeCursor(&cursor);
+}
+
+//FUNCTION: countBST()
+//PARAMETERS: BSTNode* root - a tree
+//DESCRIPTION: counts the nodes in the tree by walking it, without trusting the subtree counts
+//RETURNS: int - the number of parcels
+int countBST(BSTNode* root) {
+    WeightCursor cursor;
+    openTreeCursor(&cursor, root, CURSOR_PRE_ORDER);
+    int count = 0;
+    while (nextTreeCursor(&cursor) != NULL) {
+        count++;
+    }
+    closeTreeCursor(&cursor);
+    return count;
+}
+
+//FUNCTION: releaseColumnStore()
+//PARAMETERS: ColumnStore* store - the store to free, NULL is ignored
+//DESCRIPTION: frees the columns and the store. columns that point into a snapshot image are left for unmapFile()
+//RETURNS: void
+void releaseColumnStore(ColumnStore* store) {
+    if (store == NULL) {
+        return;
+    }
+    if (!store->isMapped) {
+        free(store->weights);
+        free(store->valuations);
+        free(store->countryIds);
+        free(store->offsets);
+        free(store->priceOrder);
+    }
+    free(store);
+}
+
+//FUNCTION: findCountryColumns()
+//PARAMETERS: const char* country, const ColumnStore* store, int* begin, int* end - the country typed by the user, the store, and the range
+// of rows that receives the country's parcels
+//DESCRIPTION: resolves the name through the country index and looks up its range in the offsets
+//RETURNS: int - 1 if the country has parcels in the store, 0 if not
+int findCountryColumns(const char* country, const ColumnStore* store, int* begin, int* end) {
+    int countryId = findCountry(country);
+    if (countryId == NO_COUNTRY || countryId >= store->countryCount) {
+        return 0;
     }
+    *begin = store->offsets[countryId];
+    *end = store->offsets[countryId + 1];
+    return *end > *begin;
+}
 
-    findHighestPrice(root->left, expensiveParcel); //traverse through the whole bst
-    findHighestPrice(root->right, expensiveParcel);
+//FUNCTION: printColumnRows()
+//PARAMETERS: const ColumnStore* store, int begin, int end - the store and the range of rows to print
+//DESCRIPTION: prints the rows in the same format as printParcels()
+//RETURNS: void
+void printColumnRows(const ColumnStore* store, int begin, int end) {
+    COUNT_VISITS(end - begin);
+    for (int row = begin; row < end; ++row) {
+        writeParcel(store->countryIds[row], store->weights[row], store->valuations[row]);
+    }
+    flushAllOutput();
 }
 
-/* Display the lightest and heaviest parcels */
-//FUNCTION: displayLightestAndHeaviest()
-//PARAMETERS: const char* country, HashNode* hashTable - country being calculated and hashtable to get the country info from
-//DESCRIPTION: takes the root index and visits the leftmost side of the bst to find the lowest weighted parcel, the visits the rightmost side
-// of the bst to find the heaviest. it prints the information of the parcel for these lowets and highest parcels.
-//RETURNS: void
-void displayLightestAndHeaviest(const char* country, HashNode* hashTable) {
-    unsigned long index = computeHash(country);
-    BSTNode* root = hashTable[index].root;
-    BSTNode* rootCopy = hashTable[index].root;
-    if (root == NULL) {
+//FUNCTION: lowerBoundColumns()
+//PARAMETERS: const ColumnStore* store, int begin, int end, int weight - a country's range of rows and the weight to search for
+//DESCRIPTION: binary search over the weight sorted rows
+//RETURNS: int - the first row in the range whose weight is not less than weight, end if there is none
+int lowerBoundColumns(const ColumnStore* store, int begin, int end, int weight) {
+    while (begin < end) {
+        int middle = begin + (end - begin) / 2;
+        COUNT_VISITS(1);
+        if (store->weights[middle] < weight) {
+            begin = middle + 1;
+        }
+        else {
+            end = middle;
+        }
+    }
+    return begin;
+}
+
+//FUNCTION: upperBoundColumns()
+//PARAMETERS: const ColumnStore* store, int begin, int end, int weight - a country's range of rows and the weight to search for
+//DESCRIPTION: binary search over the weight sorted rows
+//RETURNS: int - the first row in the range whose weight is greater than weight, end if there is none
+int upperBoundColumns(const ColumnStore* store, int begin, int end, int weight) {
+    while (begin < end) {
+        int middle = begin + (end - begin) / 2;
+        COUNT_VISITS(1);
+        if (store->weights[middle] <= weight) {
+            begin = middle + 1;
+        }
+        else {
+            end = middle;
+        }
+    }
+    return begin;
+}
+
+//FUNCTION: sumColumns()
+//PARAMETERS: const ColumnStore* store, int begin, int end, ParcelTotals* totals - the rows to add up and the totals they are added to
+//DESCRIPTION: the column store version of sumWeightRange(), a straight pass over two contiguous columns with the widest sum kernel the CPU
+// has
+//RETURNS: void
+void sumColumns(const ColumnStore* store, int begin, int end, ParcelTotals* totals) {
+    COUNT_VISITS(end - begin);
+    if (begin < end) {
+        columnKernels->sum(store->weights + begin, store->valuations + begin, end - begin, totals);
+    }
+}
+
+//FUNCTION: searchByCountryColumns()
+//PARAMETERS: const char* country, const ColumnStore* store - the country to search and the column store
+//DESCRIPTION: the column store version of searchByCountry(), prints the country's range of rows
+//RETURNS: void
+void searchByCountryColumns(const char* country, const ColumnStore* store) {
+    PROBE(PROBE_BY_COUNTRY);
+    int begin = 0;
+    int end = 0;
+    if (!findCountryColumns(country, store, &begin, &end)) {
+        printf("No country found for entered country: %s\n", country);
+        return;
+    }
+    printColumnRows(store, begin, end);
+}
+
+//FUNCTION: searchByWeightColumns()
+//PARAMETERS: const char* country, int weight, int higher, const ColumnStore* store - same as searchByWeight()
+//DESCRIPTION: the column store version of searchByWeight(), a one sided searchByWeightRangeColumns()
+//RETURNS: void
+void searchByWeightColumns(const char* country, int weight, int higher, const ColumnStore* store) {
+    PROBE(PROBE_BY_WEIGHT);
+    int begin = 0;
+    int end = 0;
+    if (!findCountryColumns(country, store, &begin, &end)) {
         printf("No parcels found for country %s\n", country);
         return;
     }
-    while (root->left != NULL) {
-        root = root->left;
+    if (higher) {
+        printColumnRows(store, upperBoundColumns(store, begin, end, weight), end);
     }
-    printf("Lightest Parcel - Destination: %s, Weight: %d, Valuation: %.2f\n",
-        root->parcel->destination, root->parcel->weight, root->parcel->valuation);
-    root = rootCopy;
-    while (root->right != NULL) {
-        root = root->right;
+    else {
+        printColumnRows(store, begin, lowerBoundColumns(store, begin, end, weight));
     }
+}
 
-    printf("Heaviest Parcel - Destination: %s, Weight: %d, Valuation: %.2f\n",
-        root->parcel->destination, root->parcel->weight, root->parcel->valuation);
+//FUNCTION: searchByWeightRangeColumns()
+//PARAMETERS: const char* country, int minWeight, int maxWeight, int countOnly, const ColumnStore* store - same as searchByWeightRange()
+//DESCRIPTION: the column store version of searchByWeightRange(). two binary searches give the rows in the range, so the count is just their
+// difference
+//RETURNS: void
+void searchByWeightRangeColumns(const char* country, int minWeight, int maxWeight, int countOnly, const ColumnStore* store) {
+    PROBE(PROBE_WEIGHT_RANGE);
+    int begin = 0;
+    int end = 0;
+    if (!findCountryColumns(country, store, &begin, &end)) {
+        printf("No parcels found for country %s\n", country);
+        return;
+    }
+    int first = lowerBoundColumns(store, begin, end, minWeight);
+    int last = upperBoundColumns(store, first, end, maxWeight);
+    if (countOnly) {
+        printf("Parcels between %d and %d grams: %d\n", minWeight, maxWeight, last - first);
+    }
+    else {
+        printColumnRows(store, first, last);
+    }
 }
 
-/* Cleanup memory */
-//FUNCTION: cleanup()
-//PARAMETERS: HashNode* hashTable
-//DESCRIPTION: frees the dynamically allocated space from the hash table, it sends each index of the table to the function freeBST() which
-// traverses the entire bst to ensure each node is freed
+//FUNCTION: calculateTotalLoadAndValuationColumns()
+//PARAMETERS: const char* country, const ColumnStore* store - country being calculated and the column store
+//DESCRIPTION: the column store version of calculateTotalLoadAndValuation()
 //RETURNS: void
-void cleanup(HashNode* hashTable) {
-    for (int i = 0; i < TABLE_SIZE; ++i) {
-        if (hashTable[i].root != NULL) {
-            freeBST(hashTable[i].root); //free the BST rooted at this hash table entry
-        }
+void calculateTotalLoadAndValuationColumns(const char* country, const ColumnStore* store) {
+    PROBE(PROBE_TOTALS);
+    int begin = 0;
+    int end = 0;
+    if (!findCountryColumns(country, store, &begin, &end)) {
+        printf("No parcels found for country %s\n", country);
+        return;
     }
+    ParcelTotals totals;
+    clearTotals(&totals);
+    sumColumns(store, begin, end, &totals);
+    printf("Total Load: %lld grams, Total Valuation: $" CENTS "\n", totals.weight, DOLLARS(totals.valuation));
 }
 
-//FUNCTION: freeBST()
-//PARAMETERS: BSTNode* root - root of the country's bst to be freed
-//DESCRIPTION: called from the cleanup function, traverses the entire root of the hashtable index. using post order traversal. visits the left then right
-// subtree before deleting the node, it ensures the dynamically allocated space from the parcel node (destination) and bst node (parcel) is also freed, 
-// before freeing the actual node of the hash table itself.
+//FUNCTION: calculateWeightRangeTotalsColumns()
+//PARAMETERS: const char* country, int minWeight, int maxWeight, const ColumnStore* store - same as calculateWeightRangeTotals()
+//DESCRIPTION: the column store version of calculateWeightRangeTotals(), binary searches for the rows in the range and adds them up
 //RETURNS: void
-void freeBST(BSTNode* root) {
-    if (root != NULL) {
-        freeBST(root->left);
-        freeBST(root->right);
-        free(root->parcel->destination);
-        free(root->parcel);
-        free(root);
+void calculateWeightRangeTotalsColumns(const char* country, int minWeight, int maxWeight, const ColumnStore* store) {
+    PROBE(PROBE_RANGE_TOTALS);
+    int begin = 0;
+    int end = 0;
+    if (!findCountryColumns(country, store, &begin, &end)) {
+        printf("No parcels found for country %s\n", country);
+        return;
     }
+    int first = lowerBoundColumns(store, begin, end, minWeight);
+    ParcelTotals totals;
+    clearTotals(&totals);
+    sumColumns(store, first, upperBoundColumns(store, first, end, maxWeight), &totals);
+    printRangeTotals(minWeight, maxWeight, &totals);
 }
 
+//FUNCTION: displayCheapestAndMostExpensiveColumns()
+//PARAMETERS: const char* country, const ColumnStore* store - country being calculated and the column store
+//DESCRIPTION: the column store version of displayCheapestAndMostExpensive(), the cheapest parcel is the first row of the country's price
+// order and the most expensive the last. the price order keeps equal valuations in weight order, so ties go the same way as on the tree
+// engine: the first cheapest and the last most expensive
+//RETURNS: void
+void displayCheapestAndMostExpensiveColumns(const char* country, const ColumnStore* store) {
+    PROBE(PROBE_PRICE_EXTREMES);
+    int begin = 0;
+    int end = 0;
+    if (!findCountryColumns(country, store, &begin, &end)) {
+        printf("No parcels found for country %s\n", country);
+        return;
+    }
+    int cheapest = store->priceOrder[begin];
+    int expensive = store->priceOrder[end - 1];
+    printf("Cheapest Parcel - Destination: %s, Weight: %d, Valuation: " CENTS "\n",
+        countryName(store->countryIds[cheapest]), store->weights[cheapest], DOLLARS(store->valuations[cheapest]));
+    printf("Most Expensive Parcel - Destination: %s, Weight: %d, Valuation: " CENTS "\n",
+        countryName(store->countryIds[expensive]), store->weights[expensive], DOLLARS(store->valuations[expensive]));
+}
 
-//FUNCTION: traverseAndAddBST()
-//PARAMETERS: BSTNode* node, int& totalWeight, float& totalValuation - the root of the bst being searched, a variable for total weight and valuation
-//DESCRIPTION: searches the tree with in-order traversal. it visits every node of the bst, accesses the parcel node, and adds the value of the weight
-// and valuation of that parcel to the total variables. used by the calculateTotalLoadAndValuation() function
-//RETURNS: void - variables are passed by reference and directly altered
-void traverseAndAddBST(BSTNode* node, int& totalWeight, float& totalValuation) {
-    if (node == NULL) {
+//FUNCTION: displayLightestAndHeaviestColumns()
+//PARAMETERS: const char* country, const ColumnStore* store - country being calculated and the column store
+//DESCRIPTION: the column store version of displayLightestAndHeaviest(), the lightest parcel is the first row of the country's range and the
+// heaviest the last
+//RETURNS: void
+void displayLightestAndHeaviestColumns(const char* country, const ColumnStore* store) {
+    PROBE(PROBE_WEIGHT_EXTREMES);
+    int begin = 0;
+    int end = 0;
+    if (!findCountryColumns(country, store, &begin, &end)) {
+        printf("No parcels found for country %s\n", country);
         return;
     }
-    //traverse the left subtree
-    traverseAndAddBST(node->left, totalWeight, totalValuation);
-    //visit the current node
-    totalWeight += node->parcel->weight;
-    totalValuation += node->parcel->valuation;
-    //traverse the right subtree
-    traverseAndAddBST(node->right, totalWeight, totalValuation);
-}
\ No newline at end of file
+    printf("Lightest Parcel - Destination: %s, Weight: %d, Valuation: " CENTS "\n",
+        countryName(store->countryIds[begin]), store->weights[begin], DOLLARS(store->valuations[begin]));
+    printf("Heaviest Parcel - Destination: %s, Weight: %d, Valuation: " CENTS "\n",
+        countryName(store->countryIds[end - 1]), store->weights[end - 1], DOLLARS(store->valuations[end - 1]));
+}
+
+//FUNCTION: lowerBoundPriceOrder()
+//PARAMETERS: const ColumnStore* store, int begin, int end, int valuation - a country's range of the price order and the valuation to search for
+//DESCRIPTION: binary search over the price order
+//RETURNS: int - the first place in the range whose row is valued at least valuation, end if there is none
+int lowerBoundPriceOrder(const ColumnStore* store, int begin, int end, int valuation) {
+    while (begin < end) {
+        int middle = begin + (end - begin) / 2;
+        COUNT_VISITS(1);
+        if (store->valuations[store->priceOrder[middle]] < valuation) {
+            begin = middle + 1;
+        }
+        else {
+            end = middle;
+        }
+    }
+    return begin;
+}
+
+//FUNCTION: displayTopPricesColumns()
+//PARAMETERS: const char* country, int count, int cheapestFirst, const ColumnStore* store - same as displayTopPrices()
+//DESCRIPTION: the column store version of displayTopPrices(), prints the first or last K places of the country's price order
+//RETURNS: void
+void displayTopPricesColumns(const char* country, int count, int cheapestFirst, const ColumnStore* store) {
+    PROBE(PROBE_TOP_PRICES);
+    int begin = 0;
+    int end = 0;
+    if (!findCountryColumns(country, store, &begin, &end)) {
+        printf("No parcels found for country %s\n", country);
+        return;
+    }
+    if (count > end - begin) {
+        count = end - begin;
+    }
+    for (int i = 0; i < count; ++i) {
+        int row = cheapestFirst ? store->priceOrder[begin + i] : store->priceOrder[end - 1 - i];
+        printColumnRows(store, row, row + 1);
+    }
+}
+
+//FUNCTION: searchByPriceColumns()
+//PARAMETERS: const char* country, int minValuation, int maxValuation, const ColumnStore* store - same as searchByPrice()
+//DESCRIPTION: the column store version of searchByPrice(), a binary search finds where the range starts in the price order
+//RETURNS: void
+void searchByPriceColumns(const char* country, int minValuation, int maxValuation, const ColumnStore* store) {
+    PROBE(PROBE_PRICE_RANGE);
+    int begin = 0;
+    int end = 0;
+    if (!findCountryColumns(country, store, &begin, &end)) {
+        printf("No parcels found for country %s\n", country);
+        return;
+    }
+    for (int i = lowerBoundPriceOrder(store, begin, end, minValuation); i < end; ++i) {
+        int row = store->priceOrder[i];
+        if (store->valuations[row] > maxValuation) {
+            break;
+        }
+        printColumnRows(store, row, row + 1);
+    }
+}
+
+/* Column kernels */
+// every version of the kernels, scalar first. the SIMD ones are compiled for their instruction set function by function, so the rest of the
+// program still runs on any CPU and selectColumnKernels() only picks what this one supports
+const ColumnKernels kernelSets[] = {
+    { "scalar", KERNEL_SCALAR, sumKernelScalar, extremesKernelScalar, filterKernelScalar },
+#ifdef COLUMN_KERNELS_X86
+    { "sse4.1", KERNEL_SSE41, sumKernelSse41, extremesKernelSse41, filterKernelSse41 },
+    { "avx2", KERNEL_AVX2, sumKernelAvx2, extremesKernelAvx2, filterKernelAvx2 },
+#endif
+};
+#define KERNEL_SETS ((int)(sizeof(kernelSets) / sizeof(kernelSets[0])))
+
+//FUNCTION: selectColumnKernels()
+//PARAMETERS: void
+//DESCRIPTION: points columnKernels at the widest kernels this CPU can run. called once at startup, before any thread reads the column store
+//RETURNS: void
+void selectColumnKernels(void) {
+    int level = cpuKernelLevel();
+    columnKernels = &kernelSets[0];
+    for (int i = 0; i < KERNEL_SETS; ++i) {
+        if (kernelSets[i].level <= level) {
+            columnKernels = &kernelSets[i];
+        }
+    }
+}
+
+//FUNCTION: cpuKernelLevel()
+//PARAMETERS: void
+//DESCRIPTION: asks the CPU which of the SIMD instruction sets the kernels use it has
+//RETURNS: int - the highest KERNEL_ level it can run, KERNEL_SCALAR on anything that isn't x86 or wasn't built with GCC or Clang
+int cpuKernelLevel(void) {
+#ifdef COLUMN_KERNELS_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        return KERNEL_AVX2;
+    }
+    if (__builtin_cpu_supports("sse4.1")) {
+        return KERNEL_SSE41;
+    }
+#endif
+    return KERNEL_SCALAR;
+}
+
+//FUNCTION: sumKernelScalar()
+//PARAMETERS: const int* weights, const int* valuations, int count, ParcelTotals* totals - the rows to add up and the totals they are
+// added to
+//DESCRIPTION: adds the count, weights and valuations of the rows to totals and widens its price range to take them in, one row at a time
+//RETURNS: void
+void sumKernelScalar(const int* weights, const int* valuations, int count, ParcelTotals* totals) {
+    for (int row = 0; row < count; ++row) {
+        int valuation = valuations[row];
+        totals->weight += weights[row];
+        totals->valuation += valuation;
+        if (valuation < totals->minValuation) {
+            totals->minValuation = valuation;
+        }
+        if (valuation > totals->maxValuation) {
+            totals->maxValuation = valuation;
+        }
+    }
+    totals->count += count;
+}
+
+//FUNCTION: extremesKernelScalar()
+//PARAMETERS: const int* valuations, int count, int* cheapest, int* priciest - at least one valuation and where to put the two rows
+//DESCRIPTION: finds the first row with the lowest valuation and the last row with the highest, the same two rows the ends of the price
+// order hold
+//RETURNS: void
+void extremesKernelScalar(const int* valuations, int count, int* cheapest, int* priciest) {
+    int low = 0;
+    int high = 0;
+    for (int row = 1; row < count; ++row) {
+        if (valuations[row] < valuations[low]) {
+            low = row;
+        }
+        if (valuations[row] >= valuations[high]) {
+            high = row;
+        }
+    }
+    *cheapest = low;
+    *priciest = high;
+}
+
+//FUNCTION: filterKernelScalar()
+//PARAMETERS: const int* valuations, int count, int minValuation, int maxValuation, unsigned long long* bitmap - the rows, the
+// inclusive range of valuations and a bitmap of (count + 63) / 64 words
+//DESCRIPTION: sets bit row % 64 of word row / 64 for every row valued in the range and clears the rest, bits past count included
+//RETURNS: int - how many rows are in the range
+int filterKernelScalar(const int* valuations, int count, int minValuation, int maxValuation, unsigned long long* bitmap) {
+    int matches = 0;
+    for (int first = 0; first < count; first += 64) {
+        int rows = (count - first < 64) ? count - first : 64;
+        unsigned long long bits = 0;
+        for (int i = 0; i < rows; ++i) {
+            int valuation = valuations[first + i];
+            unsigned long long hit = (valuation >= minValuation) & (valuation <= maxValuation);
+            bits |= hit << i;
+            matches += (int)hit;
+        }
+        bitmap[first / 64] = bits;
+    }
+    return matches;
+}
+
+#ifdef COLUMN_KERNELS_X86
+//FUNCTION: sumKernelSse41()
+//PARAMETERS: same as sumKernelScalar()
+//DESCRIPTION: sumKernelScalar() four rows at a time. the weights and valuations are widened to 64 bits before they are added, so the lanes
+// can't overflow and the sums come out the same as the scalar ones whatever order they were added in
+//RETURNS: void
+__attribute__((target("sse4.1")))
+void sumKernelSse41(const int* weights, const int* valuations, int count, ParcelTotals* totals) {
+    __m128i weightSum = _mm_setzero_si128();
+    __m128i valuationSum = _mm_setzero_si128();
+    __m128i low = _mm_set1_epi32(totals->minValuation);
+    __m128i high = _mm_set1_epi32(totals->maxValuation);
+    int row = 0;
+    for (; row + 4 <= count; row += 4) {
+        __m128i weight = _mm_loadu_si128((const __m128i*)(weights + row));
+        __m128i valuation = _mm_loadu_si128((const __m128i*)(valuations + row));
+        weightSum = _mm_add_epi64(weightSum, _mm_cvtepi32_epi64(weight));
+        weightSum = _mm_add_epi64(weightSum, _mm_cvtepi32_epi64(_mm_srli_si128(weight, 8)));
+        valuationSum = _mm_add_epi64(valuationSum, _mm_cvtepi32_epi64(valuation));
+        valuationSum = _mm_add_epi64(valuationSum, _mm_cvtepi32_epi64(_mm_srli_si128(valuation, 8)));
+        low = _mm_min_epi32(low, valuation);
+        high = _mm_max_epi32(high, valuation);
+    }
+    long long weightLanes[2];
+    long long valuationLanes[2];
+    int lowLanes[4];
+    int highLanes[4];
+    _mm_storeu_si128((__m128i*)weightLanes, weightSum);
+    _mm_storeu_si128((__m128i*)valuationLanes, valuationSum);
+    _mm_storeu_si128((__m128i*)lowLanes, low);
+    _mm_storeu_si128((__m128i*)highLanes, high);
+    totals->weight += weightLanes[0] + weightLanes[1];
+    totals->valuation += valuationLanes[0] + valuationLanes[1];
+    for (int i = 0; i < 4; ++i) {
+        totals->minValuation = (lowLanes[i] < totals->minValuation) ? lowLanes[i] : totals->minValuation;
+        totals->maxValuation = (highLanes[i] > totals->maxValuation) ? highLanes[i] : totals->maxValuation;
+    }
+    totals->count += row;
+    sumKernelScalar(weights + row, valuations + row, count - row, totals);
+}
+
+//FUNCTION: extremesKernelSse41()
+//PARAMETERS: same as extremesKernelScalar()
+//DESCRIPTION: one pass four rows at a time finds the lowest and highest valuation, then compare masks find the first row equal to the lowest
+// from the front and the last row equal to the highest from the back, which stop early
+//RETURNS: void
+__attribute__((target("sse4.1")))
+void extremesKernelSse41(const int* valuations, int count, int* cheapest, int* priciest) {
+    int whole = count & ~3;
+    __m128i low = _mm_set1_epi32(valuations[0]);
+    __m128i high = low;
+    for (int row = 0; row < whole; row += 4) {
+        __m128i valuation = _mm_loadu_si128((const __m128i*)(valuations + row));
+        low = _mm_min_epi32(low, valuation);
+        high = _mm_max_epi32(high, valuation);
+    }
+    int lowLanes[4];
+    int highLanes[4];
+    _mm_storeu_si128((__m128i*)lowLanes, low);
+    _mm_storeu_si128((__m128i*)highLanes, high);
+    int lowest = lowLanes[0];
+    int highest = highLanes[0];
+    for (int i = 1; i < 4; ++i) {
+        lowest = (lowLanes[i] < lowest) ? lowLanes[i] : lowest;
+        highest = (highLanes[i] > highest) ? highLanes[i] : highest;
+    }
+    for (int row = whole; row < count; ++row) {
+        lowest = (valuations[row] < lowest) ? valuations[row] : lowest;
+        highest = (valuations[row] > highest) ? valuations[row] : highest;
+    }
+    *cheapest = -1;
+    low = _mm_set1_epi32(lowest);
+    for (int row = 0; row < whole && *cheapest < 0; row += 4) {
+        __m128i equal = _mm_cmpeq_epi32(_mm_loadu_si128((const __m128i*)(valuations + row)), low);
+        int mask = _mm_movemask_ps(_mm_castsi128_ps(equal));
+        if (mask != 0) {
+            *cheapest = row + __builtin_ctz(mask);
+        }
+    }
+    for (int row = whole; row < count && *cheapest < 0; ++row) {
+        if (valuations[row] == lowest) {
+            *cheapest = row;
+        }
+    }
+    *priciest = -1;
+    for (int row = count - 1; row >= whole && *priciest < 0; --row) {
+        if (valuations[row] == highest) {
+            *priciest = row;
+        }
+    }
+    high = _mm_set1_epi32(highest);
+    for (int row = whole - 4; row >= 0 && *priciest < 0; row -= 4) {
+        __m128i equal = _mm_cmpeq_epi32(_mm_loadu_si128((const __m128i*)(valuations + row)), high);
+        int mask = _mm_movemask_ps(_mm_castsi128_ps(equal));
+        if (mask != 0) {
+            *priciest = row + 31 - __builtin_clz(mask);
+        }
+    }
+}
+
+//FUNCTION: filterKernelSse41()
+//PARAMETERS: same as filterKernelScalar()
+//DESCRIPTION: filterKernelScalar() four rows at a time, each compare gives four bits of the bitmap. the last partial word is left to the
+// scalar kernel
+//RETURNS: int - how many rows are in the range
+__attribute__((target("sse4.1")))
+int filterKernelSse41(const int* valuations, int count, int minValuation, int maxValuation, unsigned long long* bitmap) {
+    __m128i low = _mm_set1_epi32(minValuation);
+    __m128i high = _mm_set1_epi32(maxValuation);
+    int matches = 0;
+    int first = 0;
+    for (; first + 64 <= count; first += 64) {
+        unsigned long long bits = 0;
+        for (int i = 0; i < 64; i += 4) {
+            __m128i valuation = _mm_loadu_si128((const __m128i*)(valuations + first + i));
+            __m128i outside = _mm_or_si128(_mm_cmpgt_epi32(low, valuation), _mm_cmpgt_epi32(valuation, high));
+            bits |= (unsigned long long)(~_mm_movemask_ps(_mm_castsi128_ps(outside)) & 0xF) << i;
+        }
+        bitmap[first / 64] = bits;
+        matches += __builtin_popcountll(bits);
+    }
+    return matches + filterKernelScalar(valuations + first, count - first, minValuation, maxValuation, bitmap + first / 64);
+}
+
+//FUNCTION: sumKernelAvx2()
+//PARAMETERS: same as sumKernelScalar()
+//DESCRIPTION: sumKernelSse41() eight rows at a time
+//RETURNS: void
+__attribute__((target("avx2")))
+void sumKernelAvx2(const int* weights, const int* valuations, int count, ParcelTotals* totals) {
+    __m256i weightSum = _mm256_setzero_si256();
+    __m256i valuationSum = _mm256_setzero_si256();
+    __m256i low = _mm256_set1_epi32(totals->minValuation);
+    __m256i high = _mm256_set1_epi32(totals->maxValuation);
+    int row = 0;
+    for (; row + 8 <= count; row += 8) {
+        __m256i weight = _mm256_loadu_si256((const __m256i*)(weights + row));
+        __m256i valuation = _mm256_loadu_si256((const __m256i*)(valuations + row));
+        weightSum = _mm256_add_epi64(weightSum, _mm256_cvtepi32_epi64(_mm256_castsi256_si128(weight)));
+        weightSum = _mm256_add_epi64(weightSum, _mm256_cvtepi32_epi64(_mm256_extracti128_si256(weight, 1)));
+        valuationSum = _mm256_add_epi64(valuationSum, _mm256_cvtepi32_epi64(_mm256_castsi256_si128(valuation)));
+        valuationSum = _mm256_add_epi64(valuationSum, _mm256_cvtepi32_epi64(_mm256_extracti128_si256(valuation, 1)));
+        low = _mm256_min_epi32(low, valuation);
+        high = _mm256_max_epi32(high, valuation);
+    }
+    long long weightLanes[4];
+    long long valuationLanes[4];
+    int lowLanes[8];
+    int highLanes[8];
+    _mm256_storeu_si256((__m256i*)weightLanes, weightSum);
+    _mm256_storeu_si256((__m256i*)valuationLanes, valuationSum);
+    _mm256_storeu_si256((__m256i*)lowLanes, low);
+    _mm256_storeu_si256((__m256i*)highLanes, high);
+    totals->weight += weightLanes[0] + weightLanes[1] + weightLanes[2] + weightLanes[3];
+    totals->valuation += valuationLanes[0] + valuationLanes[1] + valuationLanes[2] + valuationLanes[3];
+    for (int i = 0; i < 8; ++i) {
+        totals->minValuation = (lowLanes[i] < totals->minValuation) ? lowLanes[i] : totals->minValuation;
+        totals->maxValuation = (highLanes[i] > totals->maxValuation) ? highLanes[i] : totals->maxValuation;
+    }
+    totals->count += row;
+    _mm256_zeroupper(); //the scalar kernel is SSE code, which stalls on dirty upper halves
+    sumKernelScalar(weights + row, valuations + row, count - row, totals);
+}
+
+//FUNCTION: extremesKernelAvx2()
+//PARAMETERS: same as extremesKernelScalar()
+//DESCRIPTION: extremesKernelSse41() eight rows at a time
+//RETURNS: void
+__attribute__((target("avx2")))
+void extremesKernelAvx2(const int* valuations, int count, int* cheapest, int* priciest) {
+    int whole = count & ~7;
+    __m256i low = _mm256_set1_epi32(valuations[0]);
+    __m256i high = low;
+    for (int row = 0; row < whole; row += 8) {
+        __m256i valuation = _mm256_loadu_si256((const __m256i*)(valuations + row));
+        low = _mm256_min_epi32(low, valuation);
+        high = _mm256_max_epi32(high, valuation);
+    }
+    int lowLanes[8];
+    int highLanes[8];
+    _mm256_storeu_si256((__m256i*)lowLanes, low);
+    _mm256_storeu_si256((__m256i*)highLanes, high);
+    int lowest = lowLanes[0];
+    int highest = highLanes[0];
+    for (int i = 1; i < 8; ++i) {
+        lowest = (lowLanes[i] < lowest) ? lowLanes[i] : lowest;
+        highest = (highLanes[i] > highest) ? highLanes[i] : highest;
+    }
+    for (int row = whole; row < count; ++row) {
+        lowest = (valuations[row] < lowest) ? valuations[row] : lowest;
+        highest = (valuations[row] > highest) ? valuations[row] : highest;
+    }
+    *cheapest = -1;
+    low = _mm256_set1_epi32(lowest);
+    for (int row = 0; row < whole && *cheapest < 0; row += 8) {
+        __m256i equal = _mm256_cmpeq_epi32(_mm256_loadu_si256((const __m256i*)(valuations + row)), low);
+        int mask = _mm256_movemask_ps(_mm256_castsi256_ps(equal));
+        if (mask != 0) {
+            *cheapest = row + __builtin_ctz(mask);
+        }
+    }
+    for (int row = whole; row < count && *cheapest < 0; ++row) {
+        if (valuations[row] == lowest) {
+            *cheapest = row;
+        }
+    }
+    *priciest = -1;
+    for (int row = count - 1; row >= whole && *priciest < 0; --row) {
+        if (valuations[row] == highest) {
+            *priciest = row;
+        }
+    }
+    high = _mm256_set1_epi32(highest);
+    for (int row = whole - 8; row >= 0 && *priciest < 0; row -= 8) {
+        __m256i equal = _mm256_cmpeq_epi32(_mm256_loadu_si256((const __m256i*)(valuations + row)), high);
+        int mask = _mm256_movemask_ps(_mm256_castsi256_ps(equal));
+        if (mask != 0) {
+            *priciest = row + 31 - __builtin_clz(mask);
+        }
+    }
+}
+
+//FUNCTION: filterKernelAvx2()
+//PARAMETERS: same as filterKernelScalar()
+//DESCRIPTION: filterKernelSse41() eight rows at a time
+//RETURNS: int - how many rows are in the range
+__attribute__((target("avx2")))
+int filterKernelAvx2(const int* valuations, int count, int minValuation, int maxValuation, unsigned long long* bitmap) {
+    __m256i low = _mm256_set1_epi32(minValuation);
+    __m256i high = _mm256_set1_epi32(maxValuation);
+    int matches = 0;
+    int first = 0;
+    for (; first + 64 <= count; first += 64) {
+        unsigned long long bits = 0;
+        for (int i = 0; i < 64; i += 8) {
+            __m256i valuation = _mm256_loadu_si256((const __m256i*)(valuations + first + i));
+            __m256i outside = _mm256_or_si256(_mm256_cmpgt_epi32(low, valuation), _mm256_cmpgt_epi32(valuation, high));
+            bits |= (unsigned long long)(~_mm256_movemask_ps(_mm256_castsi256_ps(outside)) & 0xFF) << i;
+        }
+        bitmap[first / 64] = bits;
+        matches += __builtin_popcountll(bits);
+    }
+    _mm256_zeroupper();
+    return matches + filterKernelScalar(valuations + first, count - first, minValuation, maxValuation, bitmap + first / 64);
+}
+#endif
+
+//FUNCTION: benchmarkKernels()
+//PARAMETERS: const ColumnStore* store - the column store
+//DESCRIPTION: runs every version of the kernels this CPU supports over the whole store about KERNEL_BENCH_ROWS rows' worth: the sum over each
+// country's rows, the price extremes and a filter for the middle half of the valid prices over all of them. prints the time and bandwidth of
+// each and checks every version's answers against the scalar ones
+//RETURNS: int - SUCCESS, or ERROR if a version disagreed with the scalar kernels
+int benchmarkKernels(const ColumnStore* store) {
+    int rows = store->parcelCount;
+    int countries = store->countryCount;
+    if (rows == 0) {
+        printf("No parcels to run the kernels over\n");
+        return SUCCESS;
+    }
+    int rounds = KERNEL_BENCH_ROWS / rows;
+    if (rounds < 1) {
+        rounds = 1;
+    }
+    int words = (rows + 63) / 64;
+    int minValuation = (MIN_PRICE + (MAX_PRICE - MIN_PRICE) / 4) * 100;
+    int maxValuation = (MAX_PRICE - (MAX_PRICE - MIN_PRICE) / 4) * 100;
+    ParcelTotals* expected = (ParcelTotals*)countedMalloc(countries * sizeof(ParcelTotals) + 1);
+    ParcelTotals* totals = (ParcelTotals*)countedMalloc(countries * sizeof(ParcelTotals) + 1);
+    unsigned long long* expectedBits = (unsigned long long*)countedMalloc(words * sizeof(unsigned long long));
+    unsigned long long* bits = (unsigned long long*)countedMalloc(words * sizeof(unsigned long long));
+    if (expected == NULL || totals == NULL || expectedBits == NULL || bits == NULL) {
+        perror("Unable to allocate memory for kernel benchmark");
+        exit(1);
+    }
+    int level = cpuKernelLevel();
+    int expectedCheapest = 0;
+    int expectedPriciest = 0;
+    int expectedMatches = 0;
+    int failed = 0;
+    printf("%d rounds over %d parcels, using the %s kernels\n", rounds, rows, columnKernels->name);
+    for (int set = 0; set < KERNEL_SETS && kernelSets[set].level <= level; ++set) {
+        const ColumnKernels* kernels = &kernelSets[set];
+        double seconds[3];
+        double start = nowSeconds();
+        for (int round = 0; round < rounds; ++round) {
+            for (int id = 0; id < countries; ++id) {
+                int begin = store->offsets[id];
+                clearTotals(&totals[id]);
+                kernels->sum(store->weights + begin, store->valuations + begin, store->offsets[id + 1] - begin, &totals[id]);
+            }
+        }
+        seconds[0] = nowSeconds() - start;
+        int cheapest = 0;
+        int priciest = 0;
+        start = nowSeconds();
+        for (int round = 0; round < rounds; ++round) {
+            kernels->extremes(store->valuations, rows, &cheapest, &priciest);
+        }
+        seconds[1] = nowSeconds() - start;
+        int matches = 0;
+        start = nowSeconds();
+        for (int round = 0; round < rounds; ++round) {
+            matches = kernels->filter(store->valuations, rows, minValuation, maxValuation, bits);
+        }
+        seconds[2] = nowSeconds() - start;
+        if (set == 0) {
+            memcpy(expected, totals, countries * sizeof(ParcelTotals));
+            memcpy(expectedBits, bits, words * sizeof(unsigned long long));
+            expectedCheapest = cheapest;
+            expectedPriciest = priciest;
+            expectedMatches = matches;
+        }
+        int wrong = cheapest != expectedCheapest || priciest != expectedPriciest || matches != expectedMatches ||
+            memcmp(bits, expectedBits, words * sizeof(unsigned long long)) != 0;
+        for (int id = 0; id < countries; ++id) {
+            wrong += totals[id].count != expected[id].count || totals[id].weight != expected[id].weight ||
+                totals[id].valuation != expected[id].valuation || totals[id].minValuation != expected[id].minValuation ||
+                totals[id].maxValuation != expected[id].maxValuation;
+        }
+        failed += (wrong > 0) ? 1 : 0;
+        const char* names[] = { "sum", "price extremes", "price filter" };
+        double bytes[] = { (double)rows * 2 * sizeof(int), (double)rows * sizeof(int), (double)rows * sizeof(int) };
+        for (int kernel = 0; kernel < 3; ++kernel) {
+            printf("  %-7s %-15s %9.3f ms per pass  %6.2f GB/s\n", kernels->name, names[kernel], seconds[kernel] * 1000.0 / rounds,
+                bytes[kernel] * rounds / seconds[kernel] / 1e9);
+        }
+        printf("  %-7s %s\n", kernels->name, (wrong > 0) ? "differs from scalar: FAILED" : "matches scalar: passed");
+    }
+    free(expected);
+    free(totals);
+    free(expectedBits);
+    free(bits);
+    return (failed == 0) ? SUCCESS : ERROR;
+}
+
+//FUNCTION: verifyTotals()
+//PARAMETERS: int rows - how many synthetic parcels to add up
+//DESCRIPTION: the --verify-totals self check. generates random parcels TOTALS_BLOCK_ROWS at a time, writes each one as a text row and reads it
+// back with parseRecord(), and keeps the expected totals row by row in 64 bits. every block is summed by the scalar kernel and the selected
+// one, and the block totals are combined front to back and back to front, the way the parallel loaders and reports split the work. all of
+// them have to give the same totals to the cent. also prints what the old int weight and float valuation sums would have come to
+//RETURNS: int - SUCCESS if every total was exact, ERROR if not
+int verifyTotals(int rows) {
+    int blocks = (rows + TOTALS_BLOCK_ROWS - 1) / TOTALS_BLOCK_ROWS;
+    int* weights = (int*)countedMalloc(TOTALS_BLOCK_ROWS * sizeof(int));
+    int* valuations = (int*)countedMalloc(TOTALS_BLOCK_ROWS * sizeof(int));
+    ParcelTotals* blockTotals = (ParcelTotals*)countedMalloc(blocks * sizeof(ParcelTotals));
+    if (weights == NULL || valuations == NULL || blockTotals == NULL) {
+        perror("Unable to allocate memory for totals check");
+        exit(1);
+    }
+    unsigned long long seed = 2463534242ULL;
+    long long expectedWeight = 0;
+    long long expectedValuation = 0;
+    int oldWeight = 0;
+    float oldValuation = 0.0f;
+    int badRows = 0;
+    int badBlocks = 0;
+    char line[64];
+    double start = nowSeconds();
+    for (int block = 0; block < blocks; ++block) {
+        int count = (rows - block * TOTALS_BLOCK_ROWS < TOTALS_BLOCK_ROWS) ? rows - block * TOTALS_BLOCK_ROWS : TOTALS_BLOCK_ROWS;
+        for (int i = 0; i < count; ++i) {
+            int weight = MIN_WEIGHT + (int)(nextRandom(&seed) % (MAX_WEIGHT - MIN_WEIGHT + 1));
+            int valuation = MIN_PRICE * 100 + (int)(nextRandom(&seed) % ((MAX_PRICE - MIN_PRICE) * 100 + 1));
+            memcpy(line, "Synthetic,", 10);
+            char* end = formatInt(line + 10, weight);
+            *end++ = ',';
+            end = formatValuation(end, valuation);
+            *end++ = '\n';
+            ParsedRecord record;
+            int valid = 0;
+            parseRecord(line, end, &record, &valid);
+            if (!valid || record.weight != weight || record.valuation != valuation) {
+                badRows++;
+            }
+            weights[i] = weight;
+            valuations[i] = valuation;
+            expectedWeight += weight;
+            expectedValuation += valuation;
+            oldWeight = (int)((unsigned int)oldWeight + (unsigned int)weight); //wraps the way the old int total did
+            oldValuation += valuation / 100.0f;
+        }
+        ParcelTotals scalar;
+        clearTotals(&scalar);
+        sumKernelScalar(weights, valuations, count, &scalar);
+        clearTotals(&blockTotals[block]);
+        columnKernels->sum(weights, valuations, count, &blockTotals[block]);
+        badBlocks += scalar.count != blockTotals[block].count || scalar.weight != blockTotals[block].weight ||
+            scalar.valuation != blockTotals[block].valuation || scalar.minValuation != blockTotals[block].minValuation ||
+            scalar.maxValuation != blockTotals[block].maxValuation;
+    }
+    ParcelTotals forward;
+    ParcelTotals backward;
+    clearTotals(&forward);
+    clearTotals(&backward);
+    for (int block = 0; block < blocks; ++block) {
+        addTotals(&forward, &blockTotals[block]);
+        addTotals(&backward, &blockTotals[blocks - 1 - block]);
+    }
+    double seconds = nowSeconds() - start;
+    int exact = forward.count == rows && forward.weight == expectedWeight && forward.valuation == expectedValuation &&
+        backward.count == forward.count && backward.weight == forward.weight && backward.valuation == forward.valuation &&
+        backward.minValuation == forward.minValuation && backward.maxValuation == forward.maxValuation;
+    printf("%d synthetic parcels in %d blocks, checked in %.3f s with the %s kernels\n", rows, blocks, seconds, columnKernels->name);
+    printf("  expected              load %lld g, valuation $" CENTS "\n", expectedWeight, DOLLARS(expectedValuation));
+    printf("  blocks front to back  load %lld g, valuation $" CENTS "\n", forward.weight, DOLLARS(forward.valuation));
+    printf("  blocks back to front  load %lld g, valuation $" CENTS "\n", backward.weight, DOLLARS(backward.valuation));
+    printf("  old int/float sums    load %d g, valuation $%.2f, off by %lld g and $" CENTS "\n", oldWeight, (double)oldValuation,
+        (long long)oldWeight - expectedWeight, DOLLARS(llround((double)oldValuation * 100.0) - expectedValuation));
+    printf("%d rows changed going through text, %d blocks differ from the scalar kernel: %s\n", badRows, badBlocks,
+        (exact && badRows == 0 && badBlocks == 0) ? "passed" : "FAILED");
+    free(weights);
+    free(valuations);
+    free(blockTotals);
+    return (exact && badRows == 0 && badBlocks == 0) ? SUCCESS : ERROR;
+}
+
+/* Snapshots */
+//FUNCTION: paddedSize()
+//PARAMETERS: size_t size - the size of a snapshot section
+//DESCRIPTION: rounds the size up to a multiple of 8 so every section starts aligned
+//RETURNS: size_t - the padded size
+size_t paddedSize(size_t size) {
+    return (size + 7) & ~(size_t)7;
+}
+
+//FUNCTION: checksumBytes()
+//PARAMETERS: const char* data, size_t size - the bytes to check
+//DESCRIPTION: FNV-1a style hash taken 8 bytes at a time rather than one, so checking a snapshot of a few million parcels takes milliseconds.
+// it catches a truncated or corrupted file, it isn't meant to stand up to deliberate tampering
+//RETURNS: unsigned long long - the checksum
+unsigned long long checksumBytes(const char* data, size_t size) {
+    unsigned long long hash = 14695981039346656037ULL;
+    size_t i = 0;
+    for (; i + 8 <= size; i += 8) {
+        unsigned long long word;
+        memcpy(&word, data + i, 8);
+        hash = (hash ^ word) * 1099511628211ULL;
+    }
+    for (; i < size; ++i) {
+        hash = (hash ^ (unsigned char)data[i]) * 1099511628211ULL;
+    }
+    return hash;
+}
+
+//FUNCTION: sourceFileInfo()
+//PARAMETERS: const char* filename, long long* size, long long* modified - the text file and where to put its size and modification time
+//DESCRIPTION: stats the file, the two values are what a snapshot remembers to tell whether it is stale. the time is in nanoseconds, so a
+// file rewritten to the same size within the same second still counts as changed. Windows only gives whole seconds
+//RETURNS: int - SUCCESS, or ERROR if the file can't be stat'ed
+int sourceFileInfo(const char* filename, long long* size, long long* modified) {
+    struct stat info;
+    if (stat(filename, &info) != 0) {
+        return ERROR;
+    }
+    *size = (long long)info.st_size;
+#if defined(_WIN32)
+    *modified = (long long)info.st_mtime * 1000000000LL;
+#elif defined(__APPLE__)
+    *modified = (long long)info.st_mtimespec.tv_sec * 1000000000LL + info.st_mtimespec.tv_nsec;
+#else
+    *modified = (long long)info.st_mtim.tv_sec * 1000000000LL + info.st_mtim.tv_nsec;
+#endif
+    return SUCCESS;
+}
+
+//FUNCTION: writeSnapshot()
+//PARAMETERS: const Options* options, const ColumnStore* store - the options the text file was loaded with and the store built from it
+//DESCRIPTION: lays the country names and every column of the store out one after the other in a single buffer, checksums it, and writes it
+// behind a header that records the text file's size and modification time. the file is written under a temporary name and renamed over the
+// old snapshot so a reader never maps a half written one
+//RETURNS: int - SUCCESS, or ERROR if the file couldn't be written
+int writeSnapshot(const Options* options, const ColumnStore* store) {
+    SnapshotHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic));
+    header.version = SNAPSHOT_VERSION;
+    header.headerSize = sizeof(SnapshotHeader);
+    if (sourceFileInfo(options->filename, &header.sourceSize, &header.sourceModified) == ERROR) {
+        return ERROR;
+    }
+    header.maxRows = options->maxRows;
+    header.limits = options->limits;
+    header.countryCount = store->countryCount;
+    header.parcelCount = store->parcelCount;
+    for (int id = 0; id < store->countryCount; ++id) {
+        header.namesSize += countryDictionary.lengths[id] + 1;
+    }
+    size_t rows = (size_t)store->parcelCount;
+    size_t offsetsSize = paddedSize((store->countryCount + 1) * sizeof(int));
+    size_t columnSize = paddedSize(rows * sizeof(int));
+    size_t bodySize = paddedSize(header.namesSize) + offsetsSize + 4 * columnSize;
+    char* body = (char*)countedCalloc(bodySize, 1);
+    if (body == NULL) {
+        perror("Unable to allocate memory for snapshot");
+        exit(1);
+    }
+    char* cursor = body;
+    for (int id = 0; id < store->countryCount; ++id) {
+        memcpy(cursor, countryDictionary.names[id], countryDictionary.lengths[id]);
+        cursor += countryDictionary.lengths[id] + 1;
+    }
+    cursor = body + paddedSize(header.namesSize);
+    memcpy(cursor, store->offsets, (store->countryCount + 1) * sizeof(int));
+    cursor += offsetsSize;
+    memcpy(cursor, store->weights, rows * sizeof(int));
+    cursor += columnSize;
+    memcpy(cursor, store->valuations, rows * sizeof(int));
+    cursor += columnSize;
+    memcpy(cursor, store->countryIds, rows * sizeof(int));
+    cursor += columnSize;
+    memcpy(cursor, store->priceOrder, rows * sizeof(int));
+    header.checksum = checksumBytes(body, bodySize);
+
+    size_t pathLength = strlen(options->snapshotPath);
+    char* temporary = (char*)countedMalloc(pathLength + 5);
+    if (temporary == NULL) {
+        perror("Unable to allocate memory for snapshot");
+        exit(1);
+    }
+    memcpy(temporary, options->snapshotPath, pathLength);
+    memcpy(temporary + pathLength, ".tmp", 5);
+    int result = ERROR;
+    FILE* pFile = fopen(temporary, "wb");
+    if (pFile != NULL) {
+        int written = fwrite(&header, sizeof(header), 1, pFile) == 1 && fwrite(body, 1, bodySize, pFile) == bodySize;
+        if (fclose(pFile) == 0 && written) {
+            remove(options->snapshotPath); //rename() won't replace an existing file on Windows
+            if (rename(temporary, options->snapshotPath) == 0) {
+                result = SUCCESS;
+            }
+        }
+        if (result == ERROR) {
+            remove(temporary);
+        }
+    }
+    free(temporary);
+    free(body);
+    return result;
+}
+
+//FUNCTION: openSnapshot()
+//PARAMETERS: const Options* options, MappedFile* image - the options and the mapping to fill in, which must stay mapped while the store is used
+//DESCRIPTION: maps the snapshot and checks it before using any of it: the magic, version and sizes must match what this build writes, the
+// text file must still have the size and modification time it had when the snapshot was made, the row cap and parcel limits must be the
+// same, and the checksum must match. if all of that holds the country names are put back into the dictionary (in order, so they get the same IDs) and the
+// store's columns point straight into the mapped image, nothing else is copied or rebuilt
+//RETURNS: ColumnStore* - a store backed by the image, or NULL (with the reason printed) if the text file has to be loaded instead
+ColumnStore* openSnapshot(const Options* options, MappedFile* image) {
+    if (mapFile(options->snapshotPath, image) == ERROR) {
+        fprintf(statusOutput, "No snapshot at %s, loading %s\n", options->snapshotPath, options->filename);
+        return NULL;
+    }
+    const char* reason = NULL;
+    SnapshotHeader header;
+    long long sourceSize = 0;
+    long long sourceModified = 0;
+    size_t offsetsSize = 0;
+    size_t columnSize = 0;
+    if (image->size < sizeof(SnapshotHeader)) {
+        reason = "it is too short";
+    }
+    else {
+        memcpy(&header, image->data, sizeof(header));
+        offsetsSize = paddedSize(((size_t)header.countryCount + 1) * sizeof(int));
+        columnSize = paddedSize((size_t)header.parcelCount * sizeof(int));
+        if (memcmp(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic)) != 0 || header.version != SNAPSHOT_VERSION ||
+            header.headerSize != sizeof(SnapshotHeader)) {
+            reason = "it was written by a different version";
+        }
+        else if (sourceFileInfo(options->filename, &sourceSize, &sourceModified) == ERROR || sourceSize != header.sourceSize ||
+            sourceModified != header.sourceModified) {
+            reason = "the text file has changed since";
+        }
+        else if (header.maxRows != options->maxRows) {
+            reason = "it was loaded with a different --max-rows";
+        }
+        else if (header.limits.minWeight != options->limits.minWeight || header.limits.maxWeight != options->limits.maxWeight ||
+            header.limits.minValuation != options->limits.minValuation || header.limits.maxValuation != options->limits.maxValuation) {
+            reason = "it was loaded with different limits";
+        }
+        else if (header.countryCount < 0 || header.parcelCount < 0 || header.namesSize < 0 ||
+            image->size != sizeof(SnapshotHeader) + paddedSize(header.namesSize) + offsetsSize + 4 * columnSize) {
+            reason = "its size is wrong";
+        }
+        else if (checksumBytes(image->data + sizeof(SnapshotHeader), image->size - sizeof(SnapshotHeader)) != header.checksum) {
+            reason = "its checksum doesn't match";
+        }
+    }
+    if (reason != NULL) {
+        fprintf(statusOutput, "Snapshot %s is stale or damaged (%s), loading %s\n", options->snapshotPath, reason, options->filename);
+        unmapFile(image);
+        return NULL;
+    }
+
+    const char* cursor = image->data + sizeof(SnapshotHeader);
+    const char* names = cursor;
+    for (int id = 0; id < header.countryCount; ++id) {
+        int length = (int)strlen(names);
+        internCountry(&countryDictionary, names, length);
+        names += length + 1;
+    }
+    ColumnStore* store = (ColumnStore*)countedMalloc(sizeof(ColumnStore));
+    if (store == NULL) {
+        perror("Unable to allocate memory for column store");
+        exit(1);
+    }
+    cursor += paddedSize(header.namesSize);
+    store->offsets = (int*)cursor;
+    cursor += offsetsSize;
+    store->weights = (int*)cursor;
+    cursor += columnSize;
+    store->valuations = (int*)cursor;
+    cursor += columnSize;
+    store->countryIds = (int*)cursor;
+    cursor += columnSize;
+    store->priceOrder = (int*)cursor;
+    store->countryCount = header.countryCount;
+    store->parcelCount = header.parcelCount;
+    store->isMapped = 1;
+    return store;
+}
+
+/* Engine benchmark */
+//FUNCTION: benchmarkEngines()
+//PARAMETERS: HashTable* hashTable, const ColumnStore* store - the same parcels in both engines
+//DESCRIPTION: times the work behind menu options 3, 4 and 5 for every country on the tree engine and the column store, repeating all the
+// countries until about ENGINE_BENCH_PARCELS parcels have been visited. printing is left out so only the storage is compared
+//RETURNS: void
+void benchmarkEngines(HashTable* hashTable, const ColumnStore* store) {
+    int countries = store->countryCount;
+    int rounds = (store->parcelCount > 0) ? ENGINE_BENCH_PARCELS / store->parcelCount : 1;
+    if (rounds < 1) {
+        rounds = 1;
+    }
+    long long treeChecksum = 0;
+    long long columnChecksum = 0;
+    double seconds[2][3];
+    for (int engine = ENGINE_TREE; engine <= ENGINE_COLUMNS; ++engine) {
+        long long& checksum = (engine == ENGINE_TREE) ? treeChecksum : columnChecksum;
+        double start = nowSeconds();
+        for (int round = 0; round < rounds; ++round) {
+            for (int id = 0; id < countries; ++id) {
+                ParcelTotals totals;
+                clearTotals(&totals);
+                BSTNode* root = countryNode(hashTable, id)->root;
+                if (engine == ENGINE_TREE && root != NULL) {
+                    totals = root->subtree;
+                }
+                else if (engine == ENGINE_COLUMNS) {
+                    sumColumns(store, store->offsets[id], store->offsets[id + 1], &totals);
+                }
+                checksum += totals.weight;
+            }
+        }
+        seconds[engine][0] = nowSeconds() - start;
+        start = nowSeconds();
+        for (int round = 0; round < rounds; ++round) {
+            for (int id = 0; id < countries; ++id) {
+                PriceNode* root = countryNode(hashTable, id)->priceRoot;
+                if (engine == ENGINE_TREE && root != NULL) {
+                    PriceNode* cheapest = root;
+                    PriceNode* expensive = root;
+                    while (cheapest->left != NULL) {
+                        cheapest = cheapest->left;
+                    }
+                    while (expensive->right != NULL) {
+                        expensive = expensive->right;
+                    }
+                    checksum += (long long)(cheapest->valuation + expensive->valuation);
+                }
+                else if (engine == ENGINE_COLUMNS && store->offsets[id + 1] > store->offsets[id]) {
+                    int cheapest = store->priceOrder[store->offsets[id]];
+                    int expensive = store->priceOrder[store->offsets[id + 1] - 1];
+                    checksum += (long long)(store->valuations[cheapest] + store->valuations[expensive]);
+                }
+            }
+        }
+        seconds[engine][1] = nowSeconds() - start;
+        start = nowSeconds();
+        for (int round = 0; round < rounds; ++round) {
+            for (int id = 0; id < countries; ++id) {
+                BSTNode* root = countryNode(hashTable, id)->root;
+                if (engine == ENGINE_TREE && root != NULL) {
+                    BSTNode* lightest = root;
+                    BSTNode* heaviest = root;
+                    while (lightest->left != NULL) {
+                        lightest = lightest->left;
+                    }
+                    while (heaviest->right != NULL) {
+                        heaviest = heaviest->right;
+                    }
+                    checksum += lightest->parcel->weight + heaviest->parcel->weight;
+                }
+                else if (engine == ENGINE_COLUMNS && store->offsets[id + 1] > store->offsets[id]) {
+                    checksum += store->weights[store->offsets[id]] + store->weights[store->offsets[id + 1] - 1];
+                }
+            }
+        }
+        seconds[engine][2] = nowSeconds() - start;
+    }
+    const char* queries[] = { "total load and valuation", "cheapest and most expensive", "lightest and heaviest" };
+    printf("%d rounds over %d countries (checksums %lld/%lld)\n", rounds, countries, treeChecksum, columnChecksum);
+    for (int query = 0; query < 3; ++query) {
+        double parcels = (double)rounds * store->parcelCount;
+        printf("%-28s tree %9.3f ms (%7.1f M parcels/s)   columns %9.3f ms (%7.1f M parcels/s)\n", queries[query],
+            seconds[ENGINE_TREE][query] * 1000.0, parcels / seconds[ENGINE_TREE][query] / 1e6,
+            seconds[ENGINE_COLUMNS][query] * 1000.0, parcels / seconds[ENGINE_COLUMNS][query] / 1e6);
+    }
+}